@@ -4,6 +4,7 @@
 #include <Cabana_Core.hpp>
 #include "psMemberTypeCabana.h"
 #include "cabm_input.hpp"
+#include <ppMemTracker.hpp>
 #include <sstream>
 
 namespace pumipic {
@@ -101,6 +102,7 @@ namespace pumipic {
     using ParticleStructure<DataTypes, MemSpace>::num_rows;
     using ParticleStructure<DataTypes, MemSpace>::ptcl_data;
     using ParticleStructure<DataTypes, MemSpace>::num_types;
+    using ParticleStructure<DataTypes, MemSpace>::migrate_bytes_per_ptcl;
 
     // mappings from row to element gid and back to row
     kkGidView element_to_gid;
@@ -120,6 +122,9 @@ namespace pumipic {
     // extra AoSoA copy for swapping (same size as aosoa_)
     AoSoA_t* aosoa_swap;
 
+    //Reports the live, padding and swap bytes to the memory tracker
+    void trackMemory() const;
+
     //Private constructor for copy()
     CabM() : ParticleStructure<DataTypes, MemSpace>(), policy(100, 1) {}
   };
@@ -182,6 +187,7 @@ namespace pumipic {
       if(!comm_rank) fprintf(stderr, "initializing CabM data\n");
       fillAoSoA(particle_elements, particle_info); // initialize data
     }
+    trackMemory();
   }
 
   template<class DataTypes, typename MemSpace>
@@ -223,12 +229,27 @@ namespace pumipic {
       if(!comm_rank) fprintf(stderr, "initializing CabM data\n");
       fillAoSoA(input.particle_elms, input.p_info); // initialize data
     }
+    trackMemory();
   }
 
   template <class DataTypes, typename MemSpace>
   CabM<DataTypes, MemSpace>::~CabM() {
     delete aosoa_;
     delete aosoa_swap;
+    ReleaseTrackedMemory(this);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  void CabM<DataTypes, MemSpace>::trackMemory() const {
+    if (!isMemoryTracking())
+      return;
+    //Each tuple of the AoSoA also holds the active mask
+    const std::size_t ptcl_bytes = DataTypes::memsize;
+    const std::size_t tuple_bytes = ptcl_bytes + sizeof(bool);
+    const std::size_t live = num_ptcls * ptcl_bytes;
+    SetTrackedMemory(this, name, MEM_LIVE, live);
+    SetTrackedMemory(this, name, MEM_PADDING, capacity_ * tuple_bytes - live);
+    SetTrackedMemory(this, name, MEM_SWAP, capacity_ * tuple_bytes);
   }
 
   /**
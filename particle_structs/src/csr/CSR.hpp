@@ -2,6 +2,7 @@
 
 #include <particle_structs.hpp>
 #include <ppTiming.hpp>
+#include <ppMemTracker.hpp>
 #include <sstream>
 #include <CSR_input.hpp>
 #include <iostream>
@@ -84,6 +85,7 @@ namespace pumipic {
     using ParticleStructure<DataTypes, MemSpace>::num_rows;
     using ParticleStructure<DataTypes, MemSpace>::ptcl_data;
     using ParticleStructure<DataTypes, MemSpace>::num_types;
+    using ParticleStructure<DataTypes, MemSpace>::migrate_bytes_per_ptcl;
 
     // Data types for keeping track of global IDs
     kkGidView element_to_gid;
@@ -100,6 +102,8 @@ namespace pumipic {
                    kkGidView element_gids,
                    kkLidView particle_elements,
                    MTVs particle_info);
+    //Reports the live, padding and swap bytes to the memory tracker
+    void trackMemory() const;
 
     //Rebuild and Padding variables
     bool always_realloc;
@@ -169,6 +173,18 @@ namespace pumipic {
   CSR<DataTypes, MemSpace>::~CSR() {
     destroyViews<DataTypes, memory_space>(ptcl_data);
     destroyViews<DataTypes, memory_space>(ptcl_data_swap);
+    ReleaseTrackedMemory(this);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  void CSR<DataTypes, MemSpace>::trackMemory() const {
+    if (!isMemoryTracking())
+      return;
+    const std::size_t ptcl_bytes = DataTypes::memsize;
+    const std::size_t live = num_ptcls * ptcl_bytes;
+    SetTrackedMemory(this, "CSR", MEM_LIVE, live);
+    SetTrackedMemory(this, "CSR", MEM_PADDING, capacity_ * ptcl_bytes - live);
+    SetTrackedMemory(this, "CSR", MEM_SWAP, swap_capacity_ * ptcl_bytes);
   }
 
   /**
@@ -245,7 +261,7 @@ namespace pumipic {
     for (int i = 1; i < offsets_host.size(); i++) {
       if ( offsets_host[i] != offsets_host[i-1] ) {
         if (element_to_gid_host.size() > 0)
-          num_chars = sprintf(ptr,"\n  Element %2d(%2d) |", i-1, element_to_gid_host(i-1));
+          num_chars = sprintf(ptr,"\n  Element %2d(%ld) |", i-1, element_to_gid_host(i-1));
         else
           num_chars = sprintf(ptr,"\n  Element %2d |", i-1);
         buffer[num_chars] = '\0';
@@ -88,6 +88,7 @@ namespace pumipic {
       if(!comm_rank) fprintf(stderr, "initializing CSR data\n");
       initCsrData(particle_elements, particle_info);
     }
+    trackMemory();
 
     Kokkos::Profiling::popRegion();
   }
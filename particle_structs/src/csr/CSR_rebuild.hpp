@@ -18,9 +18,12 @@ namespace pumipic {
   void CSR<DataTypes,MemSpace>::rebuild(kkLidView new_element,
                                         kkLidView new_particle_elements,
                                         MTVs new_particles) {
+    static const int rebuild_timer = RegisterTimer("CSR rebuild");
     const auto btime = prebarrier();
+    ScopedTimer rebuild_scope(rebuild_timer);
     
     Kokkos::Profiling::pushRegion("CSR Rebuild");
+    ScopedMemoryPhase memory_phase("rebuild");
     Kokkos::Timer timer;
 
     Kokkos::Timer time_ppe;
@@ -112,6 +115,7 @@ namespace pumipic {
 
     num_ptcls = particles_on_process;
     offsets   = offsets_new;
+    trackMemory();
 
     RecordTime("CSR rebuild", timer.seconds(), btime);
     Kokkos::Profiling::popRegion();
@@ -4,6 +4,7 @@
 #include <Cabana_Core.hpp>
 #include "psMemberTypeCabana.h"
 #include "dps_input.hpp"
+#include <ppMemTracker.hpp>
 #include <sstream>
 #include <iostream>
 
@@ -95,6 +96,7 @@ namespace pumipic {
     using ParticleStructure<DataTypes, MemSpace>::num_rows;
     using ParticleStructure<DataTypes, MemSpace>::ptcl_data;
     using ParticleStructure<DataTypes, MemSpace>::num_types;
+    using ParticleStructure<DataTypes, MemSpace>::migrate_bytes_per_ptcl;
   
     // mappings from row to element gid and back to row
     kkGidView element_to_gid;
@@ -113,6 +115,8 @@ namespace pumipic {
                   kkGidView element_gids,
                   kkLidView particle_elements,
                   MTVs particle_info);
+    //Reports the live and padding bytes to the memory tracker
+    void trackMemory() const;
 
     //Private constructor for copy()
     DPS() : ParticleStructure<DataTypes, MemSpace>(), policy(100, 1) {}
@@ -147,6 +151,7 @@ namespace pumipic {
     }
     else
       setParentElms(ptcls_per_elem, parentElms_);
+    trackMemory();
 
     Kokkos::Profiling::popRegion();       
   }
@@ -200,7 +205,22 @@ namespace pumipic {
   }
 
   template <class DataTypes, typename MemSpace>
-  DPS<DataTypes, MemSpace>::~DPS() { delete aosoa_; }
+  DPS<DataTypes, MemSpace>::~DPS() {
+    delete aosoa_;
+    ReleaseTrackedMemory(this);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  void DPS<DataTypes, MemSpace>::trackMemory() const {
+    if (!isMemoryTracking())
+      return;
+    //Each tuple of the AoSoA also holds the active mask, particles are moved in place
+    const std::size_t ptcl_bytes = DataTypes::memsize;
+    const std::size_t live = num_ptcls * ptcl_bytes;
+    SetTrackedMemory(this, name, MEM_LIVE, live);
+    SetTrackedMemory(this, name, MEM_PADDING, capacity_ * (ptcl_bytes + sizeof(bool)) - live);
+    SetTrackedMemory(this, name, MEM_SWAP, 0);
+  }
 
   /**
    * a parallel for-loop that iterates through all particles
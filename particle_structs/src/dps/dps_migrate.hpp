@@ -18,6 +18,7 @@ namespace pumipic {
     const auto btime = prebarrier();
 
     Kokkos::Profiling::pushRegion("dps_migrate");
+    ScopedMemoryPhase memory_phase("migrate");
     Kokkos::Timer timer;
     
     // Distributor size & rank for performing migration
@@ -68,6 +69,13 @@ namespace pumipic {
       }
     }
 
+    if (isCommVolumeEnabled()) {
+      for (int i = 0; i < comm_size; ++i) {
+        if (dist.rank_host(i) != comm_rank)
+          RecordCommVolume(COMM_MIGRATE_COUNTS, dist.rank_host(i), sizeof(lid_t));
+      }
+    }
+
     PS_Comm_Waitall<device_type>(num_recv_ranks, count_recv_requests, MPI_STATUSES_IGNORE);
     delete [] count_recv_requests;
     
@@ -165,6 +173,8 @@ namespace pumipic {
         send_num++;
         SendViews<device_type, DataTypes>(send_particle, start_index, num_send, rank, 1,
                                           dist.mpi_comm(), send_requests + send_num);
+        RecordCommVolume(COMM_MIGRATE, rank,
+                         num_send * migrate_bytes_per_ptcl, num_types + 1);
         send_num+=num_types;
       }
       // Receiving
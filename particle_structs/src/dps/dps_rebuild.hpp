@@ -19,7 +19,10 @@ namespace pumipic {
   void DPS<DataTypes, MemSpace>::rebuild(kkLidView new_element,
                                          kkLidView new_particle_elements,
                                          MTVs new_particles) {
+    static const int rebuild_timer = RegisterTimer("DPS rebuild");
     const auto btime = prebarrier();
+    ScopedTimer rebuild_scope(rebuild_timer);
+    ScopedMemoryPhase memory_phase("rebuild");
 
     Kokkos::Profiling::pushRegion("DPS Rebuild");
     Kokkos::Timer overall_timer; // timer for rebuild
@@ -122,6 +125,8 @@ namespace pumipic {
         soa_indices, soa_ptcl_indices); // copy data over
     }
 
+    trackMemory();
+
     RecordTime("DPS add particles", add_timer.seconds());
     RecordTime("DPS rebuild", overall_timer.seconds(), btime);
     Kokkos::Profiling::popRegion();
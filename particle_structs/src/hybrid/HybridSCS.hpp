@@ -0,0 +1,463 @@
+#pragma once
+
+#include <particle_structs.hpp>
+#include <ppTiming.hpp>
+#include <ppMemTracker.hpp>
+#include <Kokkos_Sort.hpp>
+#include <sstream>
+#include <HybridSCS_input.hpp>
+#include <iostream>
+
+namespace ps = particle_structs;
+
+namespace pumipic {
+
+  void enable_prebarrier();
+  double prebarrier();
+
+  /*
+    Layout of a HybridSCS: elements with at least dense_threshold particles are sorted
+    by decreasing count into chunks of C rows that are cut into vertical slices of at
+    most V columns like SellCSigma (sigma = num_elems). The remaining elements follow
+    the last slice as a compact CSR tail without padding.
+  */
+  template <class Device>
+  struct HybridLayout {
+    typedef Kokkos::View<lid_t*, Device> View;
+    HybridLayout() : C(1), V(1), num_dense(0), num_chunks(0), num_slices(0),
+                     scs_capacity(0), num_tail(0) {}
+
+    lid_t C, V;
+    lid_t num_dense;
+    lid_t num_chunks;
+    lid_t num_slices;
+    //First index of the tail
+    lid_t scs_capacity;
+    lid_t num_tail;
+
+    //Chunk rows, padded rows repeat the first element of their chunk
+    View row_to_element;
+    //Row of each dense element, -1 for tail elements
+    View element_to_row;
+    //First slice of each chunk (num_chunks + 1)
+    View chunk_to_slice;
+    View slice_to_chunk;
+    //Start of each slice (num_slices + 1)
+    View offsets;
+    //Start of each element in the tail, empty for dense elements (num_elems + 1)
+    View tail_offsets;
+    View tail_element;
+
+    lid_t capacity() const {return scs_capacity + num_tail;}
+
+    //Index of the k-th particle of element elem
+    KOKKOS_INLINE_FUNCTION lid_t index(const lid_t elem, const lid_t k) const {
+      const lid_t row = element_to_row(elem);
+      if (row < 0)
+        return scs_capacity + tail_offsets(elem) + k;
+      const lid_t slice = chunk_to_slice(row / C) + k / V;
+      return offsets(slice) + (k % V) * C + row % C;
+    }
+  };
+
+  template <class DataTypes, typename MemSpace = DefaultMemSpace>
+  class HybridSCS : public ParticleStructure<DataTypes, MemSpace> {
+  public:
+    template <typename MSpace> using Mirror = HybridSCS<DataTypes, MSpace>;
+    using typename ParticleStructure<DataTypes, MemSpace>::execution_space;
+    using typename ParticleStructure<DataTypes, MemSpace>::memory_space;
+    using typename ParticleStructure<DataTypes, MemSpace>::device_type;
+    using typename ParticleStructure<DataTypes, MemSpace>::kkLidView;
+    using typename ParticleStructure<DataTypes, MemSpace>::kkGidView;
+    using typename ParticleStructure<DataTypes, MemSpace>::kkLidHostMirror;
+    using typename ParticleStructure<DataTypes, MemSpace>::kkGidHostMirror;
+    using typename ParticleStructure<DataTypes, MemSpace>::MTVs;
+
+    typedef Kokkos::TeamPolicy<execution_space> PolicyType;
+    typedef Kokkos::UnorderedMap<gid_t, lid_t, device_type> GID_Mapping;
+    typedef Kokkos::View<bool*, device_type> kkBoolView;
+    typedef HybridLayout<device_type> Layout;
+
+    typedef HybridSCS_Input<DataTypes,MemSpace> Input_T;
+
+    HybridSCS(const HybridSCS&) = delete;
+    HybridSCS& operator=(const HybridSCS&) = delete;
+
+    HybridSCS(PolicyType& p, lid_t vertical_chunk_size, lid_t dense_threshold,
+              lid_t num_elements, lid_t num_particles,
+              kkLidView particles_per_element,
+              kkGidView element_gids,
+              kkLidView particle_elements = kkLidView(),
+              MTVs particle_info = NULL);
+    HybridSCS(Input_T& input);
+    ~HybridSCS();
+
+    template <class MSpace>
+    Mirror<MSpace>* copy();
+
+    //Functions from ParticleStructure
+    using ParticleStructure<DataTypes, MemSpace>::nElems;
+    using ParticleStructure<DataTypes, MemSpace>::nPtcls;
+    using ParticleStructure<DataTypes, MemSpace>::capacity;
+    using ParticleStructure<DataTypes, MemSpace>::numRows;
+    using ParticleStructure<DataTypes, MemSpace>::copy;
+
+    lid_t C() const {return layout.C;}
+    lid_t V() const {return V_;}
+    lid_t denseThreshold() const {return dense_threshold;}
+    lid_t numDenseElements() const {return layout.num_dense;}
+    lid_t numTailParticles() const {return num_ptcls - num_dense_ptcls;}
+
+    void migrate(kkLidView new_element, kkLidView new_process,
+                 Distributor<MemSpace> dist = Distributor<MemSpace>(),
+                 kkLidView new_particle_elements = kkLidView(),
+                 MTVs new_particle_info = NULL);
+
+    void rebuild(kkLidView new_element, kkLidView new_particle_elements = kkLidView(),
+                 MTVs new_particles = NULL);
+
+    template <typename FunctionType>
+    void parallel_for(FunctionType& fn, std::string name="");
+
+    void printMetrics() const;
+    void printFormat(const char* prefix) const;
+
+    // Do not call these functions:
+    void createGlobalMapping(kkGidView element_gids, kkGidView& lid_to_gid, GID_Mapping& gid_to_lid);
+    Layout buildLayout(kkLidView ptcls_per_elem);
+
+    template <typename DT, typename MSpace> friend class HybridSCS;
+
+  private:
+    // The User defined Kokkos policy
+    PolicyType policy;
+
+    // Variables from ParticleStructure
+    using ParticleStructure<DataTypes, MemSpace>::name;
+    using ParticleStructure<DataTypes, MemSpace>::num_elems;
+    using ParticleStructure<DataTypes, MemSpace>::num_ptcls;
+    using ParticleStructure<DataTypes, MemSpace>::capacity_;
+    using ParticleStructure<DataTypes, MemSpace>::num_rows;
+    using ParticleStructure<DataTypes, MemSpace>::ptcl_data;
+    using ParticleStructure<DataTypes, MemSpace>::num_types;
+    using ParticleStructure<DataTypes, MemSpace>::migrate_bytes_per_ptcl;
+
+    //Chunk height, vertical slice width and the particle count that makes an element dense
+    lid_t C_max, V_, dense_threshold;
+    Layout layout;
+    kkBoolView particle_mask;
+    lid_t num_dense_ptcls;
+
+    // Data types for keeping track of global IDs
+    kkGidView element_to_gid;
+    GID_Mapping element_gid_to_lid;
+
+    //Swap memory
+    MTVs ptcl_data_swap;
+    lid_t current_size, swap_size;
+
+    //Private construct function
+    void construct(kkLidView ptcls_per_elem,
+                   kkGidView element_gids,
+                   kkLidView particle_elements,
+                   MTVs particle_info);
+    //Reports the live, padding and swap bytes to the memory tracker
+    void trackMemory() const;
+
+    //Rebuild and Padding variables
+    bool always_realloc;
+    double minimize_size;
+    double extra_padding;
+
+    //Private constructor for copy()
+    HybridSCS() : ParticleStructure<DataTypes, MemSpace>(), policy(100, 1) {}
+  };
+
+  /**
+   * Constructor
+   * @param[in] p team policy, its team size is the maximum chunk height
+   * @param[in] vertical_chunk_size the maximum width of a slice of a chunk
+   * @param[in] dense_threshold elements with at least this many particles are stored in chunks
+   * @param[in] num_elements number of elements
+   * @param[in] num_particles number of particles
+   * @param[in] particle_per_element view of ints, representing number of particles
+   *    in each element
+   * @param[in] element_gids view of ints, representing the global ids of each element
+   * @param[in] particle_elements view of ints, representing which elements
+   *    particle reside in (optional)
+   * @param[in] particle_info array of views filled with particle data (optional)
+   * @exception num_elements != particles_per_element.size(),
+   *    undefined behavior for new_particle_elements.size() != sizeof(new_particles),
+   *    undefined behavior for numberoftypes(new_particles) != numberoftypes(DataTypes)
+  */
+  template <class DataTypes, typename MemSpace>
+  HybridSCS<DataTypes, MemSpace>::HybridSCS(PolicyType& p, lid_t vertical_chunk_size,
+                                            lid_t dense_threshold_,
+                                            lid_t num_elements, lid_t num_particles,
+                                            kkLidView particles_per_element,
+                                            kkGidView element_gids,      // optional
+                                            kkLidView particle_elements, // optional
+                                            MTVs particle_info) :        // optional
+      ParticleStructure<DataTypes, MemSpace>(),
+      policy(p),
+      element_gid_to_lid(num_elements)
+  {
+    num_elems = num_elements;
+    num_rows  = num_elems;
+    num_ptcls = num_particles;
+    V_ = vertical_chunk_size;
+    dense_threshold = dense_threshold_;
+
+    always_realloc = false;
+    minimize_size = 0.8;
+    extra_padding = 0.05;
+
+    construct(particles_per_element,element_gids,particle_elements,particle_info);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  HybridSCS<DataTypes, MemSpace>::HybridSCS(Input_T& input):
+    ParticleStructure<DataTypes,MemSpace>(input.name),policy(input.policy),
+    element_gid_to_lid(input.ne) {
+
+    num_elems = input.ne;
+    num_ptcls = input.np;
+    num_rows  = num_elems;
+    V_ = input.V;
+    dense_threshold = input.dense_threshold;
+
+    extra_padding = input.extra_padding;
+    always_realloc = input.always_realloc;
+    minimize_size = input.minimize_size;
+
+    construct(input.ppe, input.e_gids, input.particle_elms, input.p_info);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  HybridSCS<DataTypes, MemSpace>::~HybridSCS() {
+    destroyViews<DataTypes, memory_space>(ptcl_data);
+    destroyViews<DataTypes, memory_space>(ptcl_data_swap);
+    ReleaseTrackedMemory(this);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  void HybridSCS<DataTypes, MemSpace>::trackMemory() const {
+    if (!isMemoryTracking())
+      return;
+    const std::size_t ptcl_bytes = DataTypes::memsize;
+    const std::size_t live = num_ptcls * ptcl_bytes;
+    //Includes the chunk padding, the extra padding and the particle mask
+    const std::size_t allocated = current_size * ptcl_bytes + capacity_ * sizeof(bool);
+    SetTrackedMemory(this, name, MEM_LIVE, live);
+    SetTrackedMemory(this, name, MEM_PADDING, allocated - live);
+    SetTrackedMemory(this, name, MEM_SWAP, always_realloc ? 0 : swap_size * ptcl_bytes);
+  }
+
+  /**
+   * a parallel for-loop that iterates through all particles
+   * @param[in] fn function of the form fn(elm, particle_id, mask), where
+   *    elm is the element the particle is in
+   *    particle_id is the overall index of the particle in the structure
+   *    mask is 0 if the particle is inactive and 1 if the particle is active
+   * @param[in] s string for labelling purposes
+  */
+  template <class DataTypes, typename MemSpace>
+  template <typename FunctionType>
+  void HybridSCS<DataTypes, MemSpace>::parallel_for(FunctionType& fn, std::string name) {
+    if (nPtcls() == 0)
+      return;
+    FunctionType* fn_d = gpuMemcpy(fn);
+    //One league covers the slices of the chunks followed by blocks of C_max*V tail particles,
+    //  teams are sized by C_max so the tail keeps full teams when few elements are dense
+    const Layout l = layout;
+    const lid_t team_size = C_max;
+    const lid_t rows = l.C;
+    const lid_t block_size = team_size * l.V;
+    const lid_t num_slices = l.num_slices;
+    const lid_t num_blocks = (l.num_tail + block_size - 1) / block_size;
+    const PolicyType policy(num_slices + num_blocks, team_size);
+    auto mask_cpy = particle_mask;
+    Kokkos::parallel_for(name, policy,
+        KOKKOS_LAMBDA(const typename PolicyType::member_type& thread) {
+        const lid_t league = thread.league_rank();
+        if (league < num_slices) {
+          const lid_t start = l.offsets(league);
+          const lid_t row_length = (l.offsets(league + 1) - start) / rows;
+          const lid_t first_row = l.slice_to_chunk(league) * rows;
+          Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, rows), [=] (lid_t& j) {
+            const lid_t element_id = l.row_to_element(first_row + j);
+            Kokkos::parallel_for(Kokkos::ThreadVectorRange(thread, row_length), [&] (lid_t& p) {
+              const lid_t particle_id = start + j + p * rows;
+              const bool mask = mask_cpy(particle_id);
+              (*fn_d)(element_id, particle_id, mask);
+            });
+          });
+        }
+        else {
+          const lid_t start = (league - num_slices) * block_size;
+          const lid_t end = start + block_size < l.num_tail ? start + block_size : l.num_tail;
+          Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, end - start), [=] (lid_t& j) {
+            const lid_t particle_id = l.scs_capacity + start + j;
+            const bool mask = mask_cpy(particle_id);
+            (*fn_d)(l.tail_element(start + j), particle_id, mask);
+          });
+        }
+    });
+#ifdef PP_USE_GPU
+    gpuFree(fn_d);
+#endif
+  }
+
+  template <class DataTypes, typename MemSpace>
+  void HybridSCS<DataTypes, MemSpace>::printMetrics() const {
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+
+    char buffer[1000];
+    char* ptr = buffer;
+
+    // Header
+    ptr += sprintf(ptr, "Metrics (Rank %d)\n", comm_rank);
+    // Sizes
+    ptr += sprintf(ptr, "Number of Elements %d, Number of Particles %d, Capacity %d\n",
+                   num_elems, num_ptcls, capacity_);
+    // Chunks
+    ptr += sprintf(ptr, "Dense Elements %d, Chunks %d, Slices %d, C %d, V %d, "
+                   "Dense Particles %d, Chunk Capacity %d\n", layout.num_dense,
+                   layout.num_chunks, layout.num_slices, layout.C, V_, num_dense_ptcls,
+                   layout.scs_capacity);
+    // Tail
+    ptr += sprintf(ptr, "Tail Elements %d, Tail Particles %d\n",
+                   num_elems - layout.num_dense, layout.num_tail);
+    // Padding
+    const lid_t padded = layout.scs_capacity - num_dense_ptcls;
+    ptr += sprintf(ptr, "Padded Cells %d (%.3f%%)\n", padded,
+                   capacity_ ? padded * 100.0 / capacity_ : 0.0);
+
+    printf("%s\n", buffer);
+  }
+
+  template <class DataTypes, typename MemSpace>
+  void HybridSCS<DataTypes, MemSpace>::printFormat(const char* prefix) const {
+    kkGidHostMirror element_to_gid_host = deviceToHost(element_to_gid);
+    kkLidHostMirror row_to_element_host = deviceToHost(layout.row_to_element);
+    kkLidHostMirror slice_to_chunk_host = deviceToHost(layout.slice_to_chunk);
+    kkLidHostMirror offsets_host = deviceToHost(layout.offsets);
+    kkLidHostMirror tail_offsets_host = deviceToHost(layout.tail_offsets);
+    Kokkos::View<bool*, Kokkos::HostSpace> mask_host("mask_host", particle_mask.size());
+    Kokkos::deep_copy(mask_host, particle_mask);
+    const lid_t C = layout.C;
+
+    std::stringstream ss;
+    char buffer[1000];
+    char* ptr = buffer;
+    int num_chars;
+
+    num_chars = sprintf(ptr, "%s\n", prefix);
+    num_chars += sprintf(ptr+num_chars,"Particle Structures HybridSCS\n");
+    num_chars += sprintf(ptr+num_chars,"Number of Elements: %d.\nNumber of Particles: %d.",
+                         num_elems, num_ptcls);
+    buffer[num_chars] = '\0';
+    ss << buffer;
+
+    for (lid_t s = 0; s < layout.num_slices; ++s) {
+      const lid_t chunk = slice_to_chunk_host(s);
+      const lid_t row_length = (offsets_host(s + 1) - offsets_host(s)) / C;
+      num_chars = sprintf(ptr, "\n  Slice %d (Chunk %d)", s, chunk);
+      buffer[num_chars] = '\0';
+      ss << buffer;
+      for (lid_t r = 0; r < C; ++r) {
+        const lid_t elem = row_to_element_host(chunk * C + r);
+        if (element_to_gid_host.size() > 0)
+          num_chars = sprintf(ptr,"\n    Element %2d(%ld) |", elem, element_to_gid_host(elem));
+        else
+          num_chars = sprintf(ptr,"\n    Element %2d |", elem);
+        buffer[num_chars] = '\0';
+        ss << buffer;
+        for (lid_t p = 0; p < row_length; ++p) {
+          ss << " " << mask_host(offsets_host(s) + r + p * C);
+        }
+      }
+    }
+    for (lid_t i = 1; i < (lid_t)tail_offsets_host.size(); i++) {
+      if (tail_offsets_host(i) != tail_offsets_host(i-1)) {
+        if (element_to_gid_host.size() > 0)
+          num_chars = sprintf(ptr,"\n  Tail Element %2d(%ld) |", i-1, element_to_gid_host(i-1));
+        else
+          num_chars = sprintf(ptr,"\n  Tail Element %2d |", i-1);
+        buffer[num_chars] = '\0';
+        ss << buffer;
+        for (lid_t j = tail_offsets_host(i-1); j < tail_offsets_host(i); j++)
+          ss << " " << mask_host(layout.scs_capacity + j);
+      }
+    }
+    ss << "\n";
+    std::cout << ss.str();
+  }
+
+  template<class DataTypes, typename MemSpace>
+  template <class MSpace>
+  typename HybridSCS<DataTypes, MemSpace>::template Mirror<MSpace>*
+  HybridSCS<DataTypes, MemSpace>::copy() {
+    if (std::is_same<memory_space, typename MSpace::memory_space>::value) {
+      fprintf(stderr, "[ERROR] Copy to same memory space not supported\n");
+      exit(EXIT_FAILURE);
+    }
+    typedef typename Mirror<MSpace>::kkLidView MirrorView;
+    Mirror<MSpace>* mirror_copy = new HybridSCS<DataTypes, MSpace>();
+    //Call Particle structures copy
+    mirror_copy->copy(this);
+    //Copy constants
+    mirror_copy->C_max = C_max;
+    mirror_copy->V_ = V_;
+    mirror_copy->dense_threshold = dense_threshold;
+    mirror_copy->num_dense_ptcls = num_dense_ptcls;
+    mirror_copy->current_size = current_size;
+    mirror_copy->swap_size = swap_size;
+    mirror_copy->always_realloc = always_realloc;
+    mirror_copy->minimize_size = minimize_size;
+    mirror_copy->extra_padding = extra_padding;
+
+    //Create the swap space
+    mirror_copy->ptcl_data_swap =
+      createMemberViews<DataTypes, MSpace>(swap_size);
+
+    //Copy the layout
+    typename Mirror<MSpace>::Layout& l = mirror_copy->layout;
+    l.C = layout.C;
+    l.V = layout.V;
+    l.num_dense = layout.num_dense;
+    l.num_chunks = layout.num_chunks;
+    l.num_slices = layout.num_slices;
+    l.scs_capacity = layout.scs_capacity;
+    l.num_tail = layout.num_tail;
+    l.row_to_element = MirrorView("mirror row_to_element", layout.row_to_element.size());
+    Kokkos::deep_copy(l.row_to_element, layout.row_to_element);
+    l.element_to_row = MirrorView("mirror element_to_row", layout.element_to_row.size());
+    Kokkos::deep_copy(l.element_to_row, layout.element_to_row);
+    l.chunk_to_slice = MirrorView("mirror chunk_to_slice", layout.chunk_to_slice.size());
+    Kokkos::deep_copy(l.chunk_to_slice, layout.chunk_to_slice);
+    l.slice_to_chunk = MirrorView("mirror slice_to_chunk", layout.slice_to_chunk.size());
+    Kokkos::deep_copy(l.slice_to_chunk, layout.slice_to_chunk);
+    l.offsets = MirrorView("mirror offsets", layout.offsets.size());
+    Kokkos::deep_copy(l.offsets, layout.offsets);
+    l.tail_offsets = MirrorView("mirror tail_offsets", layout.tail_offsets.size());
+    Kokkos::deep_copy(l.tail_offsets, layout.tail_offsets);
+    l.tail_element = MirrorView("mirror tail_element", layout.tail_element.size());
+    Kokkos::deep_copy(l.tail_element, layout.tail_element);
+    mirror_copy->particle_mask =
+      typename Mirror<MSpace>::kkBoolView("mirror particle_mask", particle_mask.size());
+    Kokkos::deep_copy(mirror_copy->particle_mask, particle_mask);
+
+    mirror_copy->element_to_gid = typename Mirror<MSpace>::kkGidView("mirror element_to_gid",
+                                                                    element_to_gid.size());
+    Kokkos::deep_copy(mirror_copy->element_to_gid, element_to_gid);
+    //Deep copy the gid mapping
+    mirror_copy->element_gid_to_lid.create_copy_view(element_gid_to_lid);
+    return mirror_copy;
+  }
+} // end namespace pumipic
+
+#include "HybridSCS_buildFns.hpp"
+#include "HybridSCS_rebuild.hpp"
+#include "HybridSCS_migrate.hpp"
@@ -0,0 +1,192 @@
+#pragma once
+
+namespace pumipic {
+
+  /**
+   * helper function: copies element_gids and creates a map for converting in the opposite direction
+   * @param[in] element_gids view of global ids for each element
+   * @param[out] lid_to_gid view to copy elmGid to
+   * @param[out] gid_to_lid unordered map with elements global ids as keys and local ids as values
+  */
+  template<class DataTypes, typename MemSpace>
+  void HybridSCS<DataTypes, MemSpace>::createGlobalMapping(kkGidView element_gids,
+                                                           kkGidView& lid_to_gid,
+                                                           GID_Mapping& gid_to_lid) {
+    lid_to_gid = kkGidView(Kokkos::ViewAllocateWithoutInitializing("row to element gid"), num_elems);
+    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+      const gid_t gid = element_gids(i);
+      lid_to_gid(i) = gid;
+      gid_to_lid.insert(gid, i);
+    });
+  }
+
+  /**
+   * helper function: splits the elements into dense chunks and the sparse tail
+   * @param[in] ptcls_per_elem view of the number of particles in each element
+   * @return the layout holding ptcls_per_elem(e) particles of each element e
+  */
+  template<class DataTypes, typename MemSpace>
+  typename HybridSCS<DataTypes, MemSpace>::Layout
+  HybridSCS<DataTypes, MemSpace>::buildLayout(kkLidView ptcls_per_elem) {
+    Layout l;
+    l.V = V_;
+    const lid_t ne = num_elems;
+    const lid_t threshold = dense_threshold;
+    const lid_t V = V_;
+
+    //Number the dense elements
+    kkLidView is_dense("is_dense", ne + 1);
+    lid_t max_ppe = 0;
+    Kokkos::parallel_reduce("mark_dense", ne, KOKKOS_LAMBDA(const lid_t& e, lid_t& lmax) {
+      const lid_t count = ptcls_per_elem(e);
+      is_dense(e) = count > 0 && count >= threshold;
+      if (count > lmax)
+        lmax = count;
+    }, Kokkos::Max<lid_t>(max_ppe));
+    kkLidView dense_index("dense_index", ne + 1);
+    exclusive_scan(is_dense, dense_index, execution_space());
+    l.num_dense = getLastValue(dense_index);
+
+    //Sort the dense elements by decreasing count, ties keep the element order
+    Kokkos::View<int64_t*, device_type> keys(Kokkos::ViewAllocateWithoutInitializing("dense_keys"),
+                                             l.num_dense);
+    Kokkos::parallel_for("dense_keys", ne, KOKKOS_LAMBDA(const lid_t& e) {
+      if (is_dense(e))
+        keys(dense_index(e)) = static_cast<int64_t>(max_ppe - ptcls_per_elem(e)) * ne + e;
+    });
+    if (l.num_dense > 0)
+      Kokkos::sort(keys);
+
+    //Rows of the chunks
+    const lid_t C = l.num_dense < C_max ? l.num_dense : C_max;
+    l.C = C > 0 ? C : 1;
+    const lid_t chunk_height = l.C;
+    l.num_chunks = (l.num_dense + chunk_height - 1) / chunk_height;
+    const lid_t num_dense = l.num_dense;
+    kkLidView row_to_element(Kokkos::ViewAllocateWithoutInitializing("row_to_element"),
+                             l.num_chunks * chunk_height);
+    kkLidView element_to_row("element_to_row", ne);
+    Kokkos::deep_copy(element_to_row, -1);
+    Kokkos::parallel_for("row_to_element", l.num_chunks * chunk_height,
+                         KOKKOS_LAMBDA(const lid_t& r) {
+      const lid_t row = r < num_dense ? r : r - r % chunk_height;
+      const lid_t elem = keys(row) % ne;
+      row_to_element(r) = elem;
+      if (r < num_dense)
+        element_to_row(elem) = r;
+    });
+
+    //Each chunk is as wide as its first row and is cut into slices of at most V columns
+    kkLidView slices_per_chunk("slices_per_chunk", l.num_chunks + 1);
+    Kokkos::parallel_for("slices_per_chunk", l.num_chunks, KOKKOS_LAMBDA(const lid_t& c) {
+      const lid_t width = ptcls_per_elem(row_to_element(c * chunk_height));
+      slices_per_chunk(c) = (width + V - 1) / V;
+    });
+    kkLidView chunk_to_slice("chunk_to_slice", l.num_chunks + 1);
+    exclusive_scan(slices_per_chunk, chunk_to_slice, execution_space());
+    l.num_slices = getLastValue(chunk_to_slice);
+
+    kkLidView slice_to_chunk(Kokkos::ViewAllocateWithoutInitializing("slice_to_chunk"),
+                             l.num_slices);
+    kkLidView slice_size("slice_size", l.num_slices + 1);
+    Kokkos::parallel_for("slice_size", l.num_chunks, KOKKOS_LAMBDA(const lid_t& c) {
+      const lid_t width = ptcls_per_elem(row_to_element(c * chunk_height));
+      for (lid_t s = chunk_to_slice(c); s < chunk_to_slice(c + 1); ++s) {
+        const lid_t columns = width - (s - chunk_to_slice(c)) * V;
+        slice_to_chunk(s) = c;
+        slice_size(s) = chunk_height * (columns < V ? columns : V);
+      }
+    });
+    kkLidView offsets("offsets", l.num_slices + 1);
+    exclusive_scan(slice_size, offsets, execution_space());
+    l.scs_capacity = getLastValue(offsets);
+
+    //Sparse elements are packed after the slices
+    kkLidView tail_counts("tail_counts", ne + 1);
+    Kokkos::parallel_for("tail_counts", ne, KOKKOS_LAMBDA(const lid_t& e) {
+      tail_counts(e) = is_dense(e) ? 0 : ptcls_per_elem(e);
+    });
+    kkLidView tail_offsets("tail_offsets", ne + 1);
+    exclusive_scan(tail_counts, tail_offsets, execution_space());
+    l.num_tail = getLastValue(tail_offsets);
+    kkLidView tail_element(Kokkos::ViewAllocateWithoutInitializing("tail_element"), l.num_tail);
+    Kokkos::parallel_for("tail_element", ne, KOKKOS_LAMBDA(const lid_t& e) {
+      for (lid_t i = tail_offsets(e); i < tail_offsets(e + 1); ++i)
+        tail_element(i) = e;
+    });
+
+    l.row_to_element = row_to_element;
+    l.element_to_row = element_to_row;
+    l.chunk_to_slice = chunk_to_slice;
+    l.slice_to_chunk = slice_to_chunk;
+    l.offsets = offsets;
+    l.tail_offsets = tail_offsets;
+    l.tail_element = tail_element;
+    return l;
+  }
+
+  template<class DataTypes, typename MemSpace>
+  void HybridSCS<DataTypes,MemSpace>::construct(kkLidView ptcls_per_elem, kkGidView element_gids,
+                                                kkLidView particle_elements, MTVs particle_info){
+    Kokkos::Profiling::pushRegion("hybrid_scs_construction");
+
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+
+    if(!comm_rank)
+      fprintf(stderr, "Building HybridSCS\n");
+    if (V_ < 1 || dense_threshold < 1) {
+      fprintf(stderr, "[ERROR] HybridSCS requires V and the dense threshold to be positive\n");
+      throw 1;
+    }
+
+    C_max = maxChunk<MemSpace>(policy.team_size());
+    layout = buildLayout(ptcls_per_elem);
+    capacity_ = layout.capacity();
+    num_dense_ptcls = num_ptcls - layout.num_tail;
+
+    // get global ids
+    if (element_gids.size() > 0) {
+      createGlobalMapping(element_gids, element_to_gid, element_gid_to_lid);
+    }
+
+    // allocate storage for user particle data
+    current_size = capacity_ * (1 + extra_padding);
+    swap_size = always_realloc ? 0 : current_size;
+    CreateViews<device_type, DataTypes>(ptcl_data, current_size);
+    CreateViews<device_type, DataTypes>(ptcl_data_swap, swap_size);
+    particle_mask = kkBoolView("particle_mask", capacity_);
+
+    // Activate the first ptcls_per_elem(e) slots of each element
+    const Layout l = layout;
+    auto mask_cpy = particle_mask;
+    const PolicyType fill_policy(num_elems, Kokkos::AUTO());
+    Kokkos::parallel_for("set_particle_mask", fill_policy,
+        KOKKOS_LAMBDA(const typename PolicyType::member_type& thread) {
+      const lid_t elem = thread.league_rank();
+      Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, ptcls_per_elem(elem)),
+                           [=] (const lid_t& k) {
+        mask_cpy(l.index(elem, k)) = true;
+      });
+    });
+
+    // If particle info is provided then enter the information
+    lid_t given_particles = particle_elements.size();
+    if (given_particles > 0 && particle_info != NULL) {
+      if(!comm_rank) fprintf(stderr, "initializing HybridSCS data\n");
+      assert(given_particles == num_ptcls);
+      kkLidView element_fill("element_fill", num_elems);
+      kkLidView particle_indices(Kokkos::ViewAllocateWithoutInitializing("particle_indices"),
+                                 num_ptcls);
+      Kokkos::parallel_for("particle_indices", num_ptcls, KOKKOS_LAMBDA(const lid_t& i) {
+        const lid_t elem = particle_elements(i);
+        particle_indices(i) = l.index(elem, Kokkos::atomic_fetch_add(&element_fill(elem), 1));
+      });
+      CopyViewsToViews<kkLidView, DataTypes>(ptcl_data, particle_info, particle_indices);
+    }
+    trackMemory();
+
+    Kokkos::Profiling::popRegion();
+  }
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <particle_structs.hpp>
+
+namespace pumipic{
+
+  template<class DataTypes, typename MemSpace>
+  class HybridSCS;
+
+  template <class DataTypes, typename MemSpace = DefaultMemSpace>
+  class HybridSCS_Input{
+  public:
+    typedef typename ParticleStructure<DataTypes, MemSpace>::kkLidView kkLidView;
+    typedef typename ParticleStructure<DataTypes, MemSpace>::kkGidView kkGidView;
+    typedef typename ParticleStructure<DataTypes, MemSpace>::MTVs MTVs;
+    typedef Kokkos::TeamPolicy<typename MemSpace::execution_space> PolicyType;
+
+    HybridSCS_Input(PolicyType& p, lid_t vertical_chunk_size, lid_t num_elements,
+                    lid_t num_particles, kkLidView particles_per_element,
+                    kkGidView element_gids, kkLidView particle_elements = kkLidView(),
+                    MTVs particle_info = NULL);
+
+    //Elements with at least this many particles are stored in chunks, the rest in the tail
+    lid_t dense_threshold = 32;
+
+    //Whether to reallocate the ptcl_structure on every rebuild or only when size requires
+    bool always_realloc = false;
+
+    //Reallocate structure when the layout needs less than minimize_size*allocated
+    double minimize_size = 0.8;
+
+    //Percentage of the layout allocated beyond its capacity
+    double extra_padding = 0.05;
+
+    std::string name;
+
+    friend class HybridSCS<DataTypes, MemSpace>;
+
+  protected:
+    PolicyType policy;
+    lid_t V;
+    lid_t ne, np;
+    kkLidView ppe;
+    kkGidView e_gids;
+    kkLidView particle_elms;
+    MTVs p_info;
+
+  }; //end class HybridSCS_Input
+
+  template <class DataTypes, typename MemSpace>
+  HybridSCS_Input<DataTypes, MemSpace>::HybridSCS_Input(PolicyType& p, lid_t vertical_chunk_size,
+      lid_t num_elements, lid_t num_particles, kkLidView particles_per_element,
+      kkGidView element_gids, kkLidView particle_elements, MTVs particle_info) :
+    policy(p), V(vertical_chunk_size), ne(num_elements), np(num_particles),
+    ppe(particles_per_element), e_gids(element_gids), particle_elms(particle_elements),
+    p_info(particle_info)
+  {
+    name = "ptcls";
+  }
+
+}//end namespace pumipic
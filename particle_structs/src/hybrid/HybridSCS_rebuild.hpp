@@ -0,0 +1,123 @@
+#pragma once
+
+namespace pumipic {
+
+  /**
+   * Fully rebuild the structure by replacing the old one, elements move between the
+   *     chunks and the tail as their counts cross the dense threshold
+   *     Delete particles with new_element(ptcl) < 0
+   * @param[in] new_element view of ints with new elements for each particle
+   * @param[in] new_particle_elements view of ints, representing which elements
+   *    particle reside in
+   * @param[in] new_particles array of views filled with particle data
+   * @exception new_particle_elements(ptcl) < 0,
+   *    undefined behavior for new_particle_elements.size() != sizeof(new_particles),
+   *    undefined behavior for numberoftypes(new_particles) != numberoftypes(DataTypes)
+   *    undefined behavior for new_element(ptcl) >= num_elms or new_particle_elements(ptcl) >= num_elems
+  */
+  template<class DataTypes,typename MemSpace>
+  void HybridSCS<DataTypes,MemSpace>::rebuild(kkLidView new_element,
+                                              kkLidView new_particle_elements,
+                                              MTVs new_particles) {
+    static const int rebuild_timer = RegisterTimer("HybridSCS rebuild");
+    const auto btime = prebarrier();
+    ScopedTimer rebuild_scope(rebuild_timer);
+
+    Kokkos::Profiling::pushRegion("hybrid_scs_rebuild");
+    ScopedMemoryPhase memory_phase("rebuild");
+    Kokkos::Timer timer;
+
+    // Count the particles of each element after the rebuild
+    kkLidView particles_per_element("particlesPerElement", num_elems + 1);
+    auto count_existing = PS_LAMBDA(const lid_t& elm_id, const lid_t& ptcl_id, const bool& mask) {
+      const lid_t new_elem = new_element(ptcl_id);
+      if (mask && new_elem != -1)
+        Kokkos::atomic_increment(&particles_per_element(new_elem));
+    };
+    parallel_for(count_existing, "fill particle Per Element existing");
+    const lid_t num_new_ptcls = new_particle_elements.size();
+    Kokkos::parallel_for("fill particlesPerElementNew", num_new_ptcls,
+        KOKKOS_LAMBDA(const lid_t& i) {
+          assert(new_particle_elements(i) > -1);
+          Kokkos::atomic_increment(&particles_per_element(new_particle_elements(i)));
+        });
+    lid_t particles_on_process = 0;
+    Kokkos::parallel_reduce("sum_particles", num_elems,
+                            KOKKOS_LAMBDA(const lid_t& e, lid_t& sum) {
+      sum += particles_per_element(e);
+    }, particles_on_process);
+
+    // Classify the elements by their new counts
+    Layout new_layout = buildLayout(particles_per_element);
+    const lid_t new_capacity = new_layout.capacity();
+
+    //Determine if realloc appropriate based on variables
+    if (always_realloc || swap_size < new_capacity ||
+        new_capacity < minimize_size * swap_size) {
+      destroyViews<DataTypes, memory_space>(ptcl_data_swap);
+      swap_size = new_capacity * (1 + extra_padding);
+      CreateViews<device_type, DataTypes>(ptcl_data_swap, swap_size);
+    }
+
+    // Determine new_indices for all of the existing particles
+    kkBoolView new_mask("particle_mask", new_capacity);
+    kkLidView element_fill("element_fill", num_elems);
+    kkLidView new_indices(Kokkos::ViewAllocateWithoutInitializing("new indices"), capacity());
+    auto existing_ptcl_new_indices = PS_LAMBDA(const lid_t& elm_id, const lid_t& ptcl_id,
+                                               const bool& mask) {
+      const lid_t new_elem = new_element(ptcl_id);
+      if (mask && new_elem != -1) {
+        const lid_t k = Kokkos::atomic_fetch_add(&element_fill(new_elem), 1);
+        const lid_t index = new_layout.index(new_elem, k);
+        new_indices(ptcl_id) = index;
+        new_mask(index) = true;
+      }
+      else
+        new_indices(ptcl_id) = -1;
+    };
+    parallel_for(existing_ptcl_new_indices, "calc row indices");
+
+    // Copy existing particles to their new location in the temp MTV
+    CopyPSToPS< HybridSCS<DataTypes,MemSpace>, DataTypes >(this, ptcl_data_swap, ptcl_data,
+                                                            new_element, new_indices);
+
+    // Determine new particle indices in the MTVs
+    kkLidView new_particle_indices(Kokkos::ViewAllocateWithoutInitializing("new_particle_indices"),
+                                   num_new_ptcls);
+    Kokkos::parallel_for("new_particles_indices", num_new_ptcls, KOKKOS_LAMBDA(const lid_t& i) {
+      const lid_t new_elem = new_particle_elements(i);
+      const lid_t k = Kokkos::atomic_fetch_add(&element_fill(new_elem), 1);
+      const lid_t index = new_layout.index(new_elem, k);
+      new_particle_indices(i) = index;
+      new_mask(index) = true;
+    });
+    if (num_new_ptcls > 0 && new_particles != NULL) {
+      CopyViewsToViews<kkLidView, DataTypes>(ptcl_data_swap, new_particles,
+                                             new_particle_indices);
+    }
+
+    // Reassign all member variables
+    MTVs tmp_data = ptcl_data;
+    ptcl_data = ptcl_data_swap;
+    ptcl_data_swap = tmp_data;
+    lid_t tmp_size = current_size;
+    current_size = swap_size;
+    swap_size = tmp_size;
+    if (always_realloc) {
+      destroyViews<DataTypes, memory_space>(ptcl_data_swap);
+      CreateViews<device_type, DataTypes>(ptcl_data_swap, 0);
+      swap_size = 0;
+    }
+
+    layout = new_layout;
+    particle_mask = new_mask;
+    capacity_ = new_capacity;
+    num_ptcls = particles_on_process;
+    num_dense_ptcls = num_ptcls - layout.num_tail;
+    trackMemory();
+
+    RecordTime(name + " rebuild", timer.seconds(), btime);
+    Kokkos::Profiling::popRegion();
+  }
+
+}
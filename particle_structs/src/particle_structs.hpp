@@ -3,6 +3,9 @@
 #include "ps_for.hpp"
 #include <SellCSigma.h>
 #include <CSR.hpp>
+#include <HybridSCS.hpp>
 #include <cabm.hpp>
 #include <dps.hpp>
 #include "psMemberType.h"
+#include "psMigrate.hpp"
+#include "ps_factory.hpp"
@@ -112,6 +112,8 @@ namespace pumipic {
 
     //Number of Data types
     static constexpr std::size_t num_types = DataTypes::size;
+    //Bytes sent when migrating a particle, its new element (lid_t) and its member data
+    static constexpr std::size_t migrate_bytes_per_ptcl = sizeof(lid_t) + DataTypes::memsize;
 
     /*
       Copy a particle structure to another memory space
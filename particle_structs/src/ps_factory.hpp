@@ -0,0 +1,348 @@
+#pragma once
+
+#include <particle_structs.hpp>
+#include <string>
+#include <istream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <climits>
+
+namespace pumipic {
+
+  //Particle structures that can be chosen at runtime
+  enum StructureType {
+    PS_SCS,
+    PS_CSR,
+    PS_CABM,
+    PS_DPS,
+    PS_HYBRID,
+    PS_INVALID
+  };
+
+  //Case insensitive structure name (scs, csr, cabm, dps, hybrid) to type, PS_INVALID if unknown
+  inline StructureType getStructureType(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "scs")
+      return PS_SCS;
+    if (name == "csr")
+      return PS_CSR;
+    if (name == "cabm")
+      return PS_CABM;
+    if (name == "dps")
+      return PS_DPS;
+    if (name == "hybrid")
+      return PS_HYBRID;
+    return PS_INVALID;
+  }
+
+  inline const char* getStructureName(StructureType type) {
+    const char* names[] = {"scs", "csr", "cabm", "dps", "hybrid", "invalid"};
+    return names[type];
+  }
+
+  //Returns the type of an existing structure
+  template <class DataTypes, typename MemSpace>
+  StructureType getStructureType(ParticleStructure<DataTypes, MemSpace>* ps) {
+    if (dynamic_cast<SellCSigma<DataTypes, MemSpace>*>(ps))
+      return PS_SCS;
+    if (dynamic_cast<CSR<DataTypes, MemSpace>*>(ps))
+      return PS_CSR;
+    if (dynamic_cast<CabM<DataTypes, MemSpace>*>(ps))
+      return PS_CABM;
+    if (dynamic_cast<DPS<DataTypes, MemSpace>*>(ps))
+      return PS_DPS;
+    if (dynamic_cast<HybridSCS<DataTypes, MemSpace>*>(ps))
+      return PS_HYBRID;
+    return PS_INVALID;
+  }
+
+  /*
+    Input to createParticleStructure for any structure type
+    The layout options are passed to the structures that use them and ignored by the others
+  */
+  template <class DataTypes, typename MemSpace = DefaultMemSpace>
+  class PS_Input {
+  public:
+    typedef typename ParticleStructure<DataTypes, MemSpace>::kkLidView kkLidView;
+    typedef typename ParticleStructure<DataTypes, MemSpace>::kkGidView kkGidView;
+    typedef typename ParticleStructure<DataTypes, MemSpace>::MTVs MTVs;
+    typedef Kokkos::TeamPolicy<typename MemSpace::execution_space> PolicyType;
+    PS_Input(StructureType type, PolicyType& p, lid_t num_elements, lid_t num_particles,
+             kkLidView particles_per_element, kkGidView element_gids,
+             kkLidView particle_elements = kkLidView(), MTVs particle_info = NULL);
+
+    /*
+      Sets the option `key` from its string value, returns false if either is invalid
+        structure scs|csr|cabm|dps|hybrid
+        name <string>                 dense_threshold <n>
+        sigma <n>                     V <n>
+        padding evenly|proportionally|inversely
+        shuffle_padding <fraction>    extra_padding <fraction>
+        padding_amount <factor>       minimize_size <fraction>
+        always_realloc 0|1            autotune 0|1
+    */
+    bool setOption(const std::string& key, const std::string& value);
+    //Reads `key value` pairs with setOption until the end of the stream, # starts a comment
+    bool readConfig(std::istream& in);
+
+    StructureType type;
+    //String identification for the particle structure
+    std::string name;
+
+    //Sell-C-Sigma sorting range and vertical slicing, V also slices the hybrid chunks
+    lid_t sigma = INT_MAX;
+    lid_t V = 1024;
+    //Hybrid elements with at least this many particles are stored in chunks
+    lid_t dense_threshold = 32;
+    //Sell-C-Sigma padding for shuffling, see SCS_Input
+    PaddingStrategy padding_strat = PAD_EVENLY;
+    double shuffle_padding = 0.1;
+    //Sell-C-Sigma searches its layout parameters after construction
+    bool autotune = false;
+    //Sell-C-Sigma, hybrid, CabM and DPS padding at the end of the structure
+    double extra_padding = 0.05;
+    //CSR capacity as a factor of the number of particles
+    double padding_amount = 1.05;
+    //Sell-C-Sigma, CSR and hybrid reallocation on rebuild
+    bool always_realloc = false;
+    double minimize_size = 0.8;
+
+    PolicyType policy;
+    lid_t ne, np;
+    kkLidView ppe;
+    kkGidView e_gids;
+    kkLidView particle_elms;
+    MTVs p_info;
+  };
+
+  template <class DataTypes, typename MemSpace>
+  PS_Input<DataTypes, MemSpace>::PS_Input(StructureType t, PolicyType& p, lid_t ne_, lid_t np_,
+                                          kkLidView ppe_, kkGidView eg, kkLidView pes,
+                                          MTVs info) :
+    type(t), name("ptcls"), policy(p), ne(ne_), np(np_), ppe(ppe_), e_gids(eg),
+    particle_elms(pes), p_info(info) {}
+
+  template <class DataTypes, typename MemSpace>
+  bool PS_Input<DataTypes, MemSpace>::setOption(const std::string& key,
+                                                const std::string& value) {
+    char* end;
+    if (key == "structure") {
+      type = getStructureType(value);
+      return type != PS_INVALID;
+    }
+    if (key == "name") {
+      name = value;
+      return true;
+    }
+    if (key == "padding") {
+      std::string strat = value;
+      std::transform(strat.begin(), strat.end(), strat.begin(), ::tolower);
+      if (strat == "evenly")
+        padding_strat = PAD_EVENLY;
+      else if (strat == "proportionally")
+        padding_strat = PAD_PROPORTIONALLY;
+      else if (strat == "inversely")
+        padding_strat = PAD_INVERSELY;
+      else
+        return false;
+      return true;
+    }
+    if (key == "sigma" || key == "V" || key == "dense_threshold" ||
+        key == "always_realloc" || key == "autotune") {
+      const long n = strtol(value.c_str(), &end, 10);
+      if (*end != '\0' || end == value.c_str() || n < 0)
+        return false;
+      if (key == "sigma" || key == "V" || key == "dense_threshold") {
+        //All are at least 1, sigma is capped at full sorting
+        if (n == 0 || (key != "sigma" && n > INT_MAX))
+          return false;
+        if (key == "sigma")
+          sigma = n > INT_MAX ? INT_MAX : n;
+        else if (key == "V")
+          V = n;
+        else
+          dense_threshold = n;
+      }
+      else if (key == "always_realloc")
+        always_realloc = n != 0;
+      else
+        autotune = n != 0;
+      return true;
+    }
+    double* real = NULL;
+    if (key == "shuffle_padding")
+      real = &shuffle_padding;
+    else if (key == "extra_padding")
+      real = &extra_padding;
+    else if (key == "padding_amount")
+      real = &padding_amount;
+    else if (key == "minimize_size")
+      real = &minimize_size;
+    else
+      return false;
+    const double x = strtod(value.c_str(), &end);
+    if (*end != '\0' || end == value.c_str() || x < 0)
+      return false;
+    *real = x;
+    return true;
+  }
+
+  template <class DataTypes, typename MemSpace>
+  bool PS_Input<DataTypes, MemSpace>::readConfig(std::istream& in) {
+    std::string key, value;
+    while (in >> key) {
+      if (key[0] == '#') {
+        std::getline(in, key);
+        continue;
+      }
+      if (!(in >> value)) {
+        fprintf(stderr, "[ERROR] Missing value for structure option %s\n", key.c_str());
+        return false;
+      }
+      if (!setOption(key, value)) {
+        fprintf(stderr, "[ERROR] Invalid structure option %s %s\n", key.c_str(), value.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /*
+    Builds the structure of input.type
+    Throws if the type is invalid or needs Cabana when PUMI-PIC is built without it
+  */
+  template <class DataTypes, typename MemSpace>
+  ParticleStructure<DataTypes, MemSpace>*
+  createParticleStructure(PS_Input<DataTypes, MemSpace>& input) {
+    if (input.type == PS_SCS) {
+      SCS_Input<DataTypes, MemSpace> scs_input(input.policy, input.sigma, input.V, input.ne,
+                                               input.np, input.ppe, input.e_gids,
+                                               input.particle_elms, input.p_info);
+      scs_input.name = input.name;
+      scs_input.padding_strat = input.padding_strat;
+      scs_input.shuffle_padding = input.shuffle_padding;
+      scs_input.extra_padding = input.extra_padding;
+      scs_input.always_realloc = input.always_realloc;
+      scs_input.minimize_size = input.minimize_size;
+      scs_input.autotune = input.autotune;
+      return new SellCSigma<DataTypes, MemSpace>(scs_input);
+    }
+    if (input.type == PS_CSR) {
+      CSR_Input<DataTypes, MemSpace> csr_input(input.policy, input.ne, input.np, input.ppe,
+                                               input.e_gids, input.particle_elms,
+                                               input.p_info);
+      csr_input.name = input.name;
+      csr_input.padding_amount = input.padding_amount;
+      csr_input.always_realloc = input.always_realloc;
+      csr_input.minimize_size = input.minimize_size;
+      return new CSR<DataTypes, MemSpace>(csr_input);
+    }
+    if (input.type == PS_HYBRID) {
+      HybridSCS_Input<DataTypes, MemSpace> hybrid_input(input.policy, input.V, input.ne,
+                                                        input.np, input.ppe, input.e_gids,
+                                                        input.particle_elms, input.p_info);
+      hybrid_input.name = input.name;
+      hybrid_input.dense_threshold = input.dense_threshold;
+      hybrid_input.extra_padding = input.extra_padding;
+      hybrid_input.always_realloc = input.always_realloc;
+      hybrid_input.minimize_size = input.minimize_size;
+      return new HybridSCS<DataTypes, MemSpace>(hybrid_input);
+    }
+#ifdef PP_ENABLE_CAB
+    if (input.type == PS_CABM) {
+      CabM_Input<DataTypes, MemSpace> cabm_input(input.policy, input.ne, input.np, input.ppe,
+                                                 input.e_gids, input.particle_elms,
+                                                 input.p_info);
+      cabm_input.name = input.name;
+      cabm_input.extra_padding = input.extra_padding;
+      return new CabM<DataTypes, MemSpace>(cabm_input);
+    }
+    if (input.type == PS_DPS) {
+      DPS_Input<DataTypes, MemSpace> dps_input(input.policy, input.ne, input.np, input.ppe,
+                                               input.e_gids, input.particle_elms,
+                                               input.p_info);
+      dps_input.name = input.name;
+      dps_input.extra_padding = input.extra_padding;
+      return new DPS<DataTypes, MemSpace>(dps_input);
+    }
+#else
+    if (input.type == PS_CABM || input.type == PS_DPS) {
+      fprintf(stderr, "[ERROR] Structure %s requires PUMI-PIC built with Cabana\n",
+              getStructureName(input.type));
+      throw 1;
+    }
+#endif
+    fprintf(stderr, "[ERROR] Invalid particle structure type\n");
+    throw 1;
+    return NULL;
+  }
+
+  /*
+    Builds the structure of input.type holding the particles of old
+    Particles keep their elements, the new structure is built from the particle counts of old
+    and each particle is copied from its slot in old directly into its slot in the new
+    structure. The particle counts, elements and data of input are replaced by those of old,
+    the element gids and options of input are used.
+    old is not modified and must be deleted by the caller
+  */
+  template <class DataTypes, typename MemSpace>
+  ParticleStructure<DataTypes, MemSpace>*
+  convertParticleStructure(ParticleStructure<DataTypes, MemSpace>* old,
+                           PS_Input<DataTypes, MemSpace> input) {
+    typedef ParticleStructure<DataTypes, MemSpace> PS;
+    typedef typename PS::kkLidView kkLidView;
+    if (input.ne != old->nElems()) {
+      fprintf(stderr, "[ERROR] Converting a structure of %d elements with an input of %d\n",
+              old->nElems(), input.ne);
+      throw 1;
+    }
+    Kokkos::Profiling::pushRegion("convert_structure");
+    Kokkos::Timer timer;
+    const lid_t ne = old->nElems();
+    const lid_t np = old->nPtcls();
+
+    //Count the particles of each element and number the particles within their element
+    kkLidView ptcls_per_elem("ptcls_per_elem", ne);
+    kkLidView ptcl_index(Kokkos::ViewAllocateWithoutInitializing("ptcl_index"),
+                         old->capacity());
+    auto countPtcls = PS_LAMBDA(const lid_t& elm, const lid_t& ptcl, const bool& mask) {
+      if (mask)
+        ptcl_index(ptcl) = Kokkos::atomic_fetch_add(&ptcls_per_elem(elm), 1);
+    };
+    parallel_for(old, countPtcls, "countPtcls");
+    kkLidView elem_offsets(Kokkos::ViewAllocateWithoutInitializing("elem_offsets"), ne);
+    Kokkos::parallel_scan("elem_offsets", ne,
+                          KOKKOS_LAMBDA(const lid_t& i, lid_t& sum, const bool& final) {
+      if (final)
+        elem_offsets(i) = sum;
+      sum += ptcls_per_elem(i);
+    });
+
+    //The constructors activate ptcls_per_elem slots of each element without particle info
+    input.np = np;
+    input.ppe = ptcls_per_elem;
+    input.particle_elms = kkLidView();
+    input.p_info = NULL;
+    PS* ps = createParticleStructure(input);
+
+    //Number the slots of each element in the new structure
+    kkLidView new_slots(Kokkos::ViewAllocateWithoutInitializing("new_slots"), np);
+    kkLidView elem_fill("elem_fill", ne);
+    auto setSlots = PS_LAMBDA(const lid_t& elm, const lid_t& ptcl, const bool& mask) {
+      if (mask)
+        new_slots(elem_offsets(elm) + Kokkos::atomic_fetch_add(&elem_fill(elm), 1)) = ptcl;
+    };
+    parallel_for(ps, setSlots, "setSlots");
+
+    //The k-th particle of an element in old moves to the k-th slot of the element
+    auto setDestinations = PS_LAMBDA(const lid_t& elm, const lid_t& ptcl, const bool& mask) {
+      ptcl_index(ptcl) = mask ? new_slots(elem_offsets(elm) + ptcl_index(ptcl)) : -1;
+    };
+    parallel_for(old, setDestinations, "setDestinations");
+    CopyParticlesToPS<PS, DataTypes>(old, ps, ptcl_index);
+    RecordTime(input.name + " convert", timer.seconds());
+    Kokkos::Profiling::popRegion();
+    return ps;
+  }
+}
@@ -15,6 +15,11 @@ namespace pumipic {
       csr->parallel_for(fn, s);
       return;
     }
+    HybridSCS<DataTypes, MemSpace>* hybrid = dynamic_cast<HybridSCS<DataTypes, MemSpace>*>(ps);
+    if (hybrid) {
+      hybrid->parallel_for(fn, s);
+      return;
+    }
     CabM<DataTypes, MemSpace>* cabm = dynamic_cast<CabM<DataTypes, MemSpace>*>(ps);
     if (cabm) {
       cabm->parallel_for(fn, s);
@@ -40,6 +45,10 @@ namespace pumipic {
     if (csr) {
       return csr->template copy<MSpace>();
     }
+    HybridSCS<DataTypes, MemSpace>* hybrid = dynamic_cast<HybridSCS<DataTypes, MemSpace>*>(old);
+    if (hybrid) {
+      return hybrid->template copy<MSpace>();
+    }
     CabM<DataTypes, MemSpace>* cabm = dynamic_cast<CabM<DataTypes, MemSpace>*>(old);
     if (cabm) {
       return cabm->template copy<MSpace>();
@@ -9,6 +9,7 @@ namespace pumipic {
 
     const auto btime = prebarrier();
     Kokkos::Profiling::pushRegion("scs_migrate");
+    ScopedMemoryPhase memory_phase("migrate");
     Kokkos::Timer timer;
 
     //Distributor size & rank for performing migration
@@ -61,6 +62,13 @@ namespace pumipic {
       }
     }
 
+    if (isCommVolumeEnabled()) {
+      for (int i = 0; i < comm_size; ++i) {
+        if (dist.rank_host(i) != comm_rank)
+          RecordCommVolume(COMM_MIGRATE_COUNTS, dist.rank_host(i), sizeof(lid_t));
+      }
+    }
+
     PS_Comm_Waitall<device_type>(num_recv_ranks, count_recv_requests, MPI_STATUSES_IGNORE);
     delete [] count_recv_requests;
 
@@ -74,10 +82,14 @@ namespace pumipic {
 
     //Create arrays for particles being sent
     lid_t np_send = offset_send_particles_host(comm_size);
+    static const int sent_series = RegisterSeries("particles sent");
+    RecordSeries(sent_series, np_send);
     kkLidView send_element(Kokkos::ViewAllocateWithoutInitializing("send_element"), np_send);
     MTVs send_particle;
     //Allocate views for each data type into send_particle[type]
     CreateViews<device_type, DataTypes>(send_particle, np_send);
+    SetTrackedMemory(this, name, MEM_MIGRATION,
+                     np_send * migrate_bytes_per_ptcl);
     kkLidView send_index(Kokkos::ViewAllocateWithoutInitializing("send_particle_index"), capacity());
     auto element_to_gid_local = element_to_gid;
     auto gatherParticlesToSend = PS_LAMBDA(const lid_t& element_id, const lid_t& particle_id, const bool& mask) {
@@ -118,6 +130,7 @@ namespace pumipic {
     //If no particles are being sent or received, perform rebuild
     if (num_sending_to == 0 && num_receiving_from == 0) {
       destroyViews<DataTypes, memory_space>(send_particle);
+      SetTrackedMemory(this, name, MEM_MIGRATION, 0);
       rebuild(new_element, new_particle_elements, new_particle_info);
       RecordTime(name +" particle migration", timer.seconds(), btime);
       Kokkos::Profiling::popRegion();
@@ -137,6 +150,8 @@ namespace pumipic {
     MTVs recv_particle;
     //Allocate views for each data type into recv_particle[type]
     CreateViews<device_type, DataTypes>(recv_particle, np_recv + new_ptcls);
+    SetTrackedMemory(this, name, MEM_MIGRATION, (np_send + np_recv + new_ptcls) *
+                     migrate_bytes_per_ptcl);
 
     //Get pointers to the data for MPI calls
     lid_t send_num = 0, recv_num = 0;
@@ -159,6 +174,8 @@ namespace pumipic {
         send_num++;
         SendViews<device_type, DataTypes>(send_particle, start_index, num_send, rank, 1,
                                           dist.mpi_comm(), send_requests + send_num);
+        RecordCommVolume(COMM_MIGRATE, rank,
+                         num_send * migrate_bytes_per_ptcl, num_types + 1);
         send_num+=num_types;
       }
       //Receiving
@@ -214,6 +231,7 @@ namespace pumipic {
     delete [] send_requests;
     destroyViews<DataTypes, memory_space>(send_particle);
     destroyViews<DataTypes, memory_space>(recv_particle);
+    SetTrackedMemory(this, name, MEM_MIGRATION, 0);
 
     RecordTime(name +" particle migration", timer.seconds() - temp, btime);
 
@@ -123,7 +123,12 @@ namespace pumipic {
     void SellCSigma<DataTypes,MemSpace>::rebuild(kkLidView new_element,
                                                  kkLidView new_particle_elements,
                                                  MTVs new_particles) {
+    static const int rebuild_timer = RegisterTimer("SCS rebuild");
+    static const int shuffle_series = RegisterSeries("SCS shuffles");
+    static const int full_rebuild_series = RegisterSeries("SCS full rebuilds");
     const auto btime = prebarrier();
+    ScopedTimer rebuild_scope(rebuild_timer);
+    ScopedMemoryPhase memory_phase("rebuild");
     Kokkos::Profiling::pushRegion("scs_rebuild");
     int comm_rank, comm_size;
     MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
@@ -131,6 +136,16 @@ namespace pumipic {
 
     Kokkos::Timer timer;
 
+    //The phase timers carry the structure name so they are registered once per structure
+    if (count_timer < 0) {
+      count_timer = RegisterTimer(name + " count active particles", true);
+      shuffle_timer = RegisterTimer(name + " shuffle attempt", true);
+      build_timer = RegisterTimer(name + " SCS specific building", true);
+      pstops_timer = RegisterTimer(name + " PSToPs", true);
+      new_ptcls_timer = RegisterTimer(name + " ViewsToViews", true);
+    }
+
+    StartTimer(count_timer);
     //Count particles including new and leaving
     kkLidView new_particles_per_elem("new_particles_per_elem", numRows());
     auto countNewParticles = PS_LAMBDA(const lid_t& element_id, const lid_t& particle_id, const bool& mask){
@@ -166,7 +181,7 @@ namespace pumipic {
       }, activePtcls);
 
     Kokkos::fence();
-    RecordTime(name + " count active particles", timer.seconds());
+    StopTimer(count_timer);
 
     //If there are no particles left, then destroy the structure
     if (activePtcls == 0) {
@@ -176,6 +191,7 @@ namespace pumipic {
         local_mask(particle_id) = false;
       };
       parallel_for(resetMask, "resetMask");
+      trackMemory();
 
       RecordTime(name +" rebuild", timer.seconds(), btime);
       Kokkos::Profiling::popRegion();
@@ -183,19 +199,23 @@ namespace pumipic {
       return;
     }
 
-    Kokkos::Timer time_shuffle;
+    StartTimer(shuffle_timer);
     //If tryShuffling is on and shuffling works then rebuild is complete
     if (tryShuffling && reshuffle(new_element, new_particle_elements, new_particles)) {
+      StopTimer(shuffle_timer);
+      RecordSeries(shuffle_series, 1);
+      trackMemory();
       RecordTime(name + " rebuild", timer.seconds(), btime);
       Kokkos::Profiling::popRegion();
       return;
     }
-    RecordTime(name + " shuffle attempt", time_shuffle.seconds());
+    StopTimer(shuffle_timer);
 
+    RecordSeries(full_rebuild_series, 1);
     lid_t new_num_ptcls = activePtcls;
 
     Kokkos::fence();
-    Kokkos::Timer time_build_structure;
+    StartTimer(build_timer);
     int new_C = chooseChunkHeight(C_max, new_particles_per_elem);
     int old_C = C_;
     C_ = new_C;
@@ -265,15 +285,15 @@ namespace pumipic {
     parallel_for(copySCS);
 
     Kokkos::fence();
-    RecordTime(name + " SCS specific building", time_build_structure.seconds());
+    StopTimer(build_timer);
 
-    Kokkos::Timer time_pstops;
+    StartTimer(pstops_timer);
     CopyPSToPS<SellCSigma<DataTypes, MemSpace>, DataTypes>(this, scs_data_swap, ptcl_data,
                                                            new_element, new_indices);
     Kokkos::fence();
-    RecordTime(name + " PSToPs", time_pstops.seconds());
+    StopTimer(pstops_timer);
 
-    Kokkos::Timer time_newPtcls;
+    StartTimer(new_ptcls_timer);
 
     //Add new particles
     lid_t num_new_ptcls = new_particle_elements.size();
@@ -289,7 +309,8 @@ namespace pumipic {
 
     if (new_particle_elements.size() > 0)
       CopyViewsToViews<kkLidView, DataTypes>(scs_data_swap, new_particles, new_particle_indices);
-    RecordTime(name + " ViewsToViews", time_newPtcls.seconds());
+    Kokkos::fence();
+    StopTimer(new_ptcls_timer);
 
     //set scs to point to new values
     C_ = new_C;
@@ -311,6 +332,7 @@ namespace pumipic {
     std::size_t tmp_size = current_size;
     current_size = swap_size;
     swap_size = tmp_size;
+    trackMemory();
 
     RecordTime(name +" rebuild", timer.seconds(), btime);
     Kokkos::Profiling::popRegion();
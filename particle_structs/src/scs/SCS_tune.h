@@ -0,0 +1,157 @@
+#pragma once
+namespace pumipic {
+  template<class DataTypes, typename MemSpace>
+  SCS_Tuning SellCSigma<DataTypes, MemSpace>::tuning() const {
+    SCS_Tuning t;
+    t.C_max = C_max;
+    t.sigma = sigma;
+    t.V = V_;
+    t.padding = pad_strat;
+    return t;
+  }
+
+  template<class DataTypes, typename MemSpace>
+  void SellCSigma<DataTypes, MemSpace>::retune(const SCS_Tuning& t) {
+    C_max = maxChunk<MemSpace>(t.C_max);
+    sigma = t.sigma;
+    V_ = t.V;
+    pad_strat = t.padding;
+
+    //Rebuild every particle into its current element
+    kkLidView same_element("same_element", capacity());
+    auto setSameElement = PS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                    const bool& mask) {
+      same_element(particle_id) = mask ? element_id : -1;
+    };
+    parallel_for(setSameElement, "setSameElement");
+    //Shuffling succeeds when nothing moves and would keep the old layout
+    const bool shuffle = tryShuffling;
+    tryShuffling = false;
+    rebuild(same_element);
+    tryShuffling = shuffle;
+  }
+
+  template<class DataTypes, typename MemSpace>
+  template <typename FunctionType>
+  double SellCSigma<DataTypes, MemSpace>::tuneCost(FunctionType& fn, const SCS_Tuning& t,
+                                                   const SCS_TuneSpace& space) {
+    retune(t);
+    double push_time = -1, rebuild_time = -1;
+    for (int i = 0; i < space.trials; ++i) {
+      Kokkos::fence();
+      Kokkos::Timer push_timer;
+      parallel_for(fn, "autotune_push");
+      Kokkos::fence();
+      const double push = push_timer.seconds();
+      Kokkos::Timer rebuild_timer;
+      retune(t);
+      Kokkos::fence();
+      const double rebuild = rebuild_timer.seconds();
+      if (push_time < 0 || push < push_time)
+        push_time = push;
+      if (rebuild_time < 0 || rebuild < rebuild_time)
+        rebuild_time = rebuild;
+    }
+    double cost = space.pushes_per_rebuild * push_time + rebuild_time;
+    MPI_Allreduce(MPI_IN_PLACE, &cost, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return cost;
+  }
+
+  template<class DataTypes, typename MemSpace>
+  template <typename FunctionType>
+  SCS_Tuning SellCSigma<DataTypes, MemSpace>::autotune(FunctionType& fn,
+                                                       const SCS_TuneSpace& space) {
+    Kokkos::Profiling::pushRegion("scs_autotune");
+    Kokkos::Timer timer;
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+    if (space.trials <= 0) {
+      fprintf(stderr, "[ERROR] SCS autotune requires at least one trial\n");
+      exit(EXIT_FAILURE);
+    }
+
+    //Candidates of each parameter, empty lists use the defaults around the current layout
+    const SCS_Tuning initial = tuning();
+    std::vector<lid_t> team_sizes = space.team_sizes;
+    if (team_sizes.empty())
+      team_sizes = {initial.C_max, initial.C_max / 4, initial.C_max / 16};
+    std::vector<lid_t> sigmas = space.sigmas;
+    if (sigmas.empty())
+      sigmas = {initial.sigma, 1, INT_MAX};
+    std::vector<lid_t> vertical_slices = space.vertical_slices;
+    if (vertical_slices.empty())
+      vertical_slices = {initial.V, 4, 32, 1024};
+    std::vector<PaddingStrategy> paddings = space.paddings;
+    if (paddings.empty())
+      paddings = {PAD_EVENLY, PAD_PROPORTIONALLY, PAD_INVERSELY};
+
+    //The rebuilds of the candidates are not part of the simulation, only the total is recorded
+    PauseRecording();
+    std::vector<SCS_Tuning> tried;
+    SCS_Tuning best = initial;
+    const double initial_cost = tuneCost(fn, best, space);
+    double best_cost = initial_cost;
+    tried.push_back(best);
+    const int num_params = 4;
+    for (int param = 0; param < num_params; ++param) {
+      std::vector<SCS_Tuning> candidates;
+      if (param == 0)
+        for (std::size_t i = 0; i < team_sizes.size(); ++i) {
+          candidates.push_back(best);
+          candidates.back().C_max = maxChunk<MemSpace>(team_sizes[i]);
+        }
+      else if (param == 1)
+        for (std::size_t i = 0; i < sigmas.size(); ++i) {
+          candidates.push_back(best);
+          candidates.back().sigma = sigmas[i];
+        }
+      else if (param == 2)
+        for (std::size_t i = 0; i < vertical_slices.size(); ++i) {
+          candidates.push_back(best);
+          candidates.back().V = vertical_slices[i];
+        }
+      else
+        for (std::size_t i = 0; i < paddings.size(); ++i) {
+          candidates.push_back(best);
+          candidates.back().padding = paddings[i];
+        }
+      for (std::size_t i = 0; i < candidates.size(); ++i) {
+        const SCS_Tuning& t = candidates[i];
+        if (t.C_max < 1 || t.sigma < 1 || t.V < 1 ||
+            std::find(tried.begin(), tried.end(), t) != tried.end())
+          continue;
+        tried.push_back(t);
+        const double cost = tuneCost(fn, t, space);
+        if (cost < best_cost) {
+          best = t;
+          best_cost = cost;
+        }
+      }
+    }
+    if (!(tuning() == best))
+      retune(best);
+    ResumeRecording();
+
+    if (!comm_rank) {
+      const char* padding_names[] = {"evenly", "proportionally", "inversely"};
+      fprintf(stderr, "SCS autotune chose C: %d sigma: %d V: %d padding: %s from %d "
+              "candidates, cost %.6f s (initial %.6f s)\n", C_, sigma, V_,
+              padding_names[pad_strat], (int)tried.size(), best_cost, initial_cost);
+    }
+    RecordTime(name + " autotune", timer.seconds());
+    Kokkos::Profiling::popRegion();
+    return best;
+  }
+
+  template<class DataTypes, typename MemSpace>
+  SCS_Tuning SellCSigma<DataTypes, MemSpace>::autotune(const SCS_TuneSpace& space) {
+    //Accumulate the active particles of each element, the access pattern of a deposition
+    kkLidView element_count("element_count", nElems());
+    auto accumulate = PS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                const bool& mask) {
+      if (mask)
+        Kokkos::atomic_increment<lid_t>(&element_count(element_id));
+    };
+    return autotune(accumulate, space);
+  }
+}
@@ -15,6 +15,8 @@
 #include "scs_input.hpp"
 #include <particle_structs.hpp>
 #include <ppTiming.hpp>
+#include <ppTimeSeries.hpp>
+#include <ppMemTracker.hpp>
 #include <sstream>
 
 namespace pumipic {
@@ -139,6 +141,26 @@ template <std::size_t N> using Slice = Segment<DataType<N>, device_type>;
   //Prints metrics of the SCS
   void printMetrics() const;
 
+  //Returns the current layout parameters
+  SCS_Tuning tuning() const;
+  /*
+    Rebuilds the SCS with the layout parameters in t
+    Particles keep their elements and data
+  */
+  void retune(const SCS_Tuning& t);
+  /*
+    Tries the candidates of space on the current particle distribution and adopts the layout
+    with the lowest cost, space.pushes_per_rebuild * parallel_for time + rebuild time
+    Parameters are searched one at a time (C, sigma, V then padding) keeping the best so far
+    Must be called by every process of MPI_COMM_WORLD, the cost is the maximum over processes
+    so all processes adopt the same layout
+      fn - the kernel to time, called space.trials times per candidate so it must be safe to
+           repeat. Without it a kernel that accumulates the particles of each element is timed
+  */
+  template <typename FunctionType>
+  SCS_Tuning autotune(FunctionType& fn, const SCS_TuneSpace& space);
+  SCS_Tuning autotune(const SCS_TuneSpace& space = SCS_TuneSpace());
+
   //Do not call these functions:
   int chooseChunkHeight(int maxC, kkLidView ptcls_per_elem);
   void sigmaSort(kkLidView& ptcls, kkLidView& index, lid_t num_elems,
@@ -153,6 +175,8 @@ template <std::size_t N> using Slice = Segment<DataType<N>, device_type>;
                          kkLidView& chunk_starts);
   void initSCSData(kkLidView chunk_widths, kkLidView particle_elements,
                    MTVs particle_info);
+  template <typename FunctionType>
+  double tuneCost(FunctionType& fn, const SCS_Tuning& t, const SCS_TuneSpace& space);
 
   template <typename DT, typename MSpace> friend class SellCSigma;
  private:
@@ -165,6 +189,7 @@ template <std::size_t N> using Slice = Segment<DataType<N>, device_type>;
   using ParticleStructure<DataTypes, MemSpace>::num_rows;
   using ParticleStructure<DataTypes, MemSpace>::ptcl_data;
   using ParticleStructure<DataTypes, MemSpace>::num_types;
+  using ParticleStructure<DataTypes, MemSpace>::migrate_bytes_per_ptcl;
 
   //The User defined kokkos policy
   PolicyType policy;
@@ -212,6 +237,12 @@ template <std::size_t N> using Slice = Segment<DataType<N>, device_type>;
   bool tryShuffling;
   //Metric Info
   lid_t num_empty_elements;
+  //Flat timers of the rebuild phases, registered on the first rebuild
+  int count_timer = -1;
+  int shuffle_timer = -1;
+  int build_timer = -1;
+  int pstops_timer = -1;
+  int new_ptcls_timer = -1;
 
   //Private construct function
   void construct(kkLidView ptcls_per_elem,
@@ -219,6 +250,8 @@ template <std::size_t N> using Slice = Segment<DataType<N>, device_type>;
                  kkLidView particle_elements,
                  MTVs particle_info);
   void destroy();
+  //Reports the live, padding and swap bytes to the memory tracker
+  void trackMemory() const;
 
   SellCSigma(lid_t Cmax) : ParticleStructure<DataTypes, MemSpace>(), policy(PolicyType(1000,Cmax)) {};
 
@@ -278,6 +311,7 @@ void SellCSigma<DataTypes, MemSpace>::construct(kkLidView ptcls_per_elem,
       initSCSData(chunk_starts, particle_elements, particle_info);
     }
   }
+  trackMemory();
   Kokkos::Profiling::popRegion();
 }
 
@@ -316,6 +350,8 @@ SellCSigma<DataTypes, MemSpace>::SellCSigma(Input_T& input) :
   pad_strat = input.padding_strat;
   always_realloc = input.always_realloc;
   construct(input.ppe, input.e_gids, input.particle_elms, input.p_info);
+  if (input.autotune)
+    autotune();
 }
 
 template <typename Space>
@@ -392,6 +428,20 @@ void SellCSigma<DataTypes, MemSpace>::destroy() {
 template<class DataTypes, typename MemSpace>
 SellCSigma<DataTypes, MemSpace>::~SellCSigma() {
   destroy();
+  ReleaseTrackedMemory(this);
+}
+
+template<class DataTypes, typename MemSpace>
+void SellCSigma<DataTypes, MemSpace>::trackMemory() const {
+  if (!isMemoryTracking())
+    return;
+  const std::size_t ptcl_bytes = DataTypes::memsize;
+  const std::size_t live = num_ptcls * ptcl_bytes;
+  //Includes the chunk padding, the extra padding and the particle mask
+  const std::size_t allocated = current_size * ptcl_bytes + capacity_ * sizeof(bool);
+  SetTrackedMemory(this, name, MEM_LIVE, live);
+  SetTrackedMemory(this, name, MEM_PADDING, allocated - live);
+  SetTrackedMemory(this, name, MEM_SWAP, always_realloc ? 0 : swap_size * ptcl_bytes);
 }
 
 
@@ -560,5 +610,6 @@ void SellCSigma<DataTypes, MemSpace>::parallel_for(FunctionType& fn, std::string
 #include "SCS_buildFns.h"
 #include "SCS_rebuild.h"
 #include "SCS_migrate.h"
+#include "SCS_tune.h"
 
 #endif
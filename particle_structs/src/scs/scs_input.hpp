@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include <particle_structs.hpp>
 namespace pumipic {
     enum PaddingStrategy {
@@ -9,6 +10,36 @@ namespace pumipic {
       //Divide padding inverse-proportionally (more particles in element = less padding)
       PAD_INVERSELY
     };
+
+  //Layout parameters of SellCSigma that can be changed after construction
+  struct SCS_Tuning {
+    //Maximum chunk height, the team size of parallel_for
+    lid_t C_max;
+    lid_t sigma;
+    lid_t V;
+    PaddingStrategy padding;
+  };
+  inline bool operator==(const SCS_Tuning& a, const SCS_Tuning& b) {
+    return a.C_max == b.C_max && a.sigma == b.sigma && a.V == b.V && a.padding == b.padding;
+  }
+
+  /* Candidates searched by SellCSigma::autotune
+     An empty list uses the default candidates around the current value:
+       team_sizes - C_max, C_max / 4, C_max / 16
+       sigmas - current, 1, INT_MAX
+       vertical_slices - current, 4, 32, 1024
+       paddings - all strategies
+  */
+  struct SCS_TuneSpace {
+    std::vector<lid_t> team_sizes;
+    std::vector<lid_t> sigmas;
+    std::vector<lid_t> vertical_slices;
+    std::vector<PaddingStrategy> paddings;
+    //Timed repetitions of each candidate, the fastest repetition is used
+    int trials = 3;
+    //Calls to parallel_for per rebuild, weighs the two costs
+    double pushes_per_rebuild = 1;
+  };
   template <class DataTypes, typename MemSpace>
   class SellCSigma;
 
@@ -35,6 +66,9 @@ namespace pumipic {
     //Padding strategy
     PaddingStrategy padding_strat = PAD_EVENLY;
 
+    //Search the layout parameters after construction with the default SCS_TuneSpace
+    bool autotune = false;
+
     //String identification for the particle structure
     std::string name;
 
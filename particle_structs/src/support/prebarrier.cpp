@@ -1,5 +1,7 @@
 #include <mpi.h>
 #include <Kokkos_Core.hpp>
+#include <ppImbalance.hpp>
+#include <ppTrace.hpp>
 namespace pumipic {
   namespace {
     static bool ps_prebarrier_enabled = false;
@@ -10,12 +12,14 @@ namespace pumipic {
   }
 
   double prebarrier() {
-    if(ps_prebarrier_enabled) {
+    if(ps_prebarrier_enabled && isPrebarrierStep()) {
+      ScopedTrace trace("prebarrier", TRACE_MPI);
       Kokkos::Timer timer;
       MPI_Barrier(MPI_COMM_WORLD);
       return timer.seconds();
     } else {
-      return 0.0;
+      //No sample this step, a measured wait is never negative
+      return -1.0;
     }
   }
 }
@@ -18,6 +18,22 @@ namespace pumipic {
                                                        DestinationIndexForParticle);
 */
   template <typename PS, typename... Types> struct CopyPSToPS;
+/* GatherParticles<ParticleStructure, DataTypes> - copies particle info of any structure
+                                                   into member type views
+     Usage: GatherParticles<ParticleStructure, MemberTypes>(ParticleStructure,
+                                                            DestinationMemberTypeViews,
+                                                            DestinationIndexForParticle);
+     Note: particles with a destination index of -1 are skipped
+*/
+  template <typename PS, typename... Types> struct GatherParticles;
+/* CopyParticlesToPS<ParticleStructure, DataTypes> - copies particle info of any structure
+                                                     into the slots of another structure
+     Usage: CopyParticlesToPS<ParticleStructure, MemberTypes>(SourceParticleStructure,
+                                                              DestinationParticleStructure,
+                                                              DestinationIndexForParticle);
+     Note: particles with a destination index of -1 are skipped
+*/
+  template <typename PS, typename... Types> struct CopyParticlesToPS;
 
   //Forward definition of parallel_for for particle structures
   template <typename FunctionType, typename DataTypes, typename MemSpace>
@@ -113,4 +129,101 @@ namespace pumipic {
       CopyPSToPSImpl<PS, Types...>(ps, dsts, srcs, new_element, ps_indices);
     }
   };
+
+  //Copies a particle from a structure slice into a member type view or another slice
+  template <class T, typename Space> struct CopySliceToView {
+    template <class Dst, class Slice>
+    PP_INLINE CopySliceToView(const Dst& dst, int dst_index,
+                              const Slice& src, int src_index) {
+      dst(dst_index) = src(src_index);
+    }
+  };
+  template <class T, typename Space, int N> struct CopySliceToView<T[N], Space> {
+    template <class Dst, class Slice>
+    PP_INLINE CopySliceToView(const Dst& dst, int dst_index,
+                              const Slice& src, int src_index) {
+      for (int i = 0; i < N; ++i)
+        dst(dst_index, i) = src(src_index, i);
+    }
+  };
+  template <class T, typename Space, int N, int M>
+  struct CopySliceToView<T[N][M], Space> {
+    template <class Dst, class Slice>
+    PP_INLINE CopySliceToView(const Dst& dst, int dst_index,
+                              const Slice& src, int src_index) {
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < M; ++j)
+          dst(dst_index, i, j) = src(src_index, i, j);
+    }
+  };
+  template <class T, typename Space, int N, int M, int P>
+  struct CopySliceToView<T[N][M][P], Space> {
+    template <class Dst, class Slice>
+    PP_INLINE CopySliceToView(const Dst& dst, int dst_index,
+                              const Slice& src, int src_index) {
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < M; ++j)
+          for (int k = 0; k < P; ++k)
+            dst(dst_index, i, j, k) = src(src_index, i, j, k);
+    }
+  };
+
+  //Gather Particles Templated Struct, uses slices so every structure is supported
+  template <typename PS, std::size_t N, typename... Types> struct GatherParticlesImpl;
+  template <typename PS, std::size_t N> struct GatherParticlesImpl<PS, N> {
+    GatherParticlesImpl(PS*, MemberTypeViewsConst, typename PS::kkLidView) {}
+  };
+  template <typename PS, std::size_t N, typename T, typename... Types>
+  struct GatherParticlesImpl<PS, N, T, Types...> {
+    typedef typename PS::device_type Device;
+    GatherParticlesImpl(PS* ps, MemberTypeViewsConst dsts,
+                        typename PS::kkLidView ps_indices) {
+      enclose(ps, dsts, ps_indices);
+    }
+    void enclose(PS* ps, MemberTypeViewsConst dsts, typename PS::kkLidView ps_indices) {
+      MemberTypeView<T, Device> dst = *static_cast<MemberTypeView<T, Device> const*>(dsts[0]);
+      auto src = ps->template get<N>();
+      auto gatherPtcls = PS_LAMBDA(int elm_id, int ptcl_id, bool mask) {
+        const int index = ps_indices(ptcl_id);
+        if (mask && index != -1)
+          CopySliceToView<T, Device>(dst, index, src, ptcl_id);
+      };
+      parallel_for(ps, gatherPtcls, "gatherParticles");
+      GatherParticlesImpl<PS, N + 1, Types...>(ps, dsts + 1, ps_indices);
+    }
+  };
+  template <typename PS, typename... Types> struct GatherParticles<PS, MemberTypes<Types...> > {
+    GatherParticles(PS* ps, MemberTypeViewsConst dsts, typename PS::kkLidView ps_indices) {
+      GatherParticlesImpl<PS, 0, Types...>(ps, dsts, ps_indices);
+    }
+  };
+
+  //Copy Particles To PS Templated Struct, uses slices so every pair of structures is supported
+  template <typename PS, std::size_t N, typename... Types> struct CopyParticlesToPSImpl;
+  template <typename PS, std::size_t N> struct CopyParticlesToPSImpl<PS, N> {
+    CopyParticlesToPSImpl(PS*, PS*, typename PS::kkLidView) {}
+  };
+  template <typename PS, std::size_t N, typename T, typename... Types>
+  struct CopyParticlesToPSImpl<PS, N, T, Types...> {
+    typedef typename PS::device_type Device;
+    CopyParticlesToPSImpl(PS* src_ps, PS* dst_ps, typename PS::kkLidView dst_indices) {
+      enclose(src_ps, dst_ps, dst_indices);
+    }
+    void enclose(PS* src_ps, PS* dst_ps, typename PS::kkLidView dst_indices) {
+      auto dst = dst_ps->template get<N>();
+      auto src = src_ps->template get<N>();
+      auto copyPtcls = PS_LAMBDA(int elm_id, int ptcl_id, bool mask) {
+        const int index = dst_indices(ptcl_id);
+        if (mask && index != -1)
+          CopySliceToView<T, Device>(dst, index, src, ptcl_id);
+      };
+      parallel_for(src_ps, copyPtcls, "copyParticlesToPS");
+      CopyParticlesToPSImpl<PS, N + 1, Types...>(src_ps, dst_ps, dst_indices);
+    }
+  };
+  template <typename PS, typename... Types> struct CopyParticlesToPS<PS, MemberTypes<Types...> > {
+    CopyParticlesToPS(PS* src_ps, PS* dst_ps, typename PS::kkLidView dst_indices) {
+      CopyParticlesToPSImpl<PS, 0, Types...>(src_ps, dst_ps, dst_indices);
+    }
+  };
 }
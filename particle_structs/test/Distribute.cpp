@@ -5,6 +5,14 @@
 #include <cstdlib>
 namespace {
 
+//Negative seeds draw a new seed from the clock on each call
+int fixed_seed = -1;
+int distribution_seed() {
+  if (fixed_seed >= 0)
+    return fixed_seed;
+  return std::chrono::system_clock::now().time_since_epoch().count();
+}
+
 void even_distribution(int ne, int np, int* ptcls_per_elem, std::vector<int>* ids) {
   int p;
   int r;
@@ -61,7 +69,7 @@ void uniform_distribution(int ne, int np, int* ptcls_per_elem, std::vector<int>*
   for (int i = 0; i < ne; ++i) {
     ptcls_per_elem[i] = 0;
   }
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   std::default_random_engine generator(seed);
   std::uniform_int_distribution<int> distribution(0, ne - 1);
 
@@ -76,7 +84,7 @@ void uniform_distribution(int ne, int np, int* ptcls_per_elem, std::vector<int>*
 
 void uniform_distribution(int ne, int np, Kokkos::View<int*> ptcls_per_elem,
                           Kokkos::View<int*> elem_per_ptcl,float) {
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed);
   Kokkos::parallel_for(np, KOKKOS_LAMBDA(const int index) {
     auto generator = pool.get_state();
@@ -94,7 +102,7 @@ void gaussian_distribution(int ne, int np, int* ptcls_per_elem, std::vector<int>
     ptcls_per_elem[i] = 0;
   }
   //Distribute based on normal distribution
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   std::default_random_engine generator(seed);
   std::normal_distribution<double> distribution(ne/2.0, ne/8.0);
   int index = 0;
@@ -112,7 +120,7 @@ void gaussian_distribution(int ne, int np, int* ptcls_per_elem, std::vector<int>
 
 void gaussian_distribution(int ne, int np, Kokkos::View<int*> ptcls_per_elem,
                            Kokkos::View<int*> elem_per_ptcl,float) {
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed);
   Kokkos::parallel_for(np, KOKKOS_LAMBDA(const int index) {
     auto generator = pool.get_state();
@@ -133,7 +141,7 @@ void exponential_distribution(int ne, int np, int* ptcls_per_elem, std::vector<i
     ptcls_per_elem[i] = 0;
   }
   //Distribute based on normal distribution
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   std::default_random_engine generator(seed);
   std::exponential_distribution<double> distribution(4);
   int index = 0;
@@ -157,7 +165,7 @@ void exponential_distribution(int ne, int np, Kokkos::View<int*> ptcls_per_elem,
   // Attempts to Convert a uniform rand variable to exponential
   float lambda = param; //rate parameter for exp func
 
-  int seed = 0; //fixed seed for consistent testing
+  int seed = fixed_seed >= 0 ? fixed_seed : 0; //fixed seed for consistent testing
   double freq_max = Kokkos::log(1.0/ne)*-1; //max value out of the log to scale with
 
   Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed);
@@ -213,7 +221,7 @@ void gitrm_distribution(int ne, int np, int* ptcls_per_elem, std::vector<int>* i
     ptcls_per_elem[i] = 0;
   }
 
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   std::default_random_engine generator(seed);
 
   std::uniform_int_distribution<int> distribution_first(0, cutoff-1);
@@ -242,7 +250,7 @@ void gitrm_distribution(int ne, int np, Kokkos::View<int*> ptcls_per_elem,
   int ptcls_first = Kokkos::ceil(np*percent);
   int ptcls_second = np - ptcls_first;
 
-  int seed = std::chrono::system_clock::now().time_since_epoch().count();
+  int seed = distribution_seed();
   Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed);
   Kokkos::parallel_for(ptcls_first, KOKKOS_LAMBDA(const int i) {
     auto generator = pool.get_state();
@@ -304,6 +312,10 @@ const char* distribute_name(int strat) {
   }
 }
 
+void set_distribute_seed(int seed) {
+  fixed_seed = seed;
+}
+
 bool distribute_elements(int ne, int strat, pumipic::gid_t* gids) {
   for (int i = 0; i < ne; ++i)
     gids[i] = i;
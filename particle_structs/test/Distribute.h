@@ -22,6 +22,9 @@ bool redistribute_particles(PS* ptcls, int strat, double percentMoved,
 
 const char* distribute_name(int strat);
 
+//Seeds the random distributions, a negative seed (the default) seeds from the clock
+void set_distribute_seed(int seed);
+
 
 //Define a seed so each call are roughly the "same" across different runs
 #define DISTRIBUTE_SEED 1024 * 1024
@@ -0,0 +1,81 @@
+#pragma once
+#include <particle_structs.hpp>
+#include "Distribute.h"
+#include <vector>
+
+//Particles store their element (member 0) and their id (member 1)
+typedef particle_structs::MemberTypes<int, int> ElemIdTypes;
+
+/*
+  The inputs of a structure holding `np` particles of ElemIdTypes distributed over `ne`
+  elements by distribution `strategy`, the particle info is freed on destruction
+*/
+struct ElemIdParticles {
+  typedef particle_structs::ParticleStructure<ElemIdTypes> PS;
+  ElemIdParticles(int ne, int np, int strategy)
+    : ptcls_per_elem("ptcls_per_elem", ne), element_gids("element_gids", 0),
+      particle_elements("particle_elements", np) {
+    int* ptcls_per_elem_h = new int[ne];
+    std::vector<int>* ids = new std::vector<int>[ne];
+    distribute_particles(ne, np, strategy, ptcls_per_elem_h, ids);
+    int* particle_elements_h = new int[np];
+    for (int i = 0; i < ne; ++i)
+      for (std::size_t j = 0; j < ids[i].size(); ++j)
+        particle_elements_h[ids[i][j]] = i;
+    particle_structs::hostToDevice(ptcls_per_elem, ptcls_per_elem_h);
+    particle_structs::hostToDevice(particle_elements, particle_elements_h);
+    delete [] particle_elements_h;
+    delete [] ids;
+    delete [] ptcls_per_elem_h;
+
+    particle_info = particle_structs::createMemberViews<ElemIdTypes>(np);
+    auto elem_info = particle_structs::getMemberView<ElemIdTypes, 0>(particle_info);
+    auto id_info = particle_structs::getMemberView<ElemIdTypes, 1>(particle_info);
+    auto elems = particle_elements;
+    Kokkos::parallel_for(np, KOKKOS_LAMBDA(const int i) {
+      elem_info(i) = elems(i);
+      id_info(i) = i;
+    });
+  }
+  ~ElemIdParticles() {
+    particle_structs::destroyViews<ElemIdTypes>(particle_info);
+  }
+  ElemIdParticles(const ElemIdParticles&) = delete;
+  ElemIdParticles& operator=(const ElemIdParticles&) = delete;
+
+  PS::kkLidView ptcls_per_elem;
+  PS::kkGidView element_gids;
+  PS::kkLidView particle_elements;
+  PS::MTVs particle_info;
+};
+
+//Checks every particle is in the element it stores and each id is present once
+template <class Structure>
+int checkParticles(Structure* structure, particle_structs::lid_t np, const char* label) {
+  typedef particle_structs::lid_t lid_t;
+  if (structure->nPtcls() != np) {
+    printf("[ERROR] %s: %d particles remain of %d\n", label, structure->nPtcls(), np);
+    return 1;
+  }
+  typename Structure::kkLidView fail("fail", 1);
+  typename Structure::kkLidView seen("seen", np);
+  auto elems = structure->template get<0>();
+  auto ids = structure->template get<1>();
+  auto check = PS_LAMBDA(const lid_t& elem, const lid_t& ptcl, const bool& mask) {
+    if (mask) {
+      if (elems(ptcl) != elem)
+        fail(0) = 1;
+      Kokkos::atomic_increment<lid_t>(&seen(ids(ptcl)));
+    }
+  };
+  particle_structs::parallel_for(structure, check, "check_particles");
+  lid_t missing = 0;
+  Kokkos::parallel_reduce("count_missing", np, KOKKOS_LAMBDA(const lid_t& i, lid_t& sum) {
+    sum += seen(i) != 1;
+  }, missing);
+  if (particle_structs::getLastValue(fail) || missing) {
+    printf("[ERROR] %s: particles changed elements or were duplicated\n", label);
+    return 1;
+  }
+  return 0;
+}
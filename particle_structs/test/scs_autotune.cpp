@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <Kokkos_Core.hpp>
+
+#include <particle_structs.hpp>
+#include "particle_fixture.hpp"
+#include "team_policy.hpp"
+
+namespace ps=particle_structs;
+using particle_structs::SellCSigma;
+using particle_structs::lid_t;
+typedef Kokkos::DefaultExecutionSpace exe_space;
+typedef SellCSigma<ElemIdTypes> SCS;
+typedef ps::SCS_Input<ElemIdTypes> Input;
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  Kokkos::initialize(argc, argv);
+
+  int fails = 0;
+  int ne = 100;
+  int np = 10000;
+  Kokkos::TeamPolicy<exe_space> po = pumipic::TeamPolicyAuto(128, 32);
+  {
+    ElemIdParticles ptcls(ne, np, 2);
+    Input input(po, ne, 1024, ne, np, ptcls.ptcls_per_elem, ptcls.element_gids,
+                ptcls.particle_elements, ptcls.particle_info);
+    SCS* scs = new SCS(input);
+    fails += checkParticles(scs, np, "construct");
+
+    //Rebuilding with new parameters keeps the particles
+    ps::SCS_Tuning t = scs->tuning();
+    t.sigma = 1;
+    t.V = 4;
+    t.padding = ps::PAD_INVERSELY;
+    scs->retune(t);
+    if (scs->V() != 4 || !(scs->tuning().sigma == 1)) {
+      printf("[ERROR] retune did not adopt V 4 and sigma 1\n");
+      ++fails;
+    }
+    fails += checkParticles(scs, np, "retune");
+
+    //The search adopts the best candidate it reports
+    ps::SCS_TuneSpace space;
+    space.trials = 1;
+    space.vertical_slices = {4, 1024};
+    ps::SCS_Tuning best = scs->autotune(space);
+    if (!(scs->tuning() == best)) {
+      printf("[ERROR] autotune did not adopt the reported parameters\n");
+      ++fails;
+    }
+    fails += checkParticles(scs, np, "autotune");
+
+    //Tuning at construction
+    input.autotune = true;
+    SCS* tuned = new SCS(input);
+    fails += checkParticles(tuned, np, "autotune construct");
+    delete tuned;
+    delete scs;
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+  if (fails == 0) {
+    printf("All tests passed\n");
+    return 0;
+  }
+  else {
+    printf("[ERROR] %d tests failed\n", fails);
+    return 1;
+  }
+}
@@ -32,6 +32,7 @@ int main(int argc, char* argv[]) {
   distribute_particles(ne, np, 2, ptcls_per_elem, ids);
   int C = 4;
   Kokkos::TeamPolicy<exe_space> po = pumipic::TeamPolicyAuto(128, C);
+  pumipic::EnableMemoryTracking();
 
   {
     SCS::kkLidView ptcls_per_elem_v("ptcls_per_elem_v", ne);
@@ -54,6 +55,13 @@ int main(int argc, char* argv[]) {
       printf("[ERROR] padInversely() failed\n");
     }
   }
+  //Every structure was deleted so no memory should remain tracked
+  pumipic::SummarizeMemory();
+  if (pumipic::trackedMemory() != 0) {
+    ++fails;
+    printf("[ERROR] %lu bytes remain tracked after deleting the structures\n",
+           pumipic::trackedMemory());
+  }
   Kokkos::finalize();
   MPI_Finalize();
   if (fails == 0) {
@@ -72,6 +80,22 @@ bool padEvenly(Input& input) {
   printf("\nPadEvenly\nNum Ptcls %d, Capacity %d Asked for %d\n",scs->nPtcls(), scs->capacity(),
          (lid_t)(scs->nPtcls() * (1.0 + input.shuffle_padding)));
   scs->printMetrics();
+  //The live bytes are the particle data of the active particles and the padding fills
+  //  the rest of the slots, every tracked byte belongs to the structure
+  const std::size_t live = pumipic::trackedMemory(scs, pumipic::MEM_LIVE);
+  const std::size_t padding = pumipic::trackedMemory(scs, pumipic::MEM_PADDING);
+  std::size_t owned = 0;
+  for (int c = 0; c < pumipic::NUM_MEMORY_CATEGORIES; ++c)
+    owned += pumipic::trackedMemory(scs, (pumipic::MemoryCategory)c);
+  if (live != scs->nPtcls() * Type::memsize ||
+      live + padding < scs->capacity() * Type::memsize ||
+      owned != pumipic::trackedMemory()) {
+    printf("[ERROR] Tracked %lu live and %lu padding bytes of %lu total for %d particles in "
+           "%d slots\n", live, padding, pumipic::trackedMemory(), scs->nPtcls(),
+           scs->capacity());
+    delete scs;
+    return false;
+  }
   auto vals = scs->get<0>();
   auto lamb = PS_LAMBDA(const lid_t& elem, const lid_t& ptcl, const bool& mask) {
     vals(ptcl) = mask;
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <sstream>
+#include <Kokkos_Core.hpp>
+
+#include <particle_structs.hpp>
+#include "particle_fixture.hpp"
+#include "team_policy.hpp"
+
+namespace ps=particle_structs;
+using particle_structs::lid_t;
+typedef Kokkos::DefaultExecutionSpace exe_space;
+typedef ps::ParticleStructure<ElemIdTypes> PS;
+typedef ps::PS_Input<ElemIdTypes> Input;
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  Kokkos::initialize(argc, argv);
+
+  int fails = 0;
+  int ne = 100;
+  int np = 10000;
+  Kokkos::TeamPolicy<exe_space> po = pumipic::TeamPolicyAuto(128, 32);
+  {
+    ElemIdParticles ptcls(ne, np, 2);
+    Input input(ps::PS_CSR, po, ne, np, ptcls.ptcls_per_elem, ptcls.element_gids,
+                ptcls.particle_elements, ptcls.particle_info);
+    std::istringstream config("# runtime layout\nstructure SCS\nV 32 padding inversely\n"
+                              "name converted");
+    if (!input.readConfig(config) || input.type != ps::PS_SCS || input.V != 32 ||
+        input.padding_strat != ps::PAD_INVERSELY || input.name != "converted") {
+      printf("[ERROR] readConfig did not set the options\n");
+      ++fails;
+    }
+    if (input.setOption("structure", "ell") || input.setOption("sigma", "0") ||
+        input.setOption("extra_padding", "5%") || input.setOption("color", "1")) {
+      printf("[ERROR] setOption accepted an invalid option\n");
+      ++fails;
+    }
+
+    PS* structure = ps::createParticleStructure(input);
+    fails += checkParticles(structure, np, "create");
+
+    std::vector<ps::StructureType> types = {ps::PS_CSR, ps::PS_HYBRID, ps::PS_SCS};
+#ifdef PP_ENABLE_CAB
+    types.push_back(ps::PS_CABM);
+    types.push_back(ps::PS_DPS);
+    types.push_back(ps::PS_SCS);
+#endif
+    for (std::size_t i = 0; i < types.size(); ++i) {
+      input.type = types[i];
+      PS* converted = ps::convertParticleStructure(structure, input);
+      delete structure;
+      structure = converted;
+      if (ps::getStructureType(structure) != types[i]) {
+        printf("[ERROR] converted to the wrong structure\n");
+        ++fails;
+      }
+      fails += checkParticles(structure, np, ps::getStructureName(types[i]));
+    }
+    delete structure;
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+  if (fails == 0) {
+    printf("All tests passed\n");
+    return 0;
+  }
+  else {
+    printf("[ERROR] %d tests failed\n", fails);
+    return 1;
+  }
+}
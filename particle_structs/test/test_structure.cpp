@@ -147,8 +147,18 @@ PS* buildNextStructure(int num, lid_t num_elems, lid_t num_ptcls, kkLidView ppe,
       return new ps::CSR<Types, MemSpace>(policy, num_elems, num_ptcls, ppe,
                                           element_gids, particle_elements, particle_info);
     }
-#ifdef PP_ENABLE_CAB
     else if (num == 3) {
+      //Hybrid with C = 32, V = 10 and elements of at least 4 particles in chunks
+      error_message = "HybridSCS (C=32, V=10, threshold=4)";
+      name = "hybrid_C32_V10_T4";
+      lid_t V = 10;
+      lid_t threshold = 4;
+      Kokkos::TeamPolicy<ExeSpace> policy = pumipic::TeamPolicyAuto(4, 32);
+      return new ps::HybridSCS<Types, MemSpace>(policy, V, threshold, num_elems, num_ptcls, ppe,
+                                                element_gids, particle_elements, particle_info);
+    }
+#ifdef PP_ENABLE_CAB
+    else if (num == 4) {
       //CabM
       error_message = "CabM";
       name = "cabm";
@@ -156,7 +166,7 @@ PS* buildNextStructure(int num, lid_t num_elems, lid_t num_ptcls, kkLidView ppe,
       return new ps::CabM<Types, MemSpace>(policy, num_elems, num_ptcls, ppe,
                                            element_gids, particle_elements, particle_info);
     }
-    else if (num == 4) {
+    else if (num == 5) {
       //DPS
       error_message = "DPS";
       name = "dps";
@@ -164,7 +174,7 @@ PS* buildNextStructure(int num, lid_t num_elems, lid_t num_ptcls, kkLidView ppe,
       return new ps::DPS<Types, MemSpace>(policy, num_elems, num_ptcls, ppe,
                                           element_gids, particle_elements, particle_info);
     }
-    else if (num == 5) {
+    else if (num == 6) {
       //DPS
       error_message = "DPS 2";
       name = "dps 2";
@@ -12,6 +12,10 @@ mpi_test(buildSCS 1 ./buildSCSTest)
 
 mpi_test(scs_padding 1 ./test_scs_padding)
 
+mpi_test(scs_autotune 1 ./test_scs_autotune)
+
+mpi_test(test_convert 1 ./test_convert)
+
 mpi_test(lambdaTest 1 ./lambdaTest)
 
 mpi_test(write_ptcl_small 1 ./write_particles 5 25 0 0 small_ptcls_e5_p25_r0)
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <cmath>
+#include <sstream>
+
+/*
+  Samples and percentile statistics shared by the benchmark drivers
+*/
+
+//Per trial times of one phase, already reduced to the slowest process
+struct PhaseSamples {
+  explicit PhaseSamples(const char* n) : name(n) {}
+  const char* name;
+  std::vector<double> seconds;
+  //Modeled bytes moved in each trial summed over the processes, empty if not modeled
+  std::vector<double> bytes;
+};
+
+//Nearest rank percentile of sorted samples
+inline double percentile(const std::vector<double>& sorted, double p) {
+  int rank = std::ceil(p / 100.0 * sorted.size()) - 1;
+  rank = std::max(0, std::min(rank, (int)sorted.size() - 1));
+  return sorted[rank];
+}
+
+inline double mean(const std::vector<double>& samples) {
+  double sum = 0;
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    sum += samples[i];
+  return samples.empty() ? 0 : sum / samples.size();
+}
+
+/*
+  Writes `"name": {"samples": n, "min": ..., "mean": ..., "p50": ..., "p90": ...,
+  "p99": ..., "max": ...` followed by `extra`, which holds additional `, "key": value` pairs
+*/
+inline void writePhase(std::ostream& out, const PhaseSamples& phase, bool last,
+                       const std::string& extra = "") {
+  std::vector<double> sorted = phase.seconds;
+  std::sort(sorted.begin(), sorted.end());
+  out << "    \"" << phase.name << "\": {\"samples\": " << sorted.size();
+  if (!sorted.empty())
+    out << ", \"min\": " << sorted.front()
+        << ", \"mean\": " << mean(sorted)
+        << ", \"p50\": " << percentile(sorted, 50)
+        << ", \"p90\": " << percentile(sorted, 90)
+        << ", \"p99\": " << percentile(sorted, 99)
+        << ", \"max\": " << sorted.back();
+  out << extra << "}" << (last ? "\n" : ",\n");
+}
+
+/*
+  Returns the `, "key": value` pairs of the achieved bandwidth of `phase`: the mean modeled
+  bytes over the median time and its fraction of `baseline_gbs`, if a baseline was measured
+*/
+inline std::string bandwidthStats(const PhaseSamples& phase, double baseline_gbs) {
+  if (phase.bytes.empty() || phase.seconds.empty())
+    return "";
+  std::vector<double> sorted = phase.seconds;
+  std::sort(sorted.begin(), sorted.end());
+  const double gbs = mean(phase.bytes) / percentile(sorted, 50) / 1e9;
+  std::stringstream extra;
+  extra.precision(9);
+  extra << ", \"bytes\": " << mean(phase.bytes) << ", \"gbs\": " << gbs;
+  if (baseline_gbs > 0)
+    extra << ", \"baseline_fraction\": " << gbs / baseline_gbs;
+  return extra.str();
+}
@@ -19,12 +19,13 @@ file = open(inputfile, "r")
 lines = file.readlines()
 file.close()
 
-edit_lines = ["Sell-32-ne rebuild", "Sell-32-ne pseudo-push", "Sell-32-ne particle migration",
-              "CSR rebuild", "CSR pseudo-push", "CSR particle migration",
-              "CabM rebuild", "CabM pseudo-push", "CabM particle migration",
-              "DPS rebuild", "DPS pseudo-push", "DPS particle migration" ]
+# timer names start with the structure name, Sell and Hybrid names include their parameters
+structure_names = ["Sell-", "CSR", "CabM", "DPS", "Hybrid-"]
+phases = ["rebuild", "pseudo-push", "particle"]
 
 elms = 0
+# ps_bench structure names in the order of the structure column read by graphing_scripts
+structures = ["scs", "csr", "cabm", "dps", "hybrid"]
 
 rebuild = open(rebuildfile, "w")
 push = open(pushfile, "w")
@@ -33,26 +34,31 @@ for line in lines:
     # command line
     if "./" in line:
         line = line.strip().split()
-        elm = line[1]
-        distribution = line[3]
-        structure = line[4]
+        elm = line[line.index("--elements") + 1]
+        distribution = line[line.index("--distribution") + 1]
+        # logs of runs without --structure used the default SellCSigma
+        structure = structures.index("scs")
+        if "--structure" in line:
+            structure = structures.index(line[line.index("--structure") + 1])
+        continue
     # timing
-    for check in edit_lines:
-        if check in line:
-            line = line.split()
-            function = line[1]
-            if "particle" in function:
-                function = function + line[2]
-                average = line[5]
-            else:
-                average = line[4]
-
-            if "rebuild" in function:
-                rebuild.write( "{0} {1} {2} {3}\n".format(structure, elm, distribution, average) )
-            elif "pseudo-push" in function:
-                push.write( "{0} {1} {2} {3}\n".format(structure, elm, distribution, average) )
-            elif "migration" in function and (n >= 5):
-                migrate.write( "{0} {1} {2} {3}\n".format(structure, elm, distribution, average) )
+    words = line.split()
+    if len(words) > 2 and words[1] in phases and \
+       any(words[0].startswith(name) for name in structure_names):
+        line = words
+        function = line[1]
+        if "particle" in function:
+            function = function + line[2]
+            average = line[5]
+        else:
+            average = line[4]
+
+        if "rebuild" in function:
+            rebuild.write( "{0} {1} {2} {3}\n".format(structure, elm, distribution, average) )
+        elif "pseudo-push" in function:
+            push.write( "{0} {1} {2} {3}\n".format(structure, elm, distribution, average) )
+        elif "migration" in function and (n >= 5):
+            migrate.write( "{0} {1} {2} {3}\n".format(structure, elm, distribution, average) )
 
 rebuild.close()
 push.close()
@@ -4,11 +4,15 @@
 
 typedef double Vector3d[3];
 typedef pumipic::MemberTypes<int, Vector3d, double> PerfTypes;
-typedef double Vector17d[17];
 typedef int Vector4i[4];
-typedef pumipic::MemberTypes<Vector17d, Vector4i, long int> PerfTypes160;
-typedef double Vector30d[30];
-typedef pumipic::MemberTypes<Vector30d, Vector4i, long int> PerfTypes264;
+/*
+  Benchmark payload of N doubles, 4 ints and a long int per particle
+  The payload is 8 * N + 24 bytes
+*/
+template <int N>
+using PerfPayload = pumipic::MemberTypes<double[N], Vector4i, long int>;
+typedef PerfPayload<17> PerfTypes160;
+typedef PerfPayload<30> PerfTypes264;
 
 typedef Kokkos::DefaultExecutionSpace ExeSpace;
 typedef typename ExeSpace::memory_space MemSpace;
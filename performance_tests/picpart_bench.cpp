@@ -0,0 +1,486 @@
+#include <Omega_h_build.hpp>
+#include <Omega_h_for.hpp>
+#include <pumipic_mesh.hpp>
+#include <pumipic_lb.hpp>
+#include <particle_structs.hpp>
+#include "team_policy.hpp"
+#include "benchStats.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <climits>
+#include <cmath>
+
+/*
+  Benchmark of the picpart construction, the comm array reductions and the particle balancer
+
+  A box mesh is built on every process and partitioned into slabs along x. Each trial times
+    construct         - pumipic::Mesh(Input&) including the BFS buffer and safe layers
+    balancer_setup    - ParticleBalancer(Mesh&)
+    reduce_<op>_w<n>  - Mesh::reduceCommArray of each Op on arrays of n values per entity
+    balance           - ParticleBalancer::repartition with the particles skewed to the first
+                        half of the processes
+  The slowest process of each trial is kept.
+
+  Strong and weak scaling tables are built up over runs with different numbers of processes:
+    mpirun -np 1 ./picpart_bench --scaling strong --table picparts
+    mpirun -np 4 ./picpart_bench --scaling strong --table picparts
+  appends the median times of each run to picparts_strong.csv and prints the table with the
+  efficiency relative to the run with the fewest processes. With --scaling weak the number of
+  cells grows with the processes so the elements per process are kept.
+
+  Usage: picpart_bench [options]
+    --dim 2|3                      mesh dimension (3)
+    --cells <n>                    cells along each side of the box for one process (16)
+    --scaling strong|weak          fixed or per process problem size (strong)
+    --buffer full|bfs|minimum      buffer method (bfs)
+    --safe full|bfs|minimum|none   safe zone method (bfs)
+    --buffer-layers <n>            BFS layers of the buffer (3)
+    --safe-layers <n>              BFS layers of the safe zone (1)
+    --reduce-dim <d>               entity dimension of the comm arrays (0)
+    --widths <n,n,...>             values per entity of the reductions (1,4,16)
+    --ppe <n>                      particles per core element on the lightly loaded processes (10)
+    --skew <x>                     load of the first half of the processes relative to the rest (4)
+    --warmup <n>                   untimed trials (1)
+    --trials <n>                   timed trials (5)
+    --table <prefix>               append to <prefix>_<scaling>.csv and print the table
+    --output <file>                JSON output file (stdout)
+*/
+
+namespace o = Omega_h;
+namespace p = pumipic;
+
+typedef p::MemberTypes<int> Particle;
+typedef p::ParticleStructure<Particle> PS;
+
+namespace {
+
+  struct PicpartOptions {
+    PicpartOptions() : dim(3), cells(16), scaling("strong"), buffer("bfs"), safe("bfs"),
+                       buffer_layers(3), safe_layers(1), reduce_dim(0), ppe(10), skew(4),
+                       warmup(1), trials(5) {
+      widths.push_back(1);
+      widths.push_back(4);
+      widths.push_back(16);
+    }
+    int dim;
+    int cells;
+    std::string scaling;
+    std::string buffer;
+    std::string safe;
+    int buffer_layers;
+    int safe_layers;
+    int reduce_dim;
+    std::vector<int> widths;
+    int ppe;
+    double skew;
+    int warmup;
+    int trials;
+    std::string table;
+    std::string output;
+  };
+
+  void usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [--dim 2|3] [--cells <n>] [--scaling strong|weak]\n"
+            "  [--buffer full|bfs|minimum] [--safe full|bfs|minimum|none]\n"
+            "  [--buffer-layers <n>] [--safe-layers <n>] [--reduce-dim <d>]\n"
+            "  [--widths <n,n,...>] [--ppe <n>] [--skew <x>] [--warmup <n>] [--trials <n>]\n"
+            "  [--table <prefix>] [--output <file>]\n", exe);
+  }
+
+  std::vector<int> parseList(const char* value) {
+    std::vector<int> list;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ','))
+      list.push_back(atoi(item.c_str()));
+    return list;
+  }
+
+  bool parseOptions(int argc, char* argv[], PicpartOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg(argv[i]);
+      if (i + 1 >= argc) {
+        fprintf(stderr, "[ERROR] Missing value for %s\n", arg.c_str());
+        return false;
+      }
+      const char* value = argv[++i];
+      if (arg == "--dim")
+        opts.dim = atoi(value);
+      else if (arg == "--cells")
+        opts.cells = atoi(value);
+      else if (arg == "--scaling")
+        opts.scaling = value;
+      else if (arg == "--buffer")
+        opts.buffer = value;
+      else if (arg == "--safe")
+        opts.safe = value;
+      else if (arg == "--buffer-layers")
+        opts.buffer_layers = atoi(value);
+      else if (arg == "--safe-layers")
+        opts.safe_layers = atoi(value);
+      else if (arg == "--reduce-dim")
+        opts.reduce_dim = atoi(value);
+      else if (arg == "--widths")
+        opts.widths = parseList(value);
+      else if (arg == "--ppe")
+        opts.ppe = atoi(value);
+      else if (arg == "--skew")
+        opts.skew = atof(value);
+      else if (arg == "--warmup")
+        opts.warmup = atoi(value);
+      else if (arg == "--trials")
+        opts.trials = atoi(value);
+      else if (arg == "--table")
+        opts.table = value;
+      else if (arg == "--output")
+        opts.output = value;
+      else {
+        fprintf(stderr, "[ERROR] Illegal argument: %s\n", arg.c_str());
+        return false;
+      }
+    }
+    if (opts.dim != 2 && opts.dim != 3) {
+      fprintf(stderr, "[ERROR] --dim must be 2 or 3\n");
+      return false;
+    }
+    if (opts.scaling != "strong" && opts.scaling != "weak") {
+      fprintf(stderr, "[ERROR] --scaling must be strong or weak\n");
+      return false;
+    }
+    if (p::Input::getMethod(opts.buffer) == p::Input::INVALID ||
+        p::Input::getMethod(opts.safe) == p::Input::INVALID) {
+      fprintf(stderr, "[ERROR] Unknown buffer or safe zone method\n");
+      return false;
+    }
+    if (opts.reduce_dim < 0 || opts.reduce_dim > opts.dim) {
+      fprintf(stderr, "[ERROR] --reduce-dim must be between 0 and the mesh dimension\n");
+      return false;
+    }
+    for (std::size_t i = 0; i < opts.widths.size(); ++i) {
+      if (opts.widths[i] <= 0) {
+        fprintf(stderr, "[ERROR] Reduction widths must be positive\n");
+        return false;
+      }
+    }
+    if (opts.cells <= 0 || opts.ppe < 0 || opts.skew <= 0) {
+      fprintf(stderr, "[ERROR] --cells and --skew must be positive and --ppe non-negative\n");
+      return false;
+    }
+    if (opts.trials <= 0 || opts.warmup < 0) {
+      fprintf(stderr, "[ERROR] --trials must be positive and --warmup non-negative\n");
+      return false;
+    }
+    return true;
+  }
+
+  //Builds the unit box and assigns each element to a slab along x
+  o::Mesh* buildPartitionedBox(o::Library& lib, int dim, int cells, int comm_size,
+                               o::Write<o::LO>& owners) {
+    o::Mesh* mesh = new o::Mesh(o::build_box(lib.self(), OMEGA_H_SIMPLEX, 1, 1,
+                                             dim == 3 ? 1 : 0, cells, cells,
+                                             dim == 3 ? cells : 0));
+    const auto elm2verts = mesh->ask_elem_verts();
+    const auto coords = mesh->coords();
+    owners = o::Write<o::LO>(mesh->nelems(), "owners");
+    auto setOwner = OMEGA_H_LAMBDA(const o::LO elm) {
+      o::Real x = 0;
+      for (int i = 0; i <= dim; ++i)
+        x += coords[elm2verts[elm * (dim + 1) + i] * dim] / (dim + 1);
+      const int owner = x * comm_size;
+      owners[elm] = owner < comm_size ? owner : comm_size - 1;
+    };
+    o::parallel_for(mesh->nelems(), setOwner, "setOwner");
+    return mesh;
+  }
+
+  double slowest(double seconds) {
+    double max_seconds;
+    MPI_Allreduce(&seconds, &max_seconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return max_seconds;
+  }
+
+  //Maximum over average of the values summed from each process
+  double imbalance(const std::vector<long>& per_rank) {
+    long total = 0, max = 0;
+    for (std::size_t i = 0; i < per_rank.size(); ++i) {
+      total += per_rank[i];
+      max = std::max(max, per_rank[i]);
+    }
+    return total ? max * (double)per_rank.size() / total : 1;
+  }
+
+  const char* opName(int op) {
+    const char* names[] = {"sum", "max", "min", "bcast"};
+    return names[op];
+  }
+
+  /*
+    Appends `row` to the scaling table and prints the table on rank 0
+    Times are medians in seconds, efficiency is against the row with the fewest processes
+  */
+  void appendTable(const std::string& filename, bool strong,
+                   const std::vector<std::string>& columns, const std::vector<double>& row) {
+    std::ifstream existing(filename.c_str());
+    const bool new_file = !existing;
+    std::vector<std::vector<double> > rows;
+    if (!new_file) {
+      std::string line;
+      std::getline(existing, line); //header
+      while (std::getline(existing, line)) {
+        std::vector<double> values;
+        std::stringstream ss(line);
+        std::string item;
+        while (std::getline(ss, item, ','))
+          values.push_back(atof(item.c_str()));
+        if (values.size() == row.size())
+          rows.push_back(values);
+      }
+    }
+    existing.close();
+    rows.push_back(row);
+    std::ofstream out(filename.c_str(), std::ios::app);
+    if (!out) {
+      fprintf(stderr, "[ERROR] Cannot open scaling table %s\n", filename.c_str());
+      return;
+    }
+    if (new_file) {
+      for (std::size_t i = 0; i < columns.size(); ++i)
+        out << columns[i] << (i + 1 < columns.size() ? "," : "\n");
+    }
+    for (std::size_t i = 0; i < row.size(); ++i)
+      out << std::setprecision(9) << row[i] << (i + 1 < row.size() ? "," : "\n");
+
+    //The first two columns are the processes and elements, the rest are times
+    std::size_t base = 0;
+    for (std::size_t i = 1; i < rows.size(); ++i) {
+      if (rows[i][0] < rows[base][0])
+        base = i;
+    }
+    std::stringstream table;
+    table << (strong ? "Strong" : "Weak") << " scaling (median seconds, efficiency)\n";
+    for (std::size_t c = 0; c < columns.size(); ++c)
+      table << std::setw(c < 2 ? 10 : 22) << columns[c];
+    table << '\n';
+    for (std::size_t r = 0; r < rows.size(); ++r) {
+      table << std::setw(10) << (long)rows[r][0] << std::setw(10) << (long)rows[r][1];
+      for (std::size_t c = 2; c < columns.size(); ++c) {
+        double efficiency = rows[base][c] / rows[r][c];
+        if (strong)
+          efficiency *= rows[base][0] / rows[r][0];
+        std::stringstream cell;
+        cell << std::scientific << std::setprecision(3) << rows[r][c] << " ("
+             << std::fixed << std::setprecision(2) << efficiency << ")";
+        table << std::setw(22) << cell.str();
+      }
+      table << '\n';
+    }
+    fprintf(stderr, "%s", table.str().c_str());
+  }
+}
+
+int main(int argc, char* argv[]) {
+  p::Library pic_lib(&argc, &argv);
+  o::Library& lib = pic_lib.omega_h_lib();
+  int comm_rank, comm_size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+  PicpartOptions opts;
+  if (!parseOptions(argc, argv, opts)) {
+    if (!comm_rank)
+      usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  int cells = opts.cells;
+  if (opts.scaling == "weak")
+    cells = std::round(opts.cells * std::pow((double)comm_size, 1.0 / opts.dim));
+
+  std::vector<PhaseSamples> phases;
+  phases.push_back(PhaseSamples("construct"));
+  phases.push_back(PhaseSamples("balancer_setup"));
+  std::vector<std::string> reduce_names;
+  for (int op = p::Mesh::SUM_OP; op <= p::Mesh::BCAST_OP; ++op) {
+    for (std::size_t w = 0; w < opts.widths.size(); ++w) {
+      std::stringstream name;
+      name << "reduce_" << opName(op) << "_w" << opts.widths[w];
+      reduce_names.push_back(name.str());
+    }
+  }
+  for (std::size_t i = 0; i < reduce_names.size(); ++i)
+    phases.push_back(PhaseSamples(reduce_names[i].c_str()));
+  phases.push_back(PhaseSamples("balance"));
+  const std::size_t balance_phase = phases.size() - 1;
+
+  int num_elems = 0;
+  double imbalance_before = 1, imbalance_after = 1;
+  {
+    std::unique_ptr<o::Mesh> mesh;
+    std::unique_ptr<p::Mesh> picparts;
+    std::unique_ptr<p::ParticleBalancer> balancer;
+    for (int trial = 0; trial < opts.warmup + opts.trials; ++trial) {
+      const bool timed = trial >= opts.warmup;
+      //The picparts reference the full mesh when it is the buffer so it is rebuilt each trial
+      balancer.reset();
+      picparts.reset();
+      o::Write<o::LO> owners;
+      mesh.reset(buildPartitionedBox(lib, opts.dim, cells, comm_size, owners));
+      num_elems = mesh->nelems();
+      p::Input input(*mesh, p::Input::PARTITION, owners, p::Input::getMethod(opts.buffer),
+                     p::Input::getMethod(opts.safe));
+      input.bufferBFSLayers = opts.buffer_layers;
+      input.safeBFSLayers = opts.safe_layers;
+
+      MPI_Barrier(MPI_COMM_WORLD);
+      Kokkos::Timer construct_timer;
+      picparts.reset(new p::Mesh(input));
+      Kokkos::fence();
+      const double construct_time = slowest(construct_timer.seconds());
+
+      MPI_Barrier(MPI_COMM_WORLD);
+      Kokkos::Timer balancer_timer;
+      balancer.reset(new p::ParticleBalancer(*picparts));
+      const double balancer_time = slowest(balancer_timer.seconds());
+      if (timed) {
+        phases[0].seconds.push_back(construct_time);
+        phases[1].seconds.push_back(balancer_time);
+      }
+    }
+
+    /* Comm array reductions of each op and width */
+    std::size_t phase = 2;
+    for (int op = p::Mesh::SUM_OP; op <= p::Mesh::BCAST_OP; ++op) {
+      for (std::size_t w = 0; w < opts.widths.size(); ++w, ++phase) {
+        o::Write<o::Real> array = picparts->createCommArray(opts.reduce_dim, opts.widths[w],
+                                                            (o::Real)comm_rank);
+        for (int trial = 0; trial < opts.warmup + opts.trials; ++trial) {
+          MPI_Barrier(MPI_COMM_WORLD);
+          Kokkos::Timer timer;
+          picparts->reduceCommArray(opts.reduce_dim, (p::Mesh::Op)op, array);
+          Kokkos::fence();
+          const double seconds = slowest(timer.seconds());
+          if (trial >= opts.warmup)
+            phases[phase].seconds.push_back(seconds);
+        }
+      }
+    }
+
+    /* Balance the particles skewed to the first half of the processes */
+    const int ne = (*picparts)->nelems();
+    const o::LOs elm_owners = picparts->entOwners(picparts->dim());
+    const int ppe = comm_rank < (comm_size + 1) / 2 ? opts.ppe * opts.skew : opts.ppe;
+    PS::kkLidView ptcls_per_elem("ptcls_per_elem", ne);
+    PS::kkGidView element_gids("element_gids", ne);
+    const o::GOs mesh_element_gids = picparts->globalIds(picparts->dim());
+    const int rank = comm_rank;
+    o::parallel_for(ne, OMEGA_H_LAMBDA(const int& i) {
+      ptcls_per_elem(i) = elm_owners[i] == rank ? ppe : 0;
+      element_gids(i) = mesh_element_gids[i];
+    });
+    int num_ptcls = 0;
+    Kokkos::parallel_reduce(ne, KOKKOS_LAMBDA(const int i, int& sum) {
+      sum += ptcls_per_elem(i);
+    }, num_ptcls);
+    Kokkos::TeamPolicy<Kokkos::DefaultExecutionSpace> policy = p::TeamPolicyAuto(10000, 32);
+    PS* ptcls = new p::SellCSigma<Particle>(policy, INT_MAX, 1024, ne, num_ptcls,
+                                            ptcls_per_elem, element_gids);
+    PS::kkLidView new_elems("new_elems", ptcls->capacity());
+    PS::kkLidView new_procs("new_procs", ptcls->capacity());
+    const auto is_safe = picparts->safeTag();
+    for (int trial = 0; trial < opts.warmup + opts.trials; ++trial) {
+      auto setDestinations = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+        new_elems(ptcl) = mask ? elm : -1;
+        new_procs(ptcl) = mask && !is_safe[elm] ? elm_owners[elm] : rank;
+      };
+      p::parallel_for(ptcls, setDestinations, "setDestinations");
+      MPI_Barrier(MPI_COMM_WORLD);
+      Kokkos::Timer timer;
+      balancer->repartition(*picparts, ptcls, 1.05, new_elems, new_procs);
+      Kokkos::fence();
+      const double seconds = slowest(timer.seconds());
+      if (trial >= opts.warmup)
+        phases[balance_phase].seconds.push_back(seconds);
+    }
+
+    //Imbalance of the particles before and after the plan of the last trial
+    o::Write<o::LO> sending(comm_size, 0, "sending");
+    auto countSending = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+      if (mask)
+        Kokkos::atomic_add(&(sending[new_procs(ptcl)]), 1);
+    };
+    p::parallel_for(ptcls, countSending, "countSending");
+    o::HostWrite<o::LO> sending_host(sending);
+    std::vector<long> local(comm_size), after(comm_size), before(comm_size, 0);
+    for (int i = 0; i < comm_size; ++i)
+      local[i] = sending_host[i];
+    MPI_Allreduce(local.data(), after.data(), comm_size, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    long np = num_ptcls;
+    MPI_Allgather(&np, 1, MPI_LONG, before.data(), 1, MPI_LONG, MPI_COMM_WORLD);
+    imbalance_before = imbalance(before);
+    imbalance_after = imbalance(after);
+    delete ptcls;
+    balancer.reset();
+    picparts.reset();
+  }
+
+  if (!comm_rank) {
+    std::ofstream file;
+    if (!opts.output.empty()) {
+      file.open(opts.output.c_str());
+      if (!file) {
+        fprintf(stderr, "[ERROR] Cannot open benchmark output %s\n", opts.output.c_str());
+        return EXIT_FAILURE;
+      }
+    }
+    std::ostream& out = opts.output.empty() ? std::cout : file;
+    out.precision(9);
+    out << "{\n"
+        << "  \"benchmark\": \"picpart_bench\",\n"
+        << "  \"scaling\": \"" << opts.scaling << "\",\n"
+        << "  \"dim\": " << opts.dim << ",\n"
+        << "  \"cells\": " << cells << ",\n"
+        << "  \"elements\": " << num_elems << ",\n"
+        << "  \"buffer\": \"" << opts.buffer << "\",\n"
+        << "  \"safe\": \"" << opts.safe << "\",\n"
+        << "  \"buffer_layers\": " << opts.buffer_layers << ",\n"
+        << "  \"safe_layers\": " << opts.safe_layers << ",\n"
+        << "  \"reduce_dim\": " << opts.reduce_dim << ",\n"
+        << "  \"skew\": " << opts.skew << ",\n"
+        << "  \"ranks\": " << comm_size << ",\n"
+        << "  \"warmup\": " << opts.warmup << ",\n"
+        << "  \"trials\": " << opts.trials << ",\n"
+        << "  \"units\": \"seconds\",\n"
+        << "  \"phases\": {\n";
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+      std::stringstream extra;
+      if (i == balance_phase)
+        extra << ", \"imbalance_before\": " << imbalance_before
+              << ", \"imbalance_after\": " << imbalance_after;
+      writePhase(out, phases[i], i + 1 == phases.size(), extra.str());
+    }
+    out << "  }\n}\n";
+
+    if (!opts.table.empty()) {
+      std::vector<std::string> columns;
+      std::vector<double> row;
+      columns.push_back("ranks");
+      row.push_back(comm_size);
+      columns.push_back("elements");
+      row.push_back(num_elems);
+      for (std::size_t i = 0; i < phases.size(); ++i) {
+        std::vector<double> sorted = phases[i].seconds;
+        std::sort(sorted.begin(), sorted.end());
+        columns.push_back(phases[i].name);
+        row.push_back(percentile(sorted, 50));
+      }
+      appendTable(opts.table + "_" + opts.scaling + ".csv", opts.scaling == "strong",
+                  columns, row);
+    }
+  }
+  return EXIT_SUCCESS;
+}
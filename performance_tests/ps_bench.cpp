@@ -0,0 +1,506 @@
+#include <particle_structs.hpp>
+#include <ppTiming.hpp>
+#include <Kokkos_Random.hpp>
+#include "perfTypes.hpp"
+#include "benchStats.hpp"
+#include "../particle_structs/test/Distribute.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cctype>
+#include <chrono>
+
+/*
+  Benchmark of the particle structures
+
+  Each trial runs one push-like sweep over every particle, a rebuild after moving particles
+  between elements and a migrate after moving particles between processes. The times of the
+  slowest process are collected over the trials that follow the warmup and written as JSON with
+  their percentiles.
+
+  The bytes each operation must move are modeled from the particle size (DataTypes::memsize),
+  the capacity and the particle counts:
+    push    - every slot of the capacity is written and the element data is read
+    rebuild - every particle is read and written once and the new elements are read
+    migrate - sent and received particles are packed and unpacked and the rest is rebuilt
+  The achieved GB/s is reported with its fraction of a STREAM triad run on every process at
+  the same time at startup, the same node bandwidth the operations compete for.
+
+  Usage: ps_bench --elements <n> --particles <n> [options]
+    --structure <name>             scs, csr, cabm, dps or hybrid (scs)
+    --distribution <0-4>           initial distribution strategy (1)
+    --payload 160|264              bytes per particle (160)
+    --move <fraction>              particles moved to a new element per rebuild (0.5)
+    --move-process <fraction>      particles moved to a new process per migrate (0.1)
+    --seed <n>                     seed of the distributions and process moves (clock)
+    --team-size <n>                team size, chunk width for SCS (32)
+    --vertical-slice <n>           SCS and hybrid vertical slicing (1024)
+    --dense-threshold <n>          particles that put an element in the hybrid chunks (32)
+    --sigma <n>                    SCS sorting range (number of elements)
+    --optimal                      use the tuned SCS parameters for the distribution
+    --autotune                     search the SCS parameters on the initial distribution
+    --warmup <n>                   untimed trials (5)
+    --trials <n>                   timed trials (100)
+    --stream-size <n>              doubles per array of the STREAM triad, 0 skips it (2^24)
+    --output <file>                JSON output file (stdout)
+*/
+
+namespace {
+
+  struct BenchOptions {
+    BenchOptions() : num_elems(-1), num_ptcls(-1), structure("scs"), strat(1), payload(160),
+                     percentMoved(0.5), percentMovedProcess(0.1), seed(-1), team_size(32),
+                     vert_slice(1024), sigma(-1), dense_threshold(32), optimal(false),
+                     autotune(false), warmup(5), trials(100), stream_size(1 << 24) {}
+    int num_elems;
+    int num_ptcls;
+    std::string structure;
+    int strat;
+    int payload;
+    double percentMoved;
+    double percentMovedProcess;
+    int seed;
+    int team_size;
+    int vert_slice;
+    int sigma;
+    int dense_threshold;
+    bool optimal;
+    bool autotune;
+    int warmup;
+    int trials;
+    int stream_size;
+    std::string output;
+  };
+
+  void usage(const char* exe) {
+    fprintf(stderr, "Usage: %s --elements <n> --particles <n>\n"
+            "  [--structure scs|csr|cabm|dps|hybrid] [--distribution <0-4>]\n"
+            "  [--payload 160|264] [--move <fraction>] [--move-process <fraction>]\n"
+            "  [--seed <n>] [--team-size <n>] [--vertical-slice <n>] [--sigma <n>]\n"
+            "  [--dense-threshold <n>] [--optimal] [--autotune]\n"
+            "  [--warmup <n>] [--trials <n>] [--stream-size <n>] [--output <file>]\n", exe);
+  }
+
+  bool parseOptions(int argc, char* argv[], BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg(argv[i]);
+      if (arg == "--optimal") {
+        opts.optimal = true;
+        continue;
+      }
+      if (arg == "--autotune") {
+        opts.autotune = true;
+        continue;
+      }
+      if (i + 1 >= argc) {
+        fprintf(stderr, "[ERROR] Missing value for %s\n", arg.c_str());
+        return false;
+      }
+      const char* value = argv[++i];
+      if (arg == "--elements")
+        opts.num_elems = atoi(value);
+      else if (arg == "--particles")
+        opts.num_ptcls = atoi(value);
+      else if (arg == "--structure") {
+        opts.structure = value;
+        std::transform(opts.structure.begin(), opts.structure.end(), opts.structure.begin(),
+                       ::tolower);
+      }
+      else if (arg == "--distribution")
+        opts.strat = atoi(value);
+      else if (arg == "--payload")
+        opts.payload = atoi(value);
+      else if (arg == "--move")
+        opts.percentMoved = atof(value);
+      else if (arg == "--move-process")
+        opts.percentMovedProcess = atof(value);
+      else if (arg == "--seed")
+        opts.seed = atoi(value);
+      else if (arg == "--team-size")
+        opts.team_size = atoi(value);
+      else if (arg == "--vertical-slice")
+        opts.vert_slice = atoi(value);
+      else if (arg == "--sigma")
+        opts.sigma = atoi(value);
+      else if (arg == "--dense-threshold")
+        opts.dense_threshold = atoi(value);
+      else if (arg == "--warmup")
+        opts.warmup = atoi(value);
+      else if (arg == "--trials")
+        opts.trials = atoi(value);
+      else if (arg == "--stream-size")
+        opts.stream_size = atoi(value);
+      else if (arg == "--output")
+        opts.output = value;
+      else {
+        fprintf(stderr, "[ERROR] Illegal argument: %s\n", arg.c_str());
+        return false;
+      }
+    }
+    if (opts.num_elems <= 0 || opts.num_ptcls < 0) {
+      fprintf(stderr, "[ERROR] --elements and --particles are required\n");
+      return false;
+    }
+    if (opts.percentMoved < 0 || opts.percentMoved > 1 ||
+        opts.percentMovedProcess < 0 || opts.percentMovedProcess > 1) {
+      fprintf(stderr, "[ERROR] Move fractions must be in [0, 1]\n");
+      return false;
+    }
+    if (opts.trials <= 0 || opts.warmup < 0) {
+      fprintf(stderr, "[ERROR] --trials must be positive and --warmup non-negative\n");
+      return false;
+    }
+    return true;
+  }
+
+  void writeJSON(std::ostream& out, const BenchOptions& opts, const std::string& name,
+                 int comm_size, const std::vector<PhaseSamples>& phases, double stream_gbs) {
+    out.precision(9);
+    out << "{\n"
+        << "  \"benchmark\": \"ps_bench\",\n"
+        << "  \"structure\": \"" << opts.structure << "\",\n"
+        << "  \"name\": \"" << name << "\",\n"
+        << "  \"payload_bytes\": " << opts.payload << ",\n"
+        << "  \"elements\": " << opts.num_elems << ",\n"
+        << "  \"particles\": " << opts.num_ptcls << ",\n"
+        << "  \"distribution\": \"" << distribute_name(opts.strat) << "\",\n"
+        << "  \"move\": " << opts.percentMoved << ",\n"
+        << "  \"move_process\": " << opts.percentMovedProcess << ",\n"
+        << "  \"seed\": " << opts.seed << ",\n"
+        << "  \"team_size\": " << opts.team_size << ",\n"
+        << "  \"vertical_slice\": " << opts.vert_slice << ",\n"
+        << "  \"sigma\": " << opts.sigma << ",\n"
+        << "  \"dense_threshold\": " << opts.dense_threshold << ",\n"
+        << "  \"autotune\": " << (opts.autotune ? "true" : "false") << ",\n"
+        << "  \"ranks\": " << comm_size << ",\n"
+        << "  \"warmup\": " << opts.warmup << ",\n"
+        << "  \"trials\": " << opts.trials << ",\n"
+        << "  \"stream_triad_gbs\": " << stream_gbs << ",\n"
+        << "  \"units\": \"seconds\",\n"
+        << "  \"phases\": {\n";
+    for (std::size_t i = 0; i < phases.size(); ++i)
+      writePhase(out, phases[i], i + 1 == phases.size(), bandwidthStats(phases[i], stream_gbs));
+    out << "  }\n}\n";
+  }
+
+  //Timer prefix of the structure, output_convert.py matches these names
+  std::string structureName(const BenchOptions& opts) {
+    if (opts.structure == "scs")
+      return opts.autotune ? "Sell-autotune" : "Sell-" + std::to_string(opts.team_size) + "-ne";
+    if (opts.structure == "csr")
+      return "CSR";
+    if (opts.structure == "hybrid")
+      return "Hybrid-" + std::to_string(opts.team_size) + "-" +
+        std::to_string(opts.dense_threshold);
+    if (opts.structure == "cabm")
+      return "CabM";
+    return "DPS";
+  }
+
+  //The tuned SCS parameters for the distributions
+  void setOptimalParameters(BenchOptions& opts) {
+    if (opts.strat == 1) {
+      opts.team_size = 512;
+      opts.vert_slice = 8;
+    }
+    else if (opts.strat == 2) {
+      opts.team_size = 512;
+      opts.vert_slice = 4;
+    }
+    else if (opts.strat == 3) {
+      opts.team_size = 128;
+      opts.vert_slice = 8;
+    }
+  }
+
+  //Times `seconds` as the maximum across processes
+  double slowest(double seconds) {
+    double max_seconds;
+    MPI_Allreduce(&seconds, &max_seconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return max_seconds;
+  }
+
+  //Sum of `bytes` across processes
+  double totalBytes(double bytes) {
+    double total;
+    MPI_Allreduce(&bytes, &total, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    return total;
+  }
+
+  /*
+    Best bandwidth in GB/s of the STREAM triad a = b + s * c run on every process at once
+    The bytes of all processes are divided by the time of the slowest one
+  */
+  double streamTriad(int n, int iterations) {
+    if (n <= 0)
+      return 0;
+    Kokkos::View<double*> a("stream_a", n);
+    Kokkos::View<double*> b("stream_b", n);
+    Kokkos::View<double*> c("stream_c", n);
+    Kokkos::deep_copy(b, 1.0);
+    Kokkos::deep_copy(c, 2.0);
+    const double scalar = 3.0;
+    double best = 0;
+    for (int i = 0; i < iterations; ++i) {
+      MPI_Barrier(MPI_COMM_WORLD);
+      Kokkos::Timer timer;
+      Kokkos::parallel_for("stream_triad", n, KOKKOS_LAMBDA(const int j) {
+        a(j) = b(j) + scalar * c(j);
+      });
+      Kokkos::fence();
+      const double seconds = slowest(timer.seconds());
+      best = std::max(best, totalBytes(3.0 * sizeof(double) * n) / seconds / 1e9);
+    }
+    return best;
+  }
+
+  template <int NumDoubles>
+  int runBenchmark(BenchOptions& opts) {
+    typedef PerfPayload<NumDoubles> DataTypes;
+    typedef pumipic::ParticleStructure<DataTypes, MemSpace> PSType;
+    int comm_rank, comm_size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+    /* Create initial distribution of particles */
+    kkLidView ppe("ptcls_per_elem", opts.num_elems);
+    kkLidView ptcl_elems("ptcl_elems", opts.num_ptcls);
+    kkGidView element_gids("element_gids", opts.num_elems);
+    Kokkos::parallel_for(opts.num_elems, KOKKOS_LAMBDA(const int i) {
+        element_gids(i) = i;
+    });
+    if (!comm_rank)
+      fprintf(stderr, "Generating particle distribution with strategy: %s\n",
+              distribute_name(opts.strat));
+    distribute_particles(opts.num_elems, opts.num_ptcls, opts.strat, ppe, ptcl_elems);
+
+    const pumipic::StructureType type = pumipic::getStructureType(opts.structure);
+    if (type == pumipic::PS_INVALID) {
+      fprintf(stderr, "[ERROR] Unknown structure %s\n", opts.structure.c_str());
+      return EXIT_FAILURE;
+    }
+    if (type == pumipic::PS_SCS && opts.optimal)
+      setOptimalParameters(opts);
+    const std::string name = structureName(opts);
+    Kokkos::TeamPolicy<ExeSpace> policy(32, opts.team_size);
+    pumipic::PS_Input<DataTypes, MemSpace> input(type, policy, opts.num_elems, opts.num_ptcls,
+                                                 ppe, element_gids);
+    input.name = name;
+    input.sigma = opts.sigma > 0 ? opts.sigma : opts.num_elems;
+    input.V = opts.vert_slice;
+    input.dense_threshold = opts.dense_threshold;
+    input.autotune = opts.autotune;
+    PSType* ptcls;
+    try {
+      ptcls = pumipic::createParticleStructure(input);
+    }
+    catch (int) {
+      return EXIT_FAILURE;
+    }
+    //Report the parameters the search adopted
+    if (type == pumipic::PS_SCS) {
+      const pumipic::SCS_Tuning tuning =
+        dynamic_cast<pumipic::SellCSigma<DataTypes, MemSpace>*>(ptcls)->tuning();
+      opts.team_size = tuning.C_max;
+      opts.vert_slice = tuning.V;
+      opts.sigma = tuning.sigma;
+    }
+
+    const double stream_gbs = streamTriad(opts.stream_size, 10);
+    if (!comm_rank && stream_gbs > 0)
+      fprintf(stderr, "STREAM triad baseline %.2f GB/s\n", stream_gbs);
+    const double memsize = DataTypes::memsize;
+    const double lid_size = sizeof(pumipic::lid_t);
+
+    // Per element data to access in pseudoPush
+    Kokkos::View<double*> parentElmData("parentElmData", ptcls->nElems());
+    Kokkos::parallel_for("parent_elem_data", parentElmData.size(),
+        KOKKOS_LAMBDA(const int& e){
+      parentElmData(e) = Kokkos::sqrt((double)e) * e;
+    });
+
+    //Without a seed the process moves are drawn from the clock like the distributions
+    const int seed = opts.seed >= 0 ? opts.seed :
+      std::chrono::system_clock::now().time_since_epoch().count();
+    Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed);
+    std::vector<int> other_ranks;
+    for (int i = 0; i < comm_size; i++) {
+      if (i != comm_rank)
+        other_ranks.push_back(i);
+    }
+    kkLidView other_ranks_d("other_ranks_d", other_ranks.size());
+    if (!other_ranks.empty())
+      pumipic::hostToDevice(other_ranks_d, other_ranks.data());
+    const double percentMoved = opts.percentMoved;
+    const double percentMovedProcess = opts.percentMovedProcess;
+
+    std::vector<PhaseSamples> phases;
+    phases.push_back(PhaseSamples("push"));
+    phases.push_back(PhaseSamples("rebuild"));
+    phases.push_back(PhaseSamples("migrate"));
+
+    if (!comm_rank)
+      fprintf(stderr, "Running %d warmup and %d timed trials on structure %s\n",
+              opts.warmup, opts.trials, name.c_str());
+    for (int trial = 0; trial < opts.warmup + opts.trials; ++trial) {
+      const bool timed = trial >= opts.warmup;
+
+      /* Push-like sweep over every particle */
+      auto dbls = ptcls->template get<0>();
+      auto nums = ptcls->template get<1>();
+      auto lint = ptcls->template get<2>();
+      auto pseudoPush = PS_LAMBDA(const int& e, const int& p, const bool& mask) {
+        if (mask) {
+          for (int i = 0; i < NumDoubles; i++) {
+            dbls(p,i) = 10.3;
+            dbls(p,i) = dbls(p,i) * dbls(p,i) * dbls(p,i) / Kokkos::sqrt((double)p) / Kokkos::sqrt((double)e) + parentElmData(e);
+          }
+          for (int i = 0; i < 4; i++) {
+            nums(p,i) = 4*p + i;
+          }
+          lint(p) = p;
+        }
+        else {
+          for (int i = 0; i < NumDoubles; i++) {
+            dbls(p,i) = 0;
+          }
+          for (int i = 0; i < 4; i++) {
+            nums(p,i) = -1;
+          }
+          lint(p) = 0;
+        }
+      };
+      Kokkos::fence();
+      Kokkos::Timer push_timer;
+      ps::parallel_for(ptcls, pseudoPush, "pseudo push");
+      Kokkos::fence();
+      const double push_time = push_timer.seconds();
+      pumipic::RecordTime(name + " pseudo-push", push_time);
+      const double push_bytes = ptcls->capacity() * memsize +
+        ptcls->nElems() * sizeof(double);
+
+      /* Rebuild after moving particles between elements */
+      kkLidView new_elms("new elems", ptcls->capacity());
+      redistribute_particles(ptcls, opts.strat, percentMoved, new_elms);
+      Kokkos::fence();
+      const double rebuild_bytes = 2 * ptcls->nPtcls() * memsize +
+        ptcls->capacity() * lid_size;
+      Kokkos::Timer rebuild_timer;
+      ptcls->rebuild(new_elms);
+      Kokkos::fence();
+      const double rebuild_time = rebuild_timer.seconds();
+
+      /* Migrate after moving particles between elements and processes */
+      kkLidView migrate_elms("migrate elems", ptcls->capacity());
+      redistribute_particles(ptcls, opts.strat, percentMoved, migrate_elms);
+      kkLidView new_process("new_process", ptcls->capacity());
+      const int num_other = other_ranks.size();
+      auto to_new_processes = PS_LAMBDA(const int& e, const int& p, const bool& mask) {
+        new_process(p) = comm_rank;
+        if (mask && num_other > 0) {
+          auto generator = pool.get_state();
+          double prob = generator.drand(1.0);
+          if (prob < percentMovedProcess)
+            new_process(p) = other_ranks_d(generator.urand(num_other));
+          pool.free_state(generator);
+        }
+      };
+      pumipic::parallel_for(ptcls, to_new_processes, "to_new_processes");
+      kkLidView sent_count("sent_count", 1);
+      auto countSent = PS_LAMBDA(const int& e, const int& p, const bool& mask) {
+        if (mask && new_process(p) != comm_rank)
+          Kokkos::atomic_add(&(sent_count(0)), 1);
+      };
+      pumipic::parallel_for(ptcls, countSent, "countSent");
+      const int num_sent = pumipic::getLastValue(sent_count);
+      const int ptcls_before = ptcls->nPtcls();
+      const double migrate_read_bytes = 2 * ptcls->capacity() * lid_size;
+      Kokkos::fence();
+      Kokkos::Timer migrate_timer;
+      ptcls->migrate(migrate_elms, new_process);
+      Kokkos::fence();
+      const double migrate_time = migrate_timer.seconds();
+      const int num_received = ptcls->nPtcls() - (ptcls_before - num_sent);
+      const double migrate_bytes = migrate_read_bytes +
+        2 * (num_sent + num_received) * memsize + 2 * ptcls->nPtcls() * memsize;
+
+      const double push_max = slowest(push_time);
+      const double rebuild_max = slowest(rebuild_time);
+      const double migrate_max = slowest(migrate_time);
+      const double push_total = totalBytes(push_bytes);
+      const double rebuild_total = totalBytes(rebuild_bytes);
+      const double migrate_total = totalBytes(migrate_bytes);
+      if (timed) {
+        phases[0].seconds.push_back(push_max);
+        phases[1].seconds.push_back(rebuild_max);
+        phases[2].seconds.push_back(migrate_max);
+        phases[0].bytes.push_back(push_total);
+        phases[1].bytes.push_back(rebuild_total);
+        phases[2].bytes.push_back(migrate_total);
+      }
+    }
+    delete ptcls;
+
+    if (!comm_rank) {
+      if (opts.output.empty())
+        writeJSON(std::cout, opts, name, comm_size, phases, stream_gbs);
+      else {
+        std::ofstream out(opts.output.c_str());
+        if (!out) {
+          fprintf(stderr, "[ERROR] Cannot open benchmark output %s\n", opts.output.c_str());
+          return EXIT_FAILURE;
+        }
+        writeJSON(out, opts, name, comm_size, phases, stream_gbs);
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  Kokkos::initialize(argc, argv);
+  MPI_Init(&argc, &argv);
+  int comm_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+
+  BenchOptions opts;
+  if (!parseOptions(argc, argv, opts)) {
+    if (!comm_rank)
+      usage(argv[0]);
+    Kokkos::finalize();
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  if (opts.seed >= 0)
+    set_distribute_seed(opts.seed);
+
+  if (!comm_rank) {
+    fprintf(stderr, "Test Command:\n");
+    for (int i = 0; i < argc; i++) {
+      fprintf(stderr, " %s", argv[i]);
+    }
+    fprintf(stderr, "\n");
+  }
+
+  /* Enable timing on every process */
+  pumipic::SetTimingVerbosity(0);
+  pumipic::enable_prebarrier();
+
+  int status = EXIT_FAILURE;
+  { // Begin Kokkos region
+    if (opts.payload == 160)
+      status = runBenchmark<17>(opts);
+    else if (opts.payload == 264)
+      status = runBenchmark<30>(opts);
+    else if (!comm_rank)
+      fprintf(stderr, "[ERROR] Unsupported payload %d, use 160 or 264\n", opts.payload);
+  } // end Kokkos region
+
+  pumipic::SummarizeTime();
+  Kokkos::finalize();
+  MPI_Finalize();
+  return status;
+}
@@ -0,0 +1,456 @@
+#include <Omega_h_build.hpp>
+#include <Omega_h_mesh.hpp>
+#include <Kokkos_Random.hpp>
+#include <pumipic_library.hpp>
+#include <pumipic_adjacency.hpp>
+#include <ppTiming.hpp>
+#include <ppTimeSeries.hpp>
+#include "team_policy.hpp"
+#include "benchStats.hpp"
+#include "../particle_structs/test/Distribute.h"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+
+/*
+  Benchmark of the adjacency search on synthetic box meshes
+
+  A box of cells^dim cells is built with Omega_h and particles are seeded at random points
+  inside their parent element. Targets are then placed with one of the displacement modes:
+    element - a new point in the same element
+    hops    - a point within `--hops` cell widths in a random direction
+    long    - a point a quarter to three quarters of the box away
+    wall    - a point outside the box, the search ends on the boundary
+    mixed   - a quarter of the particles in each of the modes above
+  Each mode is searched `--trials` times after `--warmup` untimed searches. The JSON output has
+  the search time percentiles of the slowest process, the throughput in particles per second
+  and the number of search loops.
+
+  Usage: search_bench [options]
+    --dim 2|3                      mesh dimension (3)
+    --cells <n>                    cells along each side of the box (16)
+    --particles <n>                particles per process (100000)
+    --distribution <0-4>           initial distribution strategy (0)
+    --displacement <mode>|all      displacement mode or every mode but mixed (all)
+    --hops <n>                     maximum cells crossed by the hops mode (2)
+    --search adjacency|3d|2d       search_mesh, search_mesh_3d or search_mesh_2d (adjacency)
+    --intersection                 compute boundary intersections in search_mesh
+    --seed <n>                     seed of the particle positions (0)
+    --warmup <n>                   untimed searches per mode (2)
+    --trials <n>                   timed searches per mode (20)
+    --output <file>                JSON output file (stdout)
+*/
+
+namespace o = Omega_h;
+namespace p = pumipic;
+
+using p::Vector3d;
+//Current position, target position and particle id
+typedef p::MemberTypes<Vector3d, Vector3d, int> Particle;
+typedef p::ParticleStructure<Particle> PS;
+
+namespace {
+
+  enum Displacement {
+    DISP_ELEMENT,
+    DISP_HOPS,
+    DISP_LONG,
+    DISP_WALL,
+    DISP_MIXED,
+    NUM_DISPLACEMENTS
+  };
+  const char* displacement_names[NUM_DISPLACEMENTS] = {"element", "hops", "long", "wall",
+                                                       "mixed"};
+
+  struct SearchOptions {
+    SearchOptions() : dim(3), cells(16), num_ptcls(100000), strat(0), displacement("all"),
+                      hops(2), search("adjacency"), intersection(false), seed(0), warmup(2),
+                      trials(20) {}
+    int dim;
+    int cells;
+    int num_ptcls;
+    int strat;
+    std::string displacement;
+    int hops;
+    std::string search;
+    bool intersection;
+    int seed;
+    int warmup;
+    int trials;
+    std::string output;
+  };
+
+  void usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [--dim 2|3] [--cells <n>] [--particles <n>]\n"
+            "  [--distribution <0-4>] [--displacement element|hops|long|wall|mixed|all]\n"
+            "  [--hops <n>] [--search adjacency|3d|2d] [--intersection] [--seed <n>]\n"
+            "  [--warmup <n>] [--trials <n>] [--output <file>]\n", exe);
+  }
+
+  bool parseOptions(int argc, char* argv[], SearchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg(argv[i]);
+      if (arg == "--intersection") {
+        opts.intersection = true;
+        continue;
+      }
+      if (i + 1 >= argc) {
+        fprintf(stderr, "[ERROR] Missing value for %s\n", arg.c_str());
+        return false;
+      }
+      const char* value = argv[++i];
+      if (arg == "--dim")
+        opts.dim = atoi(value);
+      else if (arg == "--cells")
+        opts.cells = atoi(value);
+      else if (arg == "--particles")
+        opts.num_ptcls = atoi(value);
+      else if (arg == "--distribution")
+        opts.strat = atoi(value);
+      else if (arg == "--displacement")
+        opts.displacement = value;
+      else if (arg == "--hops")
+        opts.hops = atoi(value);
+      else if (arg == "--search")
+        opts.search = value;
+      else if (arg == "--seed")
+        opts.seed = atoi(value);
+      else if (arg == "--warmup")
+        opts.warmup = atoi(value);
+      else if (arg == "--trials")
+        opts.trials = atoi(value);
+      else if (arg == "--output")
+        opts.output = value;
+      else {
+        fprintf(stderr, "[ERROR] Illegal argument: %s\n", arg.c_str());
+        return false;
+      }
+    }
+    if (opts.dim != 2 && opts.dim != 3) {
+      fprintf(stderr, "[ERROR] --dim must be 2 or 3\n");
+      return false;
+    }
+    if (opts.cells <= 0 || opts.num_ptcls <= 0 || opts.hops <= 0) {
+      fprintf(stderr, "[ERROR] --cells, --particles and --hops must be positive\n");
+      return false;
+    }
+    if ((opts.search == "3d" && opts.dim != 3) || (opts.search == "2d" && opts.dim != 2) ||
+        (opts.search != "adjacency" && opts.search != "3d" && opts.search != "2d")) {
+      fprintf(stderr, "[ERROR] Search %s is not available for dimension %d\n",
+              opts.search.c_str(), opts.dim);
+      return false;
+    }
+    if (opts.trials <= 0 || opts.warmup < 0) {
+      fprintf(stderr, "[ERROR] --trials must be positive and --warmup non-negative\n");
+      return false;
+    }
+    return true;
+  }
+
+  //The displacement modes selected by `name`, empty if the name is unknown
+  std::vector<int> selectDisplacements(const std::string& name) {
+    std::vector<int> modes;
+    if (name == "all") {
+      for (int i = 0; i < DISP_MIXED; ++i)
+        modes.push_back(i);
+    }
+    for (int i = 0; i < NUM_DISPLACEMENTS; ++i) {
+      if (name == displacement_names[i])
+        modes.push_back(i);
+    }
+    return modes;
+  }
+
+  /*
+    Places each particle at a random point inside its parent element
+    The barycentric weights are kept away from zero so the point is strictly inside
+  */
+  void setOrigins(o::Mesh& mesh, PS* ptcls, int seed) {
+    const int dim = mesh.dim();
+    const auto elm2verts = mesh.ask_elem_verts();
+    const auto coords = mesh.coords();
+    auto x = ptcls->get<0>();
+    auto pids = ptcls->get<2>();
+    Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed);
+    auto setPositions = PS_LAMBDA(const int& e, const int& pid, const bool& mask) {
+      if (mask) {
+        auto generator = pool.get_state();
+        double weights[4];
+        double sum = 0;
+        for (int i = 0; i <= dim; ++i) {
+          weights[i] = 0.05 + generator.drand(1.0);
+          sum += weights[i];
+        }
+        pool.free_state(generator);
+        for (int d = 0; d < 3; ++d)
+          x(pid, d) = 0;
+        for (int i = 0; i <= dim; ++i) {
+          const o::LO vert = elm2verts[e * (dim + 1) + i];
+          for (int d = 0; d < dim; ++d)
+            x(pid, d) += weights[i] / sum * coords[vert * dim + d];
+        }
+        pids(pid) = pid;
+      }
+    };
+    p::parallel_for(ptcls, setPositions, "setOrigins");
+  }
+
+  /*
+    Sets the target of each particle for displacement `mode` in the unit box
+    `cell` is the width of one cell of the box
+  */
+  void setTargets(o::Mesh& mesh, PS* ptcls, int mode, int hops, double cell, int seed) {
+    const int dim = mesh.dim();
+    const auto elm2verts = mesh.ask_elem_verts();
+    const auto coords = mesh.coords();
+    auto x = ptcls->get<0>();
+    auto xtgt = ptcls->get<1>();
+    Kokkos::Random_XorShift64_Pool<Kokkos::DefaultExecutionSpace> pool(seed + 1 + mode);
+    //Keep targets off the walls so only the wall mode ends on the boundary
+    const double inset = 1e-3 * cell;
+    auto setTarget = PS_LAMBDA(const int& e, const int& pid, const bool& mask) {
+      if (mask) {
+        auto generator = pool.get_state();
+        int move = mode;
+        if (move == DISP_MIXED)
+          move = generator.urand(DISP_MIXED);
+        for (int d = 0; d < 3; ++d)
+          xtgt(pid, d) = 0;
+        if (move == DISP_ELEMENT) {
+          double weights[4];
+          double sum = 0;
+          for (int i = 0; i <= dim; ++i) {
+            weights[i] = 0.05 + generator.drand(1.0);
+            sum += weights[i];
+          }
+          for (int i = 0; i <= dim; ++i) {
+            const o::LO vert = elm2verts[e * (dim + 1) + i];
+            for (int d = 0; d < dim; ++d)
+              xtgt(pid, d) += weights[i] / sum * coords[vert * dim + d];
+          }
+        }
+        else {
+          double dir[3] = {0, 0, 0};
+          double norm = 0;
+          while (norm < 1e-12) {
+            norm = 0;
+            for (int d = 0; d < dim; ++d) {
+              dir[d] = generator.normal();
+              norm += dir[d] * dir[d];
+            }
+          }
+          norm = Kokkos::sqrt(norm);
+          double length = 2.0; //leaves the unit box from any point
+          if (move == DISP_HOPS)
+            length = cell * (0.5 + generator.drand(hops - 0.5));
+          else if (move == DISP_LONG)
+            length = 0.25 + generator.drand(0.5);
+          for (int d = 0; d < dim; ++d) {
+            double t = x(pid, d) + length * dir[d] / norm;
+            if (move != DISP_WALL)
+              t = Kokkos::fmin(Kokkos::fmax(t, inset), 1.0 - inset);
+            xtgt(pid, d) = t;
+          }
+        }
+        pool.free_state(generator);
+      }
+    };
+    p::parallel_for(ptcls, setTarget, "setTargets");
+  }
+
+  //Output arrays of the search, allocated and reset outside of the timed region
+  struct SearchBuffers {
+    o::Write<o::LO> elem_ids;
+    o::Write<o::Real> xpoints;
+    o::Write<o::LO> xfaces;
+  };
+
+  SearchBuffers allocateBuffers(PS* ptcls, const SearchOptions& opts) {
+    const int psCapacity = ptcls->capacity();
+    SearchBuffers buffers;
+    buffers.elem_ids = o::Write<o::LO>(psCapacity, -1, "elem_ids");
+    buffers.xpoints = o::Write<o::Real>(opts.dim * psCapacity, 0, "xpoints");
+    buffers.xfaces = o::Write<o::LO>(psCapacity, -1, "xfaces");
+    return buffers;
+  }
+
+  /*
+    Restores the buffers to the state a fresh allocation passed to the search would have
+    The 2d search starts from the parent element where elem_ids is -1, the other searches
+    start from the value in elem_ids
+  */
+  void resetBuffers(PS* ptcls, const SearchOptions& opts, SearchBuffers& buffers) {
+    auto elem_ids = buffers.elem_ids;
+    auto xpoints = buffers.xpoints;
+    auto xfaces = buffers.xfaces;
+    const bool from_parent = opts.search != "2d";
+    auto setParents = PS_LAMBDA(const int& e, const int& pid, const bool& mask) {
+      elem_ids[pid] = (mask && from_parent) ? e : -1;
+    };
+    p::parallel_for(ptcls, setParents, "resetElemIds");
+    o::parallel_for(xpoints.size(), OMEGA_H_LAMBDA(const o::LO i) {
+      xpoints[i] = 0;
+    }, "resetXpoints");
+    o::parallel_for(xfaces.size(), OMEGA_H_LAMBDA(const o::LO i) {
+      xfaces[i] = -1;
+    }, "resetXfaces");
+    Kokkos::fence();
+  }
+
+  //Runs one search, `loops` is set to the number of search loops it took
+  bool search(o::Mesh& mesh, PS* ptcls, const SearchOptions& opts, SearchBuffers& buffers,
+              int loops_series, double& loops) {
+    auto x = ptcls->get<0>();
+    auto xtgt = ptcls->get<1>();
+    auto pids = ptcls->get<2>();
+    bool found;
+    if (opts.search == "3d") {
+      found = p::search_mesh_3d(mesh, ptcls, x, xtgt, pids, buffers.elem_ids, buffers.xpoints,
+                                buffers.xfaces);
+    }
+    else if (opts.search == "2d") {
+      found = p::search_mesh_2d(mesh, ptcls, x, xtgt, pids, buffers.elem_ids);
+    }
+    else {
+      found = p::search_mesh(mesh, ptcls, x, xtgt, pids, buffers.elem_ids, opts.intersection,
+                             buffers.xfaces, buffers.xpoints);
+    }
+    Kokkos::fence();
+    loops = p::currentSeriesValue(loops_series);
+    p::NextTimeStep();
+    return found;
+  }
+
+  std::string searchStats(double particles, const PhaseSamples& phase,
+                          const std::vector<double>& loops) {
+    std::vector<double> sorted = phase.seconds;
+    std::sort(sorted.begin(), sorted.end());
+    std::stringstream extra;
+    extra.precision(9);
+    extra << ", \"particles_per_second\": " << particles / percentile(sorted, 50)
+          << ", \"loops_mean\": " << mean(loops)
+          << ", \"loops_max\": " << *std::max_element(loops.begin(), loops.end());
+    return extra.str();
+  }
+}
+
+int main(int argc, char* argv[]) {
+  p::Library pic_lib(&argc, &argv);
+  o::Library& lib = pic_lib.omega_h_lib();
+  int comm_rank, comm_size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+  SearchOptions opts;
+  if (!parseOptions(argc, argv, opts)) {
+    if (!comm_rank)
+      usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::vector<int> modes = selectDisplacements(opts.displacement);
+  if (modes.empty()) {
+    if (!comm_rank)
+      fprintf(stderr, "[ERROR] Unknown displacement %s\n", opts.displacement.c_str());
+    return EXIT_FAILURE;
+  }
+  set_distribute_seed(opts.seed);
+
+  //Each process searches its own copy of the box
+  const int nz = opts.dim == 3 ? opts.cells : 0;
+  o::Mesh mesh = o::build_box(lib.self(), OMEGA_H_SIMPLEX, 1, 1, opts.dim == 3 ? 1 : 0,
+                              opts.cells, opts.cells, nz);
+  const int ne = mesh.nelems();
+  const double cell = 1.0 / opts.cells;
+  if (!comm_rank)
+    fprintf(stderr, "Box mesh with %d cells per side and %d elements, %d particles per process\n",
+            opts.cells, ne, opts.num_ptcls);
+
+  //Searches are timed with a Kokkos::Timer, the loop counts come from the time series
+  p::EnableTimeSeries();
+  const int loops_series = p::RegisterSeries("search loops");
+
+  std::vector<PhaseSamples> phases;
+  std::vector<std::string> extras;
+  bool found = true;
+  {
+    PS::kkLidView ppe("ptcls_per_elem", ne);
+    PS::kkLidView ptcl_elems("ptcl_elems", opts.num_ptcls);
+    PS::kkGidView element_gids("element_gids", ne);
+    Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const int i) {
+      element_gids(i) = i;
+    });
+    distribute_particles(ne, opts.num_ptcls, opts.strat, ppe, ptcl_elems);
+    const int sigma = INT_MAX;
+    const int V = 32;
+    Kokkos::TeamPolicy<Kokkos::DefaultExecutionSpace> policy = p::TeamPolicyAuto(10000, 32);
+    PS* ptcls = new p::SellCSigma<Particle>(policy, sigma, V, ne, opts.num_ptcls, ppe,
+                                            element_gids);
+    setOrigins(mesh, ptcls, opts.seed);
+    SearchBuffers buffers = allocateBuffers(ptcls, opts);
+
+    for (std::size_t m = 0; m < modes.size(); ++m) {
+      setTargets(mesh, ptcls, modes[m], opts.hops, cell, opts.seed);
+      PhaseSamples phase(displacement_names[modes[m]]);
+      std::vector<double> loops;
+      for (int trial = 0; trial < opts.warmup + opts.trials; ++trial) {
+        double trial_loops;
+        resetBuffers(ptcls, opts, buffers);
+        Kokkos::Timer timer;
+        found &= search(mesh, ptcls, opts, buffers, loops_series, trial_loops);
+        double seconds = timer.seconds();
+        double max_seconds, max_loops;
+        MPI_Allreduce(&seconds, &max_seconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        MPI_Allreduce(&trial_loops, &max_loops, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        if (trial >= opts.warmup) {
+          phase.seconds.push_back(max_seconds);
+          loops.push_back(max_loops);
+        }
+      }
+      phases.push_back(phase);
+      extras.push_back(searchStats((double)opts.num_ptcls * comm_size, phase, loops));
+    }
+    delete ptcls;
+  }
+  p::DisableTimeSeries();
+
+  if (!found && !comm_rank)
+    fprintf(stderr, "[WARNING] Search did not find the parent of every particle\n");
+
+  if (!comm_rank) {
+    std::ofstream file;
+    if (!opts.output.empty()) {
+      file.open(opts.output.c_str());
+      if (!file) {
+        fprintf(stderr, "[ERROR] Cannot open benchmark output %s\n", opts.output.c_str());
+        return EXIT_FAILURE;
+      }
+    }
+    std::ostream& out = opts.output.empty() ? std::cout : file;
+    out.precision(9);
+    out << "{\n"
+        << "  \"benchmark\": \"search_bench\",\n"
+        << "  \"search\": \"" << opts.search << "\",\n"
+        << "  \"intersection\": " << (opts.intersection ? "true" : "false") << ",\n"
+        << "  \"dim\": " << opts.dim << ",\n"
+        << "  \"cells\": " << opts.cells << ",\n"
+        << "  \"elements\": " << ne << ",\n"
+        << "  \"particles\": " << (long)opts.num_ptcls * comm_size << ",\n"
+        << "  \"distribution\": \"" << distribute_name(opts.strat) << "\",\n"
+        << "  \"hops\": " << opts.hops << ",\n"
+        << "  \"seed\": " << opts.seed << ",\n"
+        << "  \"ranks\": " << comm_size << ",\n"
+        << "  \"warmup\": " << opts.warmup << ",\n"
+        << "  \"trials\": " << opts.trials << ",\n"
+        << "  \"units\": \"seconds\",\n"
+        << "  \"phases\": {\n";
+    for (std::size_t i = 0; i < phases.size(); ++i)
+      writePhase(out, phases[i], i + 1 == phases.size(), extras[i]);
+    out << "  }\n}\n";
+  }
+  p::SummarizeTime();
+  return found ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,5 @@
 #!/bin/bash
-# Bash script to run a series of sparsely-populated ps_combo tests
+# Bash script to run a series of sparsely-populated ps_bench tests
 
 cd ~/barn/pumipic_CabM/
 source envAimos.sh
@@ -11,9 +11,9 @@ for e in 10000 15000 20000 25000 30000 35000 40000 45000 50000 55000
 do
   for distribution in 1 2 3
   do 
-    for struct in 0 1 2 3
+    for struct in scs csr cabm dps
     do
-      mpirun -np 2 ./ps_combo160 --kokkos-ndevices=2 $e $((e*1000)) $distribution $struct
+      mpirun -np 2 ./ps_bench --kokkos-ndevices=2 --elements $e --particles $((e*1000)) --distribution $distribution --structure $struct --output ${struct}_${e}_${distribution}.json
     done
   done
 done
\ No newline at end of file
@@ -1,5 +1,5 @@
 #!/bin/bash
-# Bash script to run a series of densely-populated ps_combo tests
+# Bash script to run a series of densely-populated ps_bench tests
 
 cd ~/barn/pumipic_CabM/
 source envAimos.sh
@@ -11,9 +11,9 @@ for e in 1000 1500 2000 2500 3000 3500 4000 4500 5000 5500
 do
   for distribution in 1 2 3
   do 
-    for struct in 0 1 2 3
+    for struct in scs csr cabm dps
     do
-      mpirun -np 2 ./ps_combo160 --kokkos-ndevices=2 $e $((e*10000)) $distribution $struct
+      mpirun -np 2 ./ps_bench --kokkos-ndevices=2 --elements $e --particles $((e*10000)) --distribution $distribution --structure $struct --output ${struct}_${e}_${distribution}.json
     done
   done
 done
\ No newline at end of file
@@ -13,6 +13,8 @@
 #include "pumipic_constants.hpp"
 #include "pumipic_kktypes.hpp"
 #include "pumipic_profiling.hpp"
+#include <ppTimeSeries.hpp>
+#include <ppMemTracker.hpp>
 
 namespace o = Omega_h;
 namespace ps = particle_structs;
@@ -321,8 +323,11 @@ bool search_mesh_3d(o::Mesh& mesh, // (in) mesh
     o::Write<o::Real>& xpoints_d, // (out) particle-boundary intersection points
     o::Write<o::LO>& xface_d, // (out) face ids of boundary-intersecting points
     int looplimit=0, int debug=0) {
+  static const int search_timer = pumipic::RegisterTimer("Search Mesh 3d");
   const auto btime = pumipic_prebarrier();
+  pumipic::ScopedTimer search_scope(search_timer);
   Kokkos::Profiling::pushRegion("pumpipic_search_mesh3d");
+  pumipic::ScopedMemoryPhase memory_phase("search");
   Kokkos::Profiling::pushRegion("pumpipic_search_mesh_Init");
 
   Kokkos::Timer timer;
@@ -390,6 +395,9 @@ bool search_mesh_3d(o::Mesh& mesh, // (in) mesh
   if(debug)
     hsize = psCapacity;
   auto el_hist = o::Write<o::LO>(hsize*nl, -2);
+  pumipic::SetTrackedMemory(ptcls, ptcls->getName(), pumipic::MEM_SEARCH,
+                            (2 * psCapacity + (set_ids ? psCapacity : 0) + el_hist.size()) *
+                            sizeof(o::LO));
 
   while(!found) {
     auto checkCurrentElm = PS_LAMBDA(const int& e, const int& pid, const int& mask) {
@@ -550,6 +558,9 @@ bool search_mesh_3d(o::Mesh& mesh, // (in) mesh
   Kokkos::Profiling::popRegion(); //whole
   //fprintf(stderr, "loop-time seconds %f\n", timer.seconds()); 
   pumipic::RecordTime("Search Mesh 3d", timer.seconds(), btime);
+  static const int loops_series = pumipic::RegisterSeries("search loops");
+  pumipic::RecordSeries(loops_series, loops);
+  pumipic::SetTrackedMemory(ptcls, ptcls->getName(), pumipic::MEM_SEARCH, 0);
   return found;   
 }
 
@@ -1018,8 +1029,11 @@ bool search_mesh_2d(o::Mesh& mesh, // (in) mesh
                     int looplimit=0,  // (in) [optional] number of loops before giving up
                     bool debug = false) {
 
+  static const int search_timer = RegisterTimer("pumipic search_2d");
   const auto btime = pumipic_prebarrier();
+  ScopedTimer search_scope(search_timer);
   Kokkos::Profiling::pushRegion("pumipic_search_mesh_2d");
+  ScopedMemoryPhase memory_phase("search");
   Kokkos::Timer timer;
 
   int rank, comm_size;
@@ -1040,6 +1054,8 @@ bool search_mesh_2d(o::Mesh& mesh, // (in) mesh
   o::Write<o::LO> ptcl_done(psCapacity, 1, "ptcl_done");
   // store the last crossed edge
   o::Write<o::LO> lastEdge(psCapacity,-1);
+  SetTrackedMemory(ptcls, ptcls->getName(), MEM_SEARCH,
+                   2 * psCapacity * sizeof(o::LO) + triArea.size() * sizeof(o::Real));
   const o::LO nelems = mesh.nelems();
   auto lamb = PS_LAMBDA(const int& e, const int& pid, const int& mask) {
     if(mask > 0) {
@@ -1147,9 +1163,12 @@ bool search_mesh_2d(o::Mesh& mesh, // (in) mesh
   }
 
   RecordTime("pumipic search_2d", timer.seconds(), btime);
+  static const int loops_series = RegisterSeries("search loops");
+  RecordSeries(loops_series, loops);
   char buffer[1024];
   sprintf(buffer, "%d pumipic search_2d loops %d", rank, loops);
   PrintAdditionalTimeInfo(buffer, 1);
+  SetTrackedMemory(ptcls, ptcls->getName(), MEM_SEARCH, 0);
   Kokkos::Profiling::popRegion();
   return found;
 }
@@ -434,8 +434,11 @@ namespace pumipic {
                    int looplimit,
                    int debug) {
     //Initialize timer
+    static const int search_timer = RegisterTimer("pumipic search_mesh");
     const auto btime = pumipic_prebarrier();
+    ScopedTimer search_scope(search_timer);
     Kokkos::Profiling::pushRegion("pumipic_search_mesh");
+    ScopedMemoryPhase memory_phase("search");
     Kokkos::Timer timer;
 
     //Initial setup
@@ -445,6 +448,8 @@ namespace pumipic {
     // Store the last exit face
     o::Write<o::LO> lastExit(psCapacity,-1, "search_last_exit");
     const auto elmArea = measure_elements_real(&mesh);
+    SetTrackedMemory(ptcls, ptcls->getName(), MEM_SEARCH,
+                     2 * psCapacity * sizeof(o::LO) + elmArea.size() * sizeof(o::Real));
     bool useBcc = !requireIntersection;
     o::Real tol = compute_tolerance_from_area(elmArea);
     
@@ -566,9 +571,12 @@ namespace pumipic {
 
     }
     RecordTime("pumipic search_mesh", timer.seconds(), btime);
+    static const int loops_series = RegisterSeries("search loops");
+    RecordSeries(loops_series, loops);
     char buffer[1024];
     sprintf(buffer, "%d pumipic search_mesh loops %d", rank, loops);
     PrintAdditionalTimeInfo(buffer, 1);
+    SetTrackedMemory(ptcls, ptcls->getName(), MEM_SEARCH, 0);
     Kokkos::Profiling::popRegion();
     return found;
   }
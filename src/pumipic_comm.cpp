@@ -4,6 +4,8 @@
 #include <Omega_h_array_ops.hpp>
 #include <mpi.h>
 #include <Omega_h_comm.hpp>
+#include <ppCommVolume.hpp>
+#include <ppTrace.hpp>
 
 using Omega_h::MpiTraits;
 
@@ -281,6 +283,7 @@ namespace pumipic {
         if (num_entries > 0) {
           MPI_Isend(data + ent_offsets[rank]*nvals, num_entries*nvals, MpiTraits<T>::datatype(),
                     rank, is_complete_part[edim][rank], commptr->get_impl(), send_requests + i);
+          RecordCommVolume(COMM_FAN_IN, rank, num_entries * nvals * sizeof(T));
           if (is_complete_part[edim][rank] == 2) {
             T* neighbor_data = neighbor_arrays[index]->data();
             MPI_Irecv(neighbor_data, my_num_entries*nvals, MpiTraits<T>::datatype(), rank, 2,
@@ -302,7 +305,10 @@ namespace pumipic {
       for (Omega_h::LO i = 0; i < num_recvs; ++i) {
         int finished_neighbor = -1;
         MPI_Status status;
-        MPI_Waitany(num_recvs, recv_requests, &finished_neighbor, &status);
+        {
+          ScopedTrace trace("MPI_Waitany", TRACE_MPI);
+          MPI_Waitany(num_recvs, recv_requests, &finished_neighbor, &status);
+        }
         //When recv finishes copy data to the device and perform op
         const Omega_h::LO start_index = ent_offsets[commptr->rank()]*nvals;
         Omega_h::Write<T> recv_array(*(neighbor_arrays[finished_neighbor]));
@@ -371,7 +377,10 @@ namespace pumipic {
         }
         delete neighbor_arrays[finished_neighbor];
       }
-      MPI_Waitall(num_sends, send_requests,MPI_STATUSES_IGNORE);
+      {
+        ScopedTrace trace("MPI_Waitall", TRACE_MPI);
+        MPI_Waitall(num_sends, send_requests,MPI_STATUSES_IGNORE);
+      }
       delete [] neighbor_arrays;
     }
     /***************** Fan Out ******************/
@@ -393,6 +402,7 @@ namespace pumipic {
           MPI_Isend(data + ent_offsets[commptr->rank()]*nvals, my_num_entries*nvals,
                     MpiTraits<T>::datatype(), rank, 3,
                     commptr->get_impl(), send_requests + index++);
+          RecordCommVolume(COMM_FAN_OUT, rank, my_num_entries * nvals * sizeof(T));
         }
         MPI_Irecv(data + ent_offsets[rank]*nvals, num_entries*nvals, MpiTraits<T>::datatype(),
                   rank, 3, commptr->get_impl(), recv_requests + i);
@@ -417,9 +427,13 @@ namespace pumipic {
       int start = offset_bounded_per_dim[edim][rank]*nvals;
       MPI_Isend(sending_data+start, size*nvals, MpiTraits<T>::datatype(), rank, 3,
                 commptr->get_impl(), send_requests + index++);
+      RecordCommVolume(COMM_FAN_OUT, rank, size * nvals * sizeof(T));
+    }
+    {
+      ScopedTrace trace("MPI_Waitall", TRACE_MPI);
+      MPI_Waitall(num_recvs, recv_requests,MPI_STATUSES_IGNORE);
+      MPI_Waitall(num_sends, send_requests,MPI_STATUSES_IGNORE);
     }
-    MPI_Waitall(num_recvs, recv_requests,MPI_STATUSES_IGNORE);
-    MPI_Waitall(num_sends, send_requests,MPI_STATUSES_IGNORE);
     delete [] send_requests;
     delete [] recv_requests;
 
@@ -1,6 +1,15 @@
 #include "pumipic_mesh.hpp"
 #include <Omega_h_file.hpp>
+#include <Omega_h_for.hpp>
 #include <fstream>
+#include <sstream>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "pumipic_lb.hpp"
 
 //Helper functions for host writes to be read/write
@@ -40,11 +49,85 @@ namespace {
     return *p == 0x1;
   }
 
+  //Identifier and version of the single file picpart container
+  const char container_magic[4] = {'P', 'P', 'M', 'C'};
+  const Omega_h::I32 container_version = 1;
+  //Bytes of the container header before the per rank offset index
+  const MPI_Offset container_prefix_size = sizeof(container_magic) + 3 * sizeof(Omega_h::I32);
 
-}
-namespace pumipic {
-  void write(Mesh& picparts, const char* path) {
-    Omega_h::CommPtr comm = picparts.comm();
+  //Reads the omega_h mesh at the start of the container block beginning at start in blocks
+  //  Returns the number of bytes of the serialized mesh
+  Omega_h::I64 readBlockMesh(Omega_h::Library* library, const std::string& blocks,
+                             size_t start, Omega_h::I32 osh_version, bool swap,
+                             Omega_h::Mesh* mesh) {
+    std::istringstream size_str(blocks.substr(start, sizeof(Omega_h::I64)));
+    Omega_h::I64 mesh_size;
+    Omega_h::binary::read_value(size_str, mesh_size, swap);
+    std::istringstream mesh_str(blocks.substr(start + sizeof(Omega_h::I64), mesh_size));
+    mesh->set_comm(library->self());
+    Omega_h::binary::read(mesh_str, mesh, osh_version);
+    return mesh_size;
+  }
+
+  //Version of the .ppm files using the uncompressed layout that can be memory mapped
+  const Omega_h::I8 mappable_version = 3;
+  //Version of the .ppm files that also store the particle balancer sbars
+  const Omega_h::I8 balancer_version = 4;
+  //Alignment of each array in the mappable layout
+  const Omega_h::I64 mappable_alignment = 64;
+  //Arrays stored per dimension in the mappable layout
+  enum MappableArray {
+    BUFFERED_PARTS,
+    OFFSET_ENTS_PER_RANK,
+    ENT_TO_COMM_ARR_INDEX,
+    IS_COMPLETE_PART,
+    BOUNDARY_PARTS,
+    OFFSET_BOUNDED,
+    BOUNDED_ENT_IDS,
+    NUM_MAPPABLE_ARRAYS
+  };
+  //Fixed size header of the mappable layout, arrays follow at the recorded offsets
+  struct MappableHeader {
+    Omega_h::I8 version;
+    Omega_h::I8 is_full_mesh;
+    Omega_h::I8 is_little_endian;
+    Omega_h::I8 padding[5];
+    Omega_h::GO num_entites[4];
+    Omega_h::I32 num_cores[4];
+    Omega_h::I32 num_bounds[4];
+    Omega_h::I32 num_boundaries[4];
+    Omega_h::I64 balancer_offset;
+    Omega_h::I64 balancer_size;
+    Omega_h::I64 offsets[4][NUM_MAPPABLE_ARRAYS];
+    Omega_h::I64 sizes[4][NUM_MAPPABLE_ARRAYS];
+  };
+  //Checks that count LOs at offset lie after the header and within the mapped file
+  bool inMappedFile(Omega_h::I64 offset, Omega_h::I64 count, Omega_h::I64 file_size) {
+    if (offset < (Omega_h::I64)sizeof(MappableHeader) || offset > file_size || count < 0 ||
+        offset % sizeof(Omega_h::LO) != 0)
+      return false;
+    return count <= (file_size - offset) / (Omega_h::I64)sizeof(Omega_h::LO);
+  }
+  Omega_h::I64 alignOffset(Omega_h::I64 offset) {
+    return (offset + mappable_alignment - 1) / mappable_alignment * mappable_alignment;
+  }
+
+  //Wraps a mapped array without copying when the default memory space is host accessible
+  Omega_h::Write<Omega_h::LO> wrapMapped(Omega_h::LO* data, Omega_h::LO size) {
+    typedef Kokkos::DefaultExecutionSpace::memory_space MemSpace;
+    if (Kokkos::SpaceAccessibility<Kokkos::HostSpace, MemSpace>::accessible) {
+      Kokkos::View<Omega_h::LO*, Kokkos::MemoryTraits<Kokkos::Unmanaged> > mapped(data, size);
+      Kokkos::View<Omega_h::LO*> view = mapped;
+      return Omega_h::Write<Omega_h::LO>(view);
+    }
+    Omega_h::HostWrite<Omega_h::LO> host(size, "mapped_array");
+    for (int i = 0; i < size; ++i)
+      host[i] = data[i];
+    return Omega_h::Write<Omega_h::LO>(host);
+  }
+
+  //Creates the output directory and the per rank file names
+  bool prepareFiles(Omega_h::CommPtr comm, const char* path, char* mesh_file, char* ppm_file) {
     const char* prefix = splitPath(path);
     char dir[4096];
     sprintf(dir, "%s_%d.ppm", path, comm->size());
@@ -52,27 +135,30 @@ namespace pumipic {
       if (!Omega_h::filesystem::exists(dir)) {
         if (!Omega_h::filesystem::create_directory(dir)) {
           fprintf(stderr, "[ERROR] Failed to create directory %s\n", dir);
-          return;
+          return false;
         }
       }
     }
     //Wait for directory to be created
     comm->barrier();
 
-    char mesh_file[4096];
     sprintf(mesh_file, "%s/%s_%d.osh", dir, prefix, comm->rank());
-    char ppm_file[4096];
     sprintf(ppm_file, "%s/%s_%d.ppm", dir, prefix, comm->rank());
+    return true;
+  }
 
-    //Write the omega_h mesh for the picpart
-    Omega_h::binary::write(mesh_file, picparts.mesh());
+  //Hints requesting collective buffering so a subset of ranks aggregates the file access
+  MPI_Info collectiveInfo() {
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "romio_cb_read", "enable");
+    MPI_Info_set(info, "romio_cb_write", "enable");
+    return info;
+  }
 
-    //Write file for the pumipic mesh data
-    std::ofstream out_str(ppm_file);
-    if (!out_str) {
-      fprintf(stderr, "[ERROR] Failed to open file %s\n", ppm_file);
-      return;
-    }
+}
+namespace pumipic {
+  void Mesh::writeMetadata(std::ostream& out_str) {
 #ifdef OMEGA_H_USE_ZLIB
     bool compress = true;
 #else
@@ -80,67 +166,47 @@ namespace pumipic {
 #endif
     bool swap = !is_little_endian_cpu();
     //Write Version
-    Omega_h::I8 version = 2;
+    Omega_h::I8 version = balancer_version;
     Omega_h::binary::write_value(out_str, version, swap);
     //Write is_full_mesh
-    Omega_h::binary::write_value(out_str, (Omega_h::I8)picparts.is_full_mesh, swap);
+    Omega_h::binary::write_value(out_str, (Omega_h::I8)is_full_mesh, swap);
     for (int i = 0; i < 4; ++i) {
       //Write the global number of entities
-      Omega_h::binary::write_value(out_str, picparts.num_entites[i], swap);
+      Omega_h::binary::write_value(out_str, num_entites[i], swap);
       //Write num_cores
-      Omega_h::binary::write_value(out_str, picparts.num_cores[i], swap);
+      Omega_h::binary::write_value(out_str, num_cores[i], swap);
       //Write buffered_parts
-      Omega_h::binary::write_array(out_str,picparts.buffered_parts[i], compress, swap);
+      Omega_h::binary::write_array(out_str,buffered_parts[i], compress, swap);
       //Write offset_ents_per_rank_per_dim
-      Omega_h::binary::write_array(out_str, picparts.offset_ents_per_rank_per_dim[i],
+      Omega_h::binary::write_array(out_str, offset_ents_per_rank_per_dim[i],
                                    compress, swap);
       //Write ent_to_comm_arr_index_per_dim
-      Omega_h::binary::write_array(out_str, picparts.ent_to_comm_arr_index_per_dim[i],
+      Omega_h::binary::write_array(out_str, ent_to_comm_arr_index_per_dim[i],
                                    compress, swap);
       //Write is complete part
-      Omega_h::binary::write_array(out_str,picparts.is_complete_part[i],
+      Omega_h::binary::write_array(out_str,is_complete_part[i],
                                    compress, swap);
       //write num_bounds
-      Omega_h::binary::write_value(out_str, picparts.num_bounds[i], swap);
+      Omega_h::binary::write_value(out_str, num_bounds[i], swap);
       //write num_boundaries
-      Omega_h::binary::write_value(out_str, picparts.num_boundaries[i], swap);
+      Omega_h::binary::write_value(out_str, num_boundaries[i], swap);
       //write boundary_parts
-      Omega_h::binary::write_array(out_str,picparts.boundary_parts[i], compress, swap);
+      Omega_h::binary::write_array(out_str,boundary_parts[i], compress, swap);
       //write offset_bounded_per_dim
-      Omega_h::binary::write_array(out_str,picparts.offset_bounded_per_dim[i],
+      Omega_h::binary::write_array(out_str,offset_bounded_per_dim[i],
                                    compress, swap);
       //write bounded_ent_ids
-      Omega_h::binary::write_array(out_str, picparts.bounded_ent_ids[i],
+      Omega_h::binary::write_array(out_str, bounded_ent_ids[i],
                                    compress, swap);
     }
+    //write the particle balancer sbars
+    Omega_h::HostWrite<Omega_h::LO> sbar_data(0);
+    if (ptcl_balancer)
+      sbar_data = ptcl_balancer->serialize();
+    Omega_h::binary::write_array(out_str, sbar_data, compress, swap);
   }
 
-  void read(Omega_h::Library* library, Omega_h::CommPtr comm, const char* path,
-            Mesh* mesh) {
-    const char* prefix = splitPath(path);
-    char dir[4096];
-    sprintf(dir, "%s_%d.ppm", path, comm->size());
-
-    if (!Omega_h::filesystem::exists(dir)) {
-      fprintf(stderr, "[ERROR] Directory %s does not exist\n", dir);
-      return;
-    }
-
-    char mesh_file[4096];
-    sprintf(mesh_file, "%s/%s_%d.osh", dir, prefix, comm->rank());
-    char ppm_file[4096];
-    sprintf(ppm_file, "%s/%s_%d.ppm", dir, prefix, comm->rank());
-
-    mesh->picpart =
-      new Omega_h::Mesh(Omega_h::binary::read(mesh_file, library->self()));
-
-    std::ifstream in_str(ppm_file);
-    if (!in_str) {
-      fprintf(stderr, "[ERROR] Cannot open file %s\n", ppm_file);
-      return;
-    }
-
-
+  Omega_h::HostWrite<Omega_h::LO> Mesh::readMetadata(std::istream& in_str) {
 #ifdef OMEGA_H_USE_ZLIB
     bool compress = true;
 #else
@@ -149,59 +215,481 @@ namespace pumipic {
     bool swap = !is_little_endian_cpu();
     Omega_h::I8 version;
     Omega_h::binary::read_value(in_str, version, swap);
+    if (version == mappable_version || version > balancer_version) {
+      fprintf(stderr, "[ERROR] Unsupported pumipic metadata version %d\n", version);
+      throw std::runtime_error("Unsupported pumipic metadata version");
+    }
     Omega_h::I8 is_full_mesh_int;
     Omega_h::binary::read_value(in_str, is_full_mesh_int, swap);
-    mesh->is_full_mesh = is_full_mesh_int;
+    is_full_mesh = is_full_mesh_int;
 
     for (int i = 0; i < 4; ++i) {
       if (version >= 2) {
         //Read num_entites
-        Omega_h::binary::read_value(in_str, mesh->num_entites[i], swap);
+        Omega_h::binary::read_value(in_str, num_entites[i], swap);
       }
       //Read num_cores
-      Omega_h::binary::read_value(in_str, mesh->num_cores[i], swap);
+      Omega_h::binary::read_value(in_str, num_cores[i], swap);
       //Read buffered_parts
-      Omega_h::binary::read_array(in_str, mesh->buffered_parts[i], compress, swap);
+      Omega_h::binary::read_array(in_str, buffered_parts[i], compress, swap);
       //Read offset_ents_per_rank_per_dim
-      Omega_h::binary::read_array(in_str, mesh->offset_ents_per_rank_per_dim[i],
+      Omega_h::binary::read_array(in_str, offset_ents_per_rank_per_dim[i],
                                    compress, swap);
       //Read ent_to_comm_arr_index_per_dim
-      Omega_h::binary::read_array(in_str, mesh->ent_to_comm_arr_index_per_dim[i],
+      Omega_h::binary::read_array(in_str, ent_to_comm_arr_index_per_dim[i],
                                    compress, swap);
       //Read is complete part
-      Omega_h::binary::read_array(in_str, mesh->is_complete_part[i], compress, swap);
+      Omega_h::binary::read_array(in_str, is_complete_part[i], compress, swap);
       //read num_bounds
-      Omega_h::binary::read_value(in_str, mesh->num_bounds[i], swap);
+      Omega_h::binary::read_value(in_str, num_bounds[i], swap);
       //read num_boundaries
-      Omega_h::binary::read_value(in_str, mesh->num_boundaries[i], swap);
+      Omega_h::binary::read_value(in_str, num_boundaries[i], swap);
       //read boundary_parts
-      Omega_h::binary::read_array(in_str, mesh->boundary_parts[i], compress, swap);
+      Omega_h::binary::read_array(in_str, boundary_parts[i], compress, swap);
       //read offset_bounded_per_dim
-      Omega_h::binary::read_array(in_str, mesh->offset_bounded_per_dim[i],
+      Omega_h::binary::read_array(in_str, offset_bounded_per_dim[i],
                                   compress, swap);
       //read bounded_ent_ids
-      Omega_h::binary::read_array(in_str, mesh->bounded_ent_ids[i], compress, swap);
+      Omega_h::binary::read_array(in_str, bounded_ent_ids[i], compress, swap);
 
     }
+    //read the particle balancer sbars
+    Omega_h::HostWrite<Omega_h::LO> sbar_data(0);
+    if (version >= balancer_version)
+      Omega_h::binary::read_array(in_str, sbar_data, compress, swap);
+    return sbar_data;
+  }
 
-    mesh->commptr = comm;
+  void Mesh::writeMappableMetadata(std::ostream& out_str) {
+    MappableHeader header;
+    memset(&header, 0, sizeof(MappableHeader));
+    header.version = mappable_version;
+    header.is_full_mesh = is_full_mesh;
+    header.is_little_endian = is_little_endian_cpu();
+
+    //Gather host copies of every array in the order of MappableArray
+    std::vector<Omega_h::HostRead<Omega_h::LO> > arrays;
+    for (int i = 0; i < 4; ++i) {
+      header.num_entites[i] = num_entites[i];
+      header.num_cores[i] = num_cores[i];
+      header.num_bounds[i] = num_bounds[i];
+      header.num_boundaries[i] = num_boundaries[i];
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(
+        Omega_h::LOs(Omega_h::Write<Omega_h::LO>(buffered_parts[i]))));
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(offset_ents_per_rank_per_dim[i]));
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(ent_to_comm_arr_index_per_dim[i]));
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(
+        Omega_h::LOs(Omega_h::Write<Omega_h::LO>(is_complete_part[i]))));
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(
+        Omega_h::LOs(Omega_h::Write<Omega_h::LO>(boundary_parts[i]))));
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(
+        Omega_h::LOs(Omega_h::Write<Omega_h::LO>(offset_bounded_per_dim[i]))));
+      arrays.push_back(Omega_h::HostRead<Omega_h::LO>(bounded_ent_ids[i]));
+    }
+    Omega_h::I64 offset = alignOffset(sizeof(MappableHeader));
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < NUM_MAPPABLE_ARRAYS; ++j) {
+        const Omega_h::I64 size = arrays[i * NUM_MAPPABLE_ARRAYS + j].size();
+        header.offsets[i][j] = offset;
+        header.sizes[i][j] = size;
+        offset = alignOffset(offset + size * sizeof(Omega_h::LO));
+      }
+    }
+    Omega_h::HostWrite<Omega_h::LO> sbar_data(0);
+    if (ptcl_balancer)
+      sbar_data = ptcl_balancer->serialize();
+    header.balancer_offset = offset;
+    header.balancer_size = sbar_data.size();
+
+    out_str.write(reinterpret_cast<const char*>(&header), sizeof(MappableHeader));
+    Omega_h::I64 position = sizeof(MappableHeader);
+    const char zeros[mappable_alignment] = {0};
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < NUM_MAPPABLE_ARRAYS; ++j) {
+        out_str.write(zeros, header.offsets[i][j] - position);
+        const Omega_h::HostRead<Omega_h::LO>& array = arrays[i * NUM_MAPPABLE_ARRAYS + j];
+        const Omega_h::I64 bytes = header.sizes[i][j] * sizeof(Omega_h::LO);
+        if (bytes > 0)
+          out_str.write(reinterpret_cast<const char*>(array.data()), bytes);
+        position = header.offsets[i][j] + bytes;
+      }
+    }
+    out_str.write(zeros, header.balancer_offset - position);
+    if (header.balancer_size > 0)
+      out_str.write(reinterpret_cast<const char*>(sbar_data.data()),
+                    header.balancer_size * sizeof(Omega_h::LO));
+  }
+
+  Omega_h::HostWrite<Omega_h::LO> Mesh::mapMetadata(const char* ppm_file) {
+    int fd = open(ppm_file, O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "[ERROR] Cannot open file %s\n", ppm_file);
+      throw std::runtime_error("Cannot open file");
+    }
+    struct stat file_stat;
+    fstat(fd, &file_stat);
+    mapped_size = file_stat.st_size;
+    if (mapped_size < sizeof(MappableHeader)) {
+      close(fd);
+      fprintf(stderr, "[ERROR] %s is too small to hold the mappable header\n", ppm_file);
+      throw std::runtime_error("Truncated mappable file");
+    }
+    //Private mapping so the arrays stay writable without modifying the file,
+    //  pages are only read from disk when an array is first accessed
+    mapped_metadata = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped_metadata == MAP_FAILED) {
+      mapped_metadata = NULL;
+      fprintf(stderr, "[ERROR] Failed to map file %s\n", ppm_file);
+      throw std::runtime_error("Failed to map file");
+    }
+
+    const MappableHeader* header = static_cast<const MappableHeader*>(mapped_metadata);
+    if (header->is_little_endian != is_little_endian_cpu()) {
+      fprintf(stderr, "[ERROR] %s was written on a machine with different endianness\n",
+              ppm_file);
+      throw std::runtime_error("Endianness mismatch");
+    }
+    //Every array must lie within the file before any of it is wrapped
+    const Omega_h::I64 file_size = mapped_size;
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < NUM_MAPPABLE_ARRAYS; ++j) {
+        if (!inMappedFile(header->offsets[i][j], header->sizes[i][j], file_size) ||
+            header->sizes[i][j] > INT_MAX) {
+          fprintf(stderr, "[ERROR] Array %d of dimension %d in %s has offset %ld and length "
+                  "%ld outside of the %ld byte file\n", j, i, ppm_file,
+                  (long)header->offsets[i][j], (long)header->sizes[i][j], (long)file_size);
+          throw std::runtime_error("Corrupt mappable file");
+        }
+      }
+    }
+    if (!inMappedFile(header->balancer_offset, header->balancer_size, file_size) ||
+        header->balancer_size > INT_MAX) {
+      fprintf(stderr, "[ERROR] Balancer data in %s has offset %ld and length %ld outside of "
+              "the %ld byte file\n", ppm_file, (long)header->balancer_offset,
+              (long)header->balancer_size, (long)file_size);
+      throw std::runtime_error("Corrupt mappable file");
+    }
+    is_full_mesh = header->is_full_mesh;
+    char* base = static_cast<char*>(mapped_metadata);
+    for (int i = 0; i < 4; ++i) {
+      num_entites[i] = header->num_entites[i];
+      num_cores[i] = header->num_cores[i];
+      num_bounds[i] = header->num_bounds[i];
+      num_boundaries[i] = header->num_boundaries[i];
+      Omega_h::Write<Omega_h::LO> arrays[NUM_MAPPABLE_ARRAYS];
+      for (int j = 0; j < NUM_MAPPABLE_ARRAYS; ++j) {
+        Omega_h::LO* data = reinterpret_cast<Omega_h::LO*>(base + header->offsets[i][j]);
+        arrays[j] = wrapMapped(data, header->sizes[i][j]);
+      }
+      buffered_parts[i] = Omega_h::HostWrite<Omega_h::LO>(arrays[BUFFERED_PARTS]);
+      offset_ents_per_rank_per_dim[i] = Omega_h::LOs(arrays[OFFSET_ENTS_PER_RANK]);
+      ent_to_comm_arr_index_per_dim[i] = Omega_h::LOs(arrays[ENT_TO_COMM_ARR_INDEX]);
+      is_complete_part[i] = Omega_h::HostWrite<Omega_h::LO>(arrays[IS_COMPLETE_PART]);
+      boundary_parts[i] = Omega_h::HostWrite<Omega_h::LO>(arrays[BOUNDARY_PARTS]);
+      offset_bounded_per_dim[i] = Omega_h::HostWrite<Omega_h::LO>(arrays[OFFSET_BOUNDED]);
+      bounded_ent_ids[i] = Omega_h::LOs(arrays[BOUNDED_ENT_IDS]);
+    }
+    Omega_h::HostWrite<Omega_h::LO> sbar_data(header->balancer_size, "sbar_data");
+    const Omega_h::LO* sbar_ptr =
+      reinterpret_cast<const Omega_h::LO*>(base + header->balancer_offset);
+    for (int i = 0; i < sbar_data.size(); ++i)
+      sbar_data[i] = sbar_ptr[i];
+    return sbar_data;
+  }
+
+  void Mesh::finalizeRead(Omega_h::CommPtr comm, Omega_h::HostWrite<Omega_h::LO> sbar_data) {
+    commptr = comm;
 
     int world_rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
     if (!world_rank) {
       char buffer[1024];
       char* ptr = buffer + sprintf(buffer, "PumiPIC Mesh read <v e f");
-      if (mesh->dim() == 3)
+      if (dim() == 3)
         ptr += sprintf(ptr, " r");
-      ptr += sprintf(ptr, "> (%ld %ld %ld", mesh->num_entites[0], mesh->num_entites[1],
-                     mesh->num_entites[2]);
-      if (mesh->dim() == 3)
-        ptr += sprintf(ptr, " %ld", mesh->num_entites[3]);
+      ptr += sprintf(ptr, "> (%ld %ld %ld", num_entites[0], num_entites[1],
+                     num_entites[2]);
+      if (dim() == 3)
+        ptr += sprintf(ptr, " %ld", num_entites[3]);
       ptr += sprintf(ptr, ")");
       printf("%s\n", buffer);
     }
 
     //Create load balancer after reading in the mesh
-    mesh->ptcl_balancer = new ParticleBalancer(*mesh);
+    //  The stored sbars are used if the element sbar ids were saved with the mesh
+    if (sbar_data.size() > 0 && picpart->has_tag(dim(), "sbar_id"))
+      ptcl_balancer = new ParticleBalancer(*this, sbar_data);
+    else
+      ptcl_balancer = new ParticleBalancer(*this);
+  }
+
+  void write(Mesh& picparts, const char* path) {
+    char mesh_file[4096];
+    char ppm_file[4096];
+    if (!prepareFiles(picparts.comm(), path, mesh_file, ppm_file))
+      return;
+
+    //Write the omega_h mesh for the picpart
+    Omega_h::binary::write(mesh_file, picparts.mesh());
+
+    //Write file for the pumipic mesh data
+    std::ofstream out_str(ppm_file);
+    if (!out_str) {
+      fprintf(stderr, "[ERROR] Failed to open file %s\n", ppm_file);
+      return;
+    }
+    picparts.writeMetadata(out_str);
+  }
+
+  void writeMappable(Mesh& picparts, const char* path) {
+    char mesh_file[4096];
+    char ppm_file[4096];
+    if (!prepareFiles(picparts.comm(), path, mesh_file, ppm_file))
+      return;
+
+    //Write the omega_h mesh for the picpart
+    Omega_h::binary::write(mesh_file, picparts.mesh());
+
+    //Write file for the pumipic mesh data
+    std::ofstream out_str(ppm_file, std::ios::binary);
+    if (!out_str) {
+      fprintf(stderr, "[ERROR] Failed to open file %s\n", ppm_file);
+      return;
+    }
+    picparts.writeMappableMetadata(out_str);
+  }
+
+  void read(Omega_h::Library* library, Omega_h::CommPtr comm, const char* path,
+            Mesh* mesh) {
+    const char* prefix = splitPath(path);
+    char dir[4096];
+    sprintf(dir, "%s_%d.ppm", path, comm->size());
+
+    if (!Omega_h::filesystem::exists(dir)) {
+      fprintf(stderr, "[ERROR] Directory %s does not exist\n", dir);
+      return;
+    }
+
+    char mesh_file[4096];
+    sprintf(mesh_file, "%s/%s_%d.osh", dir, prefix, comm->rank());
+    char ppm_file[4096];
+    sprintf(ppm_file, "%s/%s_%d.ppm", dir, prefix, comm->rank());
+
+    mesh->picpart =
+      new Omega_h::Mesh(Omega_h::binary::read(mesh_file, library->self()));
+
+    std::ifstream in_str(ppm_file);
+    if (!in_str) {
+      fprintf(stderr, "[ERROR] Cannot open file %s\n", ppm_file);
+      return;
+    }
+
+    //Files written by writeMappable are mapped instead of parsed
+    Omega_h::HostWrite<Omega_h::LO> sbar_data;
+    if (in_str.peek() == mappable_version) {
+      in_str.close();
+      sbar_data = mesh->mapMetadata(ppm_file);
+    }
+    else
+      sbar_data = mesh->readMetadata(in_str);
+    mesh->finalizeRead(comm, sbar_data);
+  }
+
+  void writeSingleFile(Mesh& picparts, const char* path) {
+    Omega_h::CommPtr comm = picparts.comm();
+    MPI_Comm mpi_comm = comm->get_impl();
+    int rank = comm->rank();
+    int comm_size = comm->size();
+    bool swap = !is_little_endian_cpu();
+    char filename[4096];
+    sprintf(filename, "%s_%d.ppc", path, comm_size);
+
+    //Serialize the omega_h mesh and pumipic data of this rank into one block
+    std::ostringstream block_str;
+    {
+      std::ostringstream mesh_str;
+      Omega_h::binary::write(mesh_str, picparts.mesh());
+      const std::string mesh_bytes = mesh_str.str();
+      Omega_h::I64 mesh_size = mesh_bytes.size();
+      Omega_h::binary::write_value(block_str, mesh_size, swap);
+      block_str.write(mesh_bytes.data(), mesh_size);
+    }
+    picparts.writeMetadata(block_str);
+    const std::string block = block_str.str();
+    long long block_size = block.size();
+    //Every rank must agree before throwing, otherwise the others block in the collectives
+    int too_large = block_size > INT_MAX;
+    int any_too_large = 0;
+    MPI_Allreduce(&too_large, &any_too_large, 1, MPI_INT, MPI_MAX, mpi_comm);
+    if (any_too_large) {
+      if (too_large)
+        fprintf(stderr, "[ERROR] Picpart on rank %d is too large for a single file container\n",
+                rank);
+      throw std::runtime_error("Picpart block too large");
+    }
+
+    //Build the index of per rank offsets on rank 0
+    std::vector<long long> block_sizes(comm_size);
+    MPI_Gather(&block_size, 1, MPI_LONG_LONG, block_sizes.data(), 1, MPI_LONG_LONG, 0,
+               mpi_comm);
+    const MPI_Offset header_size = container_prefix_size +
+      (comm_size + 1) * sizeof(Omega_h::I64);
+    long long block_offset = 0;
+    MPI_Exscan(&block_size, &block_offset, 1, MPI_LONG_LONG, MPI_SUM, mpi_comm);
+    if (rank == 0)
+      block_offset = 0;
+
+    MPI_Info info = collectiveInfo();
+    MPI_File fh;
+    if (MPI_File_open(mpi_comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, info, &fh)
+        != MPI_SUCCESS) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] Failed to open file %s\n", filename);
+      MPI_Info_free(&info);
+      return;
+    }
+    MPI_File_set_size(fh, 0);
+    if (rank == 0) {
+      std::ostringstream header_str;
+      header_str.write(container_magic, sizeof(container_magic));
+      Omega_h::binary::write_value(header_str, container_version, swap);
+      Omega_h::binary::write_value(header_str, (Omega_h::I32)comm_size, swap);
+      Omega_h::binary::write_value(header_str, (Omega_h::I32)Omega_h::binary::latest_version,
+                                   swap);
+      Omega_h::I64 offset = header_size;
+      for (int i = 0; i <= comm_size; ++i) {
+        Omega_h::binary::write_value(header_str, offset, swap);
+        if (i < comm_size)
+          offset += block_sizes[i];
+      }
+      const std::string header = header_str.str();
+      MPI_File_write_at(fh, 0, header.data(), header.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    MPI_File_write_at_all(fh, header_size + block_offset, block.data(), block_size, MPI_BYTE,
+                          MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    MPI_Info_free(&info);
+  }
+
+  void readSingleFile(Omega_h::Library* library, Omega_h::CommPtr comm, const char* path,
+                      Mesh* mesh, int stored_ranks) {
+    MPI_Comm mpi_comm = comm->get_impl();
+    int rank = comm->rank();
+    int comm_size = comm->size();
+    bool swap = !is_little_endian_cpu();
+    if (stored_ranks < 0)
+      stored_ranks = comm_size;
+    char filename[4096];
+    sprintf(filename, "%s_%d.ppc", path, stored_ranks);
+
+    //Opening is collective so every rank sees the failure and throws
+    MPI_Info info = collectiveInfo();
+    MPI_File fh;
+    if (MPI_File_open(mpi_comm, filename, MPI_MODE_RDONLY, info, &fh) != MPI_SUCCESS) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] Cannot open file %s\n", filename);
+      MPI_Info_free(&info);
+      throw std::runtime_error("Cannot open picpart container");
+    }
+
+    //Read the header prefix
+    std::string prefix(container_prefix_size, '\0');
+    MPI_File_read_at_all(fh, 0, &prefix[0], container_prefix_size, MPI_BYTE,
+                         MPI_STATUS_IGNORE);
+    std::istringstream prefix_str(prefix);
+    char magic[4];
+    prefix_str.read(magic, sizeof(magic));
+    Omega_h::I32 version, nranks, osh_version;
+    Omega_h::binary::read_value(prefix_str, version, swap);
+    Omega_h::binary::read_value(prefix_str, nranks, swap);
+    Omega_h::binary::read_value(prefix_str, osh_version, swap);
+    if (strncmp(magic, container_magic, sizeof(magic)) || version > container_version ||
+        nranks != stored_ranks) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] %s is not a picpart container for %d ranks\n", filename,
+                stored_ranks);
+      MPI_File_close(&fh);
+      MPI_Info_free(&info);
+      throw std::runtime_error("Invalid picpart container");
+    }
+    if (nranks < comm_size) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] %s holds %d picparts which cannot be read on %d ranks\n",
+                filename, nranks, comm_size);
+      MPI_File_close(&fh);
+      MPI_Info_free(&info);
+      throw std::runtime_error("Too many ranks for picpart container");
+    }
+
+    //Each rank reads the contiguous range of stored parts it is assigned
+    //  (a single part when the number of ranks is unchanged)
+    const int first_part = (long)rank * nranks / comm_size;
+    const int end_part = (long)(rank + 1) * nranks / comm_size;
+    const int num_parts = end_part - first_part;
+    std::string index((num_parts + 1) * sizeof(Omega_h::I64), '\0');
+    MPI_File_read_at_all(fh, container_prefix_size + first_part * sizeof(Omega_h::I64),
+                         &index[0], index.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+    std::istringstream index_str(index);
+    std::vector<Omega_h::I64> block_offsets(num_parts + 1);
+    for (int i = 0; i <= num_parts; ++i)
+      Omega_h::binary::read_value(index_str, block_offsets[i], swap);
+
+    //Collectively read the blocks of this rank
+    std::string blocks(block_offsets[num_parts] - block_offsets[0], '\0');
+    MPI_File_read_at_all(fh, block_offsets[0], &blocks[0], blocks.size(), MPI_BYTE,
+                         MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    MPI_Info_free(&info);
+
+    Omega_h::Mesh* part_mesh = new Omega_h::Mesh(library);
+    Omega_h::I64 mesh_size = readBlockMesh(library, blocks, 0, osh_version, swap, part_mesh);
+    std::istringstream block_str(blocks);
+    block_str.seekg(sizeof(Omega_h::I64) + mesh_size);
+    Omega_h::HostWrite<Omega_h::LO> sbar_data = mesh->readMetadata(block_str);
+    if (nranks == comm_size) {
+      mesh->picpart = part_mesh;
+      mesh->finalizeRead(comm, sbar_data);
+      return;
+    }
+
+    //Only picparts buffering the full mesh store enough of the mesh to be repartitioned
+    if (!mesh->is_full_mesh) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] Reading %s on %d ranks requires picparts with a full "
+                "mesh buffer\n", filename, comm_size);
+      delete part_mesh;
+      throw std::runtime_error("Picpart container cannot be repartitioned");
+    }
+
+    //Rebuild the picparts from the stored full mesh where this rank owns the elements of
+    //  its stored parts and the safe zone is the union of their safe zones
+    Omega_h::Mesh* full_mesh = part_mesh;
+    const int dim = full_mesh->dim();
+    const Omega_h::LO nelems = full_mesh->nelems();
+    Omega_h::Write<Omega_h::LO> is_safe(nelems, 0, "is_safe");
+    for (int i = 0; i < num_parts; ++i) {
+      Omega_h::LOs part_safe = full_mesh->get_array<Omega_h::LO>(dim, "safe");
+      if (i > 0) {
+        Omega_h::Mesh stored(library);
+        readBlockMesh(library, blocks, block_offsets[i] - block_offsets[0], osh_version,
+                      swap, &stored);
+        part_safe = stored.get_array<Omega_h::LO>(dim, "safe");
+      }
+      auto unionSafe = OMEGA_H_LAMBDA(const Omega_h::LO elm) {
+        if (part_safe[elm])
+          is_safe[elm] = 1;
+      };
+      Omega_h::parallel_for(nelems, unionSafe, "unionSafe");
+    }
+    Omega_h::LOs stored_owners = full_mesh->get_array<Omega_h::LO>(dim, "ownership");
+    Omega_h::Write<Omega_h::LO> owners(nelems, "owners");
+    auto mapOwners = OMEGA_H_LAMBDA(const Omega_h::LO elm) {
+      owners[elm] = ((Omega_h::GO)(stored_owners[elm] + 1) * comm_size - 1) / nranks;
+    };
+    Omega_h::parallel_for(nelems, mapOwners, "mapOwners");
+    Omega_h::Write<Omega_h::LO> has_part(comm_size, 1, "has_part");
+    mesh->constructPICPart(*full_mesh, comm, owners, has_part, is_safe);
+    mesh->owns_full_mesh = true;
   }
 }
@@ -102,6 +102,7 @@ namespace pumipic {
     bridge_dim = 0;
     bufferBFSLayers = 3;
     safeBFSLayers = 1;
+    shareFullMesh = false;
 
     if (bufferMethod == MINIMUM)
       bufferBFSLayers = 0;
@@ -128,6 +129,7 @@ namespace pumipic {
     bridge_dim = 0;
     bufferBFSLayers = 3;
     safeBFSLayers = 1;
+    shareFullMesh = false;
 
     if (bufferMethod == MINIMUM)
       bufferBFSLayers = 0;
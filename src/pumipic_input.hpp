@@ -64,6 +64,11 @@ namespace pumipic {
     int bufferBFSLayers;
     //For Method = BFS, # of layers of BFS to go out for safe zone (defaults to 1)
     int safeBFSLayers;
+    //For bufferMethod = FULL, place the rank independent mesh arrays (coordinates, global
+    //  tags and adjacencies) once per node in MPI shared memory (defaults to false)
+    //  The picpart is then a copy of the input mesh owned by the pumipic::Mesh and the
+    //  input mesh is released to an empty mesh on all but the first rank of each node
+    bool shareFullMesh;
 
     friend class Mesh;
   private:
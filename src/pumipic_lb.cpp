@@ -3,6 +3,10 @@
 #include "pumipic_mesh.hpp"
 #include <particle_structs.hpp>
 #include <Omega_h_for.hpp>
+#include <Omega_h_sort.hpp>
+#include <Omega_h_scan.hpp>
+#include <algorithm>
+#include <stdexcept>
 
 namespace pumipic {
   typedef Omega_h::LO LO;
@@ -15,6 +19,16 @@ namespace pumipic {
     Omega_h::parallel_for(ne, setSafeCommArray, "setSafeCommArray");
   }
 
+  //Mixes the bits of a 64 bit value (splitmix64 finalizer)
+  OMEGA_H_INLINE unsigned long long mixBits(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
   ParticleBalancer::~ParticleBalancer() {
     agi::destroyGraph(weightGraph);
     //Return PCU communicator to world
@@ -63,9 +77,9 @@ namespace pumipic {
     delete [] send_requests;
 
     //Determine the overlapping safe zones(sbars) for each element (CPU)
-    Omega_h::HostWrite<int> core_elm_sbar = buildLocalSbarMap(comm_rank, core_nents,
-                                                              buffer_ranks,
-                                                              safe_core_per_buffer);
+    Omega_h::HostWrite<int> core_elm_sbar = buildLocalSbarMapDevice(comm_rank, core_nents,
+                                                                    buffer_ranks,
+                                                                    safe_core_per_buffer);
 
     sendCoreSbars(comm, buffer_ranks);
 
@@ -82,6 +96,45 @@ namespace pumipic {
     MPI_Type_free(&bufferStride);
   }
 
+  ParticleBalancer::ParticleBalancer(Mesh& picparts, Omega_h::HostWrite<LO> sbar_data) {
+    Omega_h::CommPtr comm = picparts.comm();
+    //Change PCU communicator to the mesh communicator
+    PCU_Switch_Comm(comm->get_impl());
+
+    //Restore the globally numbered sbars of this process
+    max_sbar = sbar_data[0];
+    int num_sbars = sbar_data[1];
+    int index = 2;
+    for (int i = 0; i < num_sbars; ++i) {
+      int id = sbar_data[index++];
+      int nparts = sbar_data[index++];
+      Parts parts;
+      for (int j = 0; j < nparts; ++j)
+        parts.insert(sbar_data[index++]);
+      sbar_ids[parts] = id;
+    }
+
+    //Build N-graph from indices (CPU)
+    buildNgraph(comm);
+  }
+
+  Omega_h::HostWrite<LO> ParticleBalancer::serialize() const {
+    int length = 2;
+    for (auto itr = sbar_ids.begin(); itr != sbar_ids.end(); ++itr)
+      length += 2 + itr->first.size();
+    Omega_h::HostWrite<LO> sbar_data(length, "sbar_data");
+    sbar_data[0] = max_sbar;
+    sbar_data[1] = sbar_ids.size();
+    int index = 2;
+    for (auto itr = sbar_ids.begin(); itr != sbar_ids.end(); ++itr) {
+      sbar_data[index++] = itr->second;
+      sbar_data[index++] = itr->first.size();
+      for (auto pitr = itr->first.begin(); pitr != itr->first.end(); ++pitr)
+        sbar_data[index++] = *pitr;
+    }
+    return sbar_data;
+  }
+
   ParticleBalancer::SBarUnmap::iterator ParticleBalancer::insert(Parts& p) {
     auto itr = sbar_ids.find(p);
     if (itr == sbar_ids.end()) {
@@ -109,6 +162,82 @@ namespace pumipic {
     return core_elm_sbar;
   }
 
+  Omega_h::HostWrite<int> ParticleBalancer::buildLocalSbarMapDevice(int comm_rank, int nelms,
+                                           Omega_h::HostWrite<LO> buffer_ranks,
+                                           Omega_h::HostWrite<LO> safe_core_per_buffer) {
+    const int nbuffers = buffer_ranks.size();
+    if (nelms == 0)
+      return Omega_h::HostWrite<int>(0, "core_sbars");
+    Omega_h::LOs safe_per_buffer(Omega_h::Write<LO>(safe_core_per_buffer));
+
+    //Key each element by a 64 bit hash of the buffers whose safe zone contains it
+    //  The buffer ranks are shared by all elements so the buffer index identifies the rank
+    Omega_h::Write<Omega_h::GO> keys(nelms, "sbar_keys");
+    auto hashSbar = OMEGA_H_LAMBDA(const LO elm) {
+      unsigned long long h = mixBits(comm_rank + 1);
+      for (int j = 0; j < nbuffers; ++j) {
+        if (safe_per_buffer[elm * nbuffers + j])
+          h = mixBits(h ^ (unsigned long long)(j + 1));
+      }
+      keys[elm] = (Omega_h::GO)(h >> 1);
+    };
+    Omega_h::parallel_for(nelms, hashSbar, "hashSbar");
+
+    //Sort the keys and number each unique key with a scan
+    Omega_h::GOs keys_r(keys);
+    Omega_h::LOs perm = Omega_h::sort_by_keys(keys_r);
+    Omega_h::Write<LO> is_first(nelms, "is_first");
+    auto markUnique = OMEGA_H_LAMBDA(const LO i) {
+      is_first[i] = (i == 0) || (keys_r[perm[i]] != keys_r[perm[i - 1]]);
+    };
+    Omega_h::parallel_for(nelms, markUnique, "markUnique");
+    Omega_h::LOs sbar_offsets = Omega_h::offset_scan(Omega_h::LOs(is_first));
+    const LO num_sbars = Omega_h::HostRead<LO>(sbar_offsets).last();
+
+    //Assign sbar ids and record the first element of each sbar as its representative
+    Omega_h::Write<LO> elm_sbar_d(nelms, "core_sbars");
+    Omega_h::Write<LO> representative(num_sbars, "sbar_representative");
+    auto numberSbars = OMEGA_H_LAMBDA(const LO i) {
+      const LO elm = perm[i];
+      const LO sbar = sbar_offsets[i + 1] - 1;
+      elm_sbar_d[elm] = sbar;
+      if (is_first[i])
+        representative[sbar] = elm;
+    };
+    Omega_h::parallel_for(nelms, numberSbars, "numberSbars");
+
+    //Check that no two distinct buffer sets share a key
+    Omega_h::Write<LO> collision(1, 0, "collision");
+    auto checkCollision = OMEGA_H_LAMBDA(const LO elm) {
+      const LO rep = representative[elm_sbar_d[elm]];
+      for (int j = 0; j < nbuffers; ++j) {
+        if ((safe_per_buffer[elm * nbuffers + j] != 0) !=
+            (safe_per_buffer[rep * nbuffers + j] != 0))
+          collision[0] = 1;
+      }
+    };
+    Omega_h::parallel_for(nelms, checkCollision, "checkCollision");
+    if (Omega_h::HostWrite<LO>(collision)[0]) {
+      fprintf(stderr, "[WARNING] Rank %d sbar hash collision, building sbars on the host\n",
+              comm_rank);
+      return buildLocalSbarMap(comm_rank, nelms, buffer_ranks, safe_core_per_buffer);
+    }
+
+    //Only the unique sbars are converted to rank sets on the host
+    Omega_h::HostRead<LO> representative_host(representative);
+    for (LO i = 0; i < num_sbars; ++i) {
+      const LO rep = representative_host[i];
+      Parts parts;
+      parts.insert(comm_rank);
+      for (int j = 0; j < nbuffers; ++j) {
+        if (safe_core_per_buffer[rep * nbuffers + j])
+          parts.insert(buffer_ranks[j]);
+      }
+      sbar_ids[parts] = i;
+    }
+    return Omega_h::HostWrite<int>(elm_sbar_d);
+  }
+
   void ParticleBalancer::sendCoreSbars(Omega_h::CommPtr comm,
                                        Omega_h::HostWrite<LO> buffer_ranks) {
     int comm_rank = comm->rank();
@@ -537,4 +666,66 @@ namespace pumipic {
     : sbar_to_index(sbar_index_map.size()), part_ids(tgt_parts), send_wgts(wgts){
     buildMap(sbar_index_map, sbar_to_index);
   }
+
+  namespace {
+    //Reduces [load, total] pairs to [max load, sum of totals]
+    void maxSumOp(void* in, void* inout, int* len, MPI_Datatype*) {
+      double* a = static_cast<double*>(in);
+      double* b = static_cast<double*>(inout);
+      for (int i = 0; i + 1 < *len; i += 2) {
+        b[i] = std::max(a[i], b[i]);
+        b[i + 1] += a[i + 1];
+      }
+    }
+  }
+
+  BalancePolicy::BalancePolicy(double target_tol, double trigger_tol,
+                               int check_interval, bool predict)
+    : target(target_tol), trigger(trigger_tol), interval(check_interval),
+      use_prediction(predict), balancing(false), flux(0), steps(0),
+      balance_steps(0), last_imb(1.0) {
+    if (trigger < target) {
+      fprintf(stderr, "[ERROR] BalancePolicy trigger tolerance (%f) must not be below "
+              "the target tolerance (%f)\n", trigger, target);
+      throw std::runtime_error("Invalid balance policy tolerances");
+    }
+    if (interval < 1)
+      interval = 1;
+    MPI_Op_create(maxSumOp, 1, &max_sum_op);
+  }
+
+  BalancePolicy::~BalancePolicy() {
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (!finalized)
+      MPI_Op_free(&max_sum_op);
+  }
+
+  bool BalancePolicy::shouldBalance(MPI_Comm comm, int nptcls) {
+    const int step = steps++;
+    //The imbalance is checked every step while balancing to know when to stop
+    if (!balancing && step % interval != 0)
+      return false;
+    double load = nptcls;
+    if (use_prediction)
+      load = std::max(0.0, load + flux);
+    double local[2] = {load, (double)nptcls};
+    double global[2];
+    MPI_Allreduce(local, global, 2, MPI_DOUBLE, max_sum_op, comm);
+    int comm_size;
+    MPI_Comm_size(comm, &comm_size);
+    const double avg = global[1] / comm_size;
+    last_imb = avg > 0 ? global[0] / avg : 1.0;
+    if (balancing && last_imb < target)
+      balancing = false;
+    else if (!balancing && last_imb > trigger)
+      balancing = true;
+    if (balancing)
+      ++balance_steps;
+    return balancing;
+  }
+
+  void BalancePolicy::recordMigration(int nptcls_before, int nptcls_after) {
+    flux = nptcls_after - nptcls_before;
+  }
 }
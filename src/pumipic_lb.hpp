@@ -8,6 +8,9 @@
 #include <engpar_weight_input.h>
 #include <engpar.h>
 #include <particle_structs.hpp>
+#include <Omega_h_sort.hpp>
+#include <Omega_h_scan.hpp>
+#include <climits>
 
 namespace pumipic {
 
@@ -15,10 +18,11 @@ namespace pumipic {
   class PartsHash {
   public:
     size_t operator()(const Parts& res) const {
-      int h = 0;
+      //Order dependent combine so symmetric rank sets do not collide
+      size_t h = res.size();
       std::hash<int> hasher;
       for (auto itr = res.begin(); itr != res.end(); ++itr)
-        h ^= hasher(*itr);
+        h ^= hasher(*itr) + 0x9e3779b9 + (h << 6) + (h >> 2);
       return h;
     }
   };
@@ -32,8 +36,17 @@ namespace pumipic {
 
   class ParticleBalancer {
   public:
+    //Strategy used by selectParticles to pick the particles of each sbar to send
+    enum SelectionMode {
+      ATOMIC_SELECTION, //particles claim plan weight with atomics (default)
+      SCAN_SELECTION //particles are ranked in each sbar with a sort and scan, deterministic
+    };
+
     //Build Ngraph from sbars
     ParticleBalancer(Mesh& picparts);
+    //Rebuild from sbars stored by serialize, skipping the sbar construction
+    //  The element sbar ids must already be on the mesh in the "sbar_id" tag
+    ParticleBalancer(Mesh& picparts, Omega_h::HostWrite<Omega_h::LO> sbar_data);
     ~ParticleBalancer();
 
     /* Performs particle load balancing and redistributes particles
@@ -52,6 +65,19 @@ namespace pumipic {
                      typename PS::kkLidView new_procs,
                      double step_factor = 0.3);
 
+    /* Performs cost weighted particle load balancing, the weight transferred between
+         processes is the sum of particle costs instead of the number of particles
+       ptcl_costs(in) - the cost of each particle (indexed by particle like new_elems)
+       See repartition above for the other arguments
+       Note: the element costs set by setElementCosts multiply the particle costs
+     */
+    template <class PS>
+    void repartition(Mesh& picparts, PS* ps, double tol,
+                     typename PS::kkLidView new_elems,
+                     typename PS::kkLidView new_procs,
+                     typename PS::template View<Omega_h::Real> ptcl_costs,
+                     double step_factor = 0.3);
+
     /* Performs particle load balancing on an array of particles per element
        picparts(in) - the picparts mesh
        ptcls_per_elem - the number of particles per element (size must equal number of elements in `picparts`)
@@ -66,12 +92,30 @@ namespace pumipic {
     //Access the sbar ids per element
     Omega_h::LOs getSbarIDs(Mesh& picparts) const;
 
+    //Set the particle selection strategy
+    void setSelectionMode(SelectionMode mode) {selection_mode = mode;}
+
+    /* Set the cost of a particle in each element (size must equal number of elements)
+         Costs can come from measured work, e.g. search loops or kernel time per element
+         divided by the particles in the element. An empty array restores unit costs
+     */
+    void setElementCosts(Omega_h::Reals costs) {elem_costs = costs;}
+    Omega_h::Reals elementCosts() const {return elem_costs;}
+
+    //Flatten the sbars of this process to [max_sbar, # sbars, (id, # parts, parts...)...]
+    Omega_h::HostWrite<Omega_h::LO> serialize() const;
+
     /* Steps of repartition, can be called on their own for customization */
 
     //adds the weight of particles in ps to graph
     template <class PS>
     void addWeights(Mesh& picparts, PS* ps, typename PS::kkLidView new_elems,
                     typename PS::kkLidView new_procs);
+    //adds the cost of particles in ps to graph
+    template <class PS>
+    void addWeights(Mesh& picparts, PS* ps, typename PS::kkLidView new_elems,
+                    typename PS::kkLidView new_procs,
+                    typename PS::template View<Omega_h::Real> ptcl_costs);
 
     //adds the weight of particles in ptcls_per_elem to graph
     template <class ViewT>
@@ -83,11 +127,17 @@ namespace pumipic {
     template <class PS>
     void selectParticles(Mesh& picparts, PS* ps, typename PS::kkLidView new_elems,
                          ParticlePlan plan, typename PS::kkLidView new_parts);
+    template <class PS>
+    void selectParticles(Mesh& picparts, PS* ps, typename PS::kkLidView new_elems,
+                         ParticlePlan plan, typename PS::kkLidView new_parts,
+                         typename PS::template View<Omega_h::Real> ptcl_costs);
 
     template <typename ViewT>
     Kokkos::View<lid_t*> selectParticles(Mesh& picparts, ViewT ptcls_per_elem, ParticlePlan plan, int selection_iterations);
 private:
     typedef std::unordered_map<Parts, int, PartsHash> SBarUnmap;
+    SelectionMode selection_mode = ATOMIC_SELECTION;
+    Omega_h::Reals elem_costs;
     int max_sbar;
     SBarUnmap sbar_ids;
     Omega_h::HostWrite<int> elm_sbar;
@@ -103,6 +153,10 @@ private:
     Omega_h::HostWrite<int> buildLocalSbarMap(int comm_rank, int nelms,
                                               Omega_h::HostWrite<Omega_h::LO> buffer_ranks,
                                               Omega_h::HostWrite<Omega_h::LO> safe_per_buffer);
+    //Device parallel version of buildLocalSbarMap using hashed keys, sort and scan
+    Omega_h::HostWrite<int> buildLocalSbarMapDevice(int comm_rank, int nelms,
+                                                    Omega_h::HostWrite<Omega_h::LO> buffer_ranks,
+                                                    Omega_h::HostWrite<Omega_h::LO> safe_per_buffer);
     void sendCoreSbars(Omega_h::CommPtr comm, Omega_h::HostWrite<Omega_h::LO> buffer_ranks);
     void globalNumberSbars(Omega_h::CommPtr comm,
                            std::unordered_map<int,int>& sbar_local_to_global);
@@ -125,10 +179,150 @@ private:
     Omega_h::Write<Omega_h::Real> send_wgts;
   };
 
+  /* Decides when the particle load balancer runs in migrate_lb_ptcls
+     Balancing starts once the imbalance exceeds trigger_tol and continues every
+       step until the imbalance falls below target_tol, so steady state steps only
+       pay for one small allreduce (every check_interval steps)
+     When predict is set the load of each process is extrapolated by the net change
+       in particles of the previous migration, so balancing starts before the
+       imbalance occurs
+   */
+  class BalancePolicy {
+  public:
+    BalancePolicy(double target_tol = 1.05, double trigger_tol = 1.2,
+                  int check_interval = 1, bool predict = true);
+    //The policy owns an MPI_Op so it cannot be copied
+    BalancePolicy(const BalancePolicy&) = delete;
+    BalancePolicy& operator=(const BalancePolicy&) = delete;
+    ~BalancePolicy();
+
+    //Returns true if the balancer should run this step, collective over comm
+    bool shouldBalance(MPI_Comm comm, int nptcls);
+    //Record the number of particles before and after a migration
+    void recordMigration(int nptcls_before, int nptcls_after);
+
+    //The imbalance (max / avg) at the last check
+    double imbalance() const {return last_imb;}
+    //The imbalance passed to the balancer
+    double targetTol() const {return target;}
+    bool isBalancing() const {return balancing;}
+    //The number of steps the balancer ran and the number of steps checked
+    int numBalanceSteps() const {return balance_steps;}
+    int numSteps() const {return steps;}
+  private:
+    double target;
+    double trigger;
+    int interval;
+    bool use_prediction;
+    bool balancing;
+    int flux;
+    int steps;
+    int balance_steps;
+    double last_imb;
+    MPI_Op max_sum_op;
+  };
+
+  /* Returns the part a selected particle of an sbar is sent to
+     The plan entries of the sbar start at index and end with a part of -1
+     rank is the weight of the particles selected before it in the sbar
+     Returns -1 if the planned weight of the sbar is exhausted
+   */
+  OMEGA_H_INLINE Omega_h::LO planTarget(Omega_h::LOs part_ids,
+                                        Omega_h::Write<Omega_h::Real> send_wgts,
+                                        Omega_h::LO index, Omega_h::Real rank) {
+    for (Omega_h::LO i = index; part_ids[i] >= 0; ++i) {
+      const Omega_h::Real wgt = send_wgts[i];
+      if (wgt <= 0)
+        continue;
+      if (rank < wgt)
+        return part_ids[i];
+      rank -= wgt;
+    }
+    return -1;
+  }
+
+  //The cost of a particle from the optional particle and element costs
+  template <class CostView>
+  OMEGA_H_INLINE Omega_h::Real ptclCost(const CostView& ptcl_costs,
+                                        const Omega_h::Reals& elem_costs,
+                                        const int ptcl, const int elm) {
+    Omega_h::Real cost = 1.0;
+    if (ptcl_costs.size() > 0)
+      cost = ptcl_costs(ptcl);
+    if (elem_costs.size() > 0)
+      cost *= elem_costs[elm];
+    return cost;
+  }
+
+  /* Claims cost from the plan entry at the current index of an sbar with atomics
+     Advances the index of the sbar once the entry's weight is exhausted
+     Returns the part to send the particle to or -1 if the weight was already taken
+   */
+  template <class Map>
+  OMEGA_H_INLINE Omega_h::LO claimPlanWeight(Map& sbar_to_index, const uint32_t map_index,
+                                             Omega_h::LOs part_ids,
+                                             Omega_h::Write<Omega_h::Real> send_wgts,
+                                             const Omega_h::Real cost) {
+    const Omega_h::LO index = sbar_to_index.value_at(map_index);
+    const Omega_h::LO part = part_ids[index];
+    if (part < 0)
+      return -1;
+    const Omega_h::Real wgt = Kokkos::atomic_fetch_add(&(send_wgts[index]), -cost);
+    if (wgt <= 0)
+      return -1;
+    if (wgt - cost <= 0)
+      Kokkos::atomic_add(&(sbar_to_index.value_at(map_index)), 1);
+    return part;
+  }
+
+  /* Computes the rank of each sorted entry within its segment of equal segment ids
+     sorted_segments(in) - the segment of each entry in sorted order
+     counts(in) - the weight of each entry in sorted order
+     Returns the weight of the entries before each entry in its segment
+   */
+  inline Omega_h::Reals segmentedRanks(Omega_h::LOs sorted_segments, Omega_h::Reals counts) {
+    const Omega_h::LO n = sorted_segments.size();
+    Omega_h::Write<Omega_h::LO> is_first(n, "is_first");
+    auto markFirst = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+      is_first[i] = (i == 0) || (sorted_segments[i] != sorted_segments[i - 1]);
+    };
+    Omega_h::parallel_for(n, markFirst, "markFirst");
+    Omega_h::LOs segment_ids = Omega_h::offset_scan(Omega_h::LOs(is_first));
+    Omega_h::Write<Omega_h::Real> offsets(n, "offsets");
+    Kokkos::parallel_scan("weightOffsets", n,
+                          KOKKOS_LAMBDA(const int i, Omega_h::Real& sum, const bool final) {
+      if (final)
+        offsets[i] = sum;
+      sum += counts[i];
+    });
+    const Omega_h::LO nsegments = Omega_h::HostRead<Omega_h::LO>(segment_ids).last();
+    Omega_h::Write<Omega_h::Real> segment_start(nsegments, "segment_start");
+    auto setStart = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+      if (is_first[i])
+        segment_start[segment_ids[i]] = offsets[i];
+    };
+    Omega_h::parallel_for(n, setStart, "setStart");
+    Omega_h::Write<Omega_h::Real> ranks(n, "segment_ranks");
+    auto setRanks = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+      ranks[i] = offsets[i] - segment_start[segment_ids[i + 1] - 1];
+    };
+    Omega_h::parallel_for(n, setRanks, "setRanks");
+    return ranks;
+  }
+
   template <class PS>
   void ParticleBalancer::addWeights(Mesh& picparts, PS* ptcls,
                                     typename PS::kkLidView new_elems,
                                     typename PS::kkLidView new_procs) {
+    addWeights(picparts, ptcls, new_elems, new_procs,
+               typename PS::template View<Omega_h::Real>());
+  }
+
+  template <class PS>
+  void ParticleBalancer::addWeights(Mesh& picparts, PS* ptcls,
+                                    typename PS::kkLidView new_elems,
+                                    typename PS::kkLidView new_procs,
+                                    typename PS::template View<Omega_h::Real> ptcl_costs) {
     MPI_Comm comm = picparts.comm()->get_impl();
     int comm_rank = picparts.comm()->rank();
     // Device map of number of particles already assigned to another process
@@ -138,27 +332,29 @@ private:
         forcedPtcls.insert(buffered_ranks[i], 0);
     });
 
-    //Count particles in each sbar & count particles already being migrated
+    //Sum particle costs in each sbar & of particles already being migrated
     Omega_h::Write<agi::wgt_t> weights(sbar_ids.size() + 1, 0);
     Omega_h::LOs elem_sbars = getSbarIDs(picparts);
     auto sbar_to_vert_local = sbar_to_vert;
+    Omega_h::Reals costs = elem_costs;
     auto accumulateWeight = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
       if (mask) {
         const int new_rank = new_procs(ptcl);
+        const int e = new_elems(ptcl);
         if (new_rank == comm_rank) {
-          const int e = new_elems(ptcl);
           if (e != -1) {
             int sbar_index = elem_sbars[e];
             if (sbar_to_vert_local.exists(sbar_index)) {
               auto index = sbar_to_vert_local.find(sbar_index);
               const agi::lid_t vert_index = sbar_to_vert_local.value_at(index);
-              Kokkos::atomic_add(&(weights[vert_index]), 1.0);
+              Kokkos::atomic_add(&(weights[vert_index]), ptclCost(ptcl_costs, costs, ptcl, e));
             }
           }
         }
         else {
           const auto index = forcedPtcls.find(new_rank);
-          Kokkos::atomic_add(&(forcedPtcls.value_at(index)), 1.0);
+          const agi::wgt_t cost = e != -1 ? ptclCost(ptcl_costs, costs, ptcl, e) : 1.0;
+          Kokkos::atomic_add(&(forcedPtcls.value_at(index)), cost);
         }
       }
     };
@@ -211,12 +407,14 @@ private:
     Omega_h::Write<agi::wgt_t> weights(sbar_ids.size() + 1, 0);
     Omega_h::LOs elem_sbars = getSbarIDs(picparts);
     auto sbar_to_vert_local = sbar_to_vert;
+    Omega_h::Reals costs = elem_costs;
     auto accumulateWeight = OMEGA_H_LAMBDA(const int elm) {
       const Omega_h::LO sbar_index = elem_sbars[elm];
       if (sbar_to_vert_local.exists(sbar_index)) {
         auto index = sbar_to_vert_local.find(sbar_index);
         const agi::lid_t vert_index = sbar_to_vert_local.value_at(index);
-        Kokkos::atomic_add(&(weights[vert_index]), 1.0*ptcls_per_elem[elm]);
+        const Omega_h::Real cost = costs.size() > 0 ? costs[elm] : 1.0;
+        Kokkos::atomic_add(&(weights[vert_index]), cost*ptcls_per_elem[elm]);
       }
     };
     Omega_h::parallel_for(ptcls_per_elem.size(), accumulateWeight, "accumulateWeight");
@@ -231,6 +429,16 @@ private:
                                          typename PS::kkLidView new_elems,
                                          ParticlePlan plan,
                                          typename PS::kkLidView new_parts) {
+    selectParticles(picparts, ptcls, new_elems, plan, new_parts,
+                    typename PS::template View<Omega_h::Real>());
+  }
+
+  template <class PS>
+  void ParticleBalancer::selectParticles(Mesh& picparts, PS* ptcls,
+                                         typename PS::kkLidView new_elems,
+                                         ParticlePlan plan,
+                                         typename PS::kkLidView new_parts,
+                                         typename PS::template View<Omega_h::Real> ptcl_costs) {
 
     int comm_size = picparts.comm()->size();
     if (comm_size == 1)
@@ -241,6 +449,52 @@ private:
     auto sbar_to_index = plan.sbar_to_index;
     auto part_ids = plan.part_ids;
     auto owners = picparts.entOwners(picparts->dim());
+    Omega_h::Reals costs = elem_costs;
+    if (selection_mode == SCAN_SELECTION) {
+      //Key candidates by (plan index of the sbar, core flag, particle) so particles
+      //  heading to non core elements are selected first within each sbar
+      const Omega_h::GO invalid = LLONG_MAX;
+      Omega_h::Write<Omega_h::GO> keys(ptcls->capacity(), invalid, "selection_keys");
+      auto setKeys = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+        const Omega_h::LO new_e = new_elems(ptcl);
+        const Omega_h::LO new_p = new_parts(ptcl);
+        if (mask && new_p == comm_rank && new_e != -1) {
+          const Omega_h::LO sbar = sbars[new_e];
+          if (sbar_to_index.exists(sbar)) {
+            const Omega_h::GO index = sbar_to_index.value_at(sbar_to_index.find(sbar));
+            const Omega_h::GO is_core = owners[new_e] == comm_rank;
+            keys[ptcl] = (index << 33) | (is_core << 32) | ptcl;
+          }
+        }
+      };
+      parallel_for(ptcls, setKeys, "setSelectionKeys");
+      Omega_h::GOs keys_r(keys);
+      Omega_h::LOs perm = Omega_h::sort_by_keys(keys_r);
+      Omega_h::LO ncandidates = 0;
+      Kokkos::parallel_reduce("countCandidates", keys_r.size(),
+                              KOKKOS_LAMBDA(const int i, Omega_h::LO& count) {
+        count += keys_r[i] != invalid;
+      }, ncandidates);
+
+      //Rank the candidates in each sbar and take exactly the planned count
+      Omega_h::Write<Omega_h::LO> plan_index(ncandidates, "plan_index");
+      Omega_h::Write<Omega_h::Real> cand_costs(ncandidates, "candidate_costs");
+      auto setPlanIndex = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+        const Omega_h::LO ptcl = perm[i];
+        plan_index[i] = keys_r[ptcl] >> 33;
+        cand_costs[i] = ptclCost(ptcl_costs, costs, ptcl, new_elems(ptcl));
+      };
+      Omega_h::parallel_for(ncandidates, setPlanIndex, "setPlanIndex");
+      Omega_h::Reals ranks = segmentedRanks(Omega_h::LOs(plan_index),
+                                            Omega_h::Reals(cand_costs));
+      auto assignParts = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+        const Omega_h::LO part = planTarget(part_ids, send_wgts, plan_index[i], ranks[i]);
+        if (part >= 0)
+          new_parts[perm[i]] = part;
+      };
+      Omega_h::parallel_for(ncandidates, assignParts, "assignParts");
+      return;
+    }
     auto selectNonCoreParticles = PS_LAMBDA(const int elm, int ptcl, const bool mask) {
       const Omega_h::LO new_e = new_elems(ptcl);
       const Omega_h::LO new_p = new_parts(ptcl);
@@ -250,15 +504,11 @@ private:
           const Omega_h::LO sbar = sbars[new_e];
           if (sbar_to_index.exists(sbar)) {
             const auto map_index = sbar_to_index.find(sbar);
-            const Omega_h::LO index = sbar_to_index.value_at(map_index);
-            const Omega_h::LO part = part_ids[index];
-            const Omega_h::Real wgt = Kokkos::atomic_fetch_add(&(send_wgts[index]), -1);
-            if (part >= 0) {
-              if (wgt == 0)
-                Kokkos::atomic_add(&(sbar_to_index.value_at(map_index)), 1);
-              if (wgt > 0)
-                new_parts[ptcl] = part;
-            }
+            const Omega_h::Real cost = ptclCost(ptcl_costs, costs, ptcl, new_e);
+            const Omega_h::LO part = claimPlanWeight(sbar_to_index, map_index, part_ids,
+                                                     send_wgts, cost);
+            if (part >= 0)
+              new_parts[ptcl] = part;
           }
         }
       }
@@ -271,15 +521,11 @@ private:
         const Omega_h::LO sbar = sbars[new_e];
         if (sbar_to_index.exists(sbar)) {
           const auto map_index = sbar_to_index.find(sbar);
-          const Omega_h::LO index = sbar_to_index.value_at(map_index);
-          const Omega_h::LO part = part_ids[index];
-          const Omega_h::Real wgt = Kokkos::atomic_fetch_add(&(send_wgts[index]), -1);
-          if (part >= 0) {
-            if (wgt == 0)
-              Kokkos::atomic_add(&(sbar_to_index.value_at(map_index)), 1);
-            if (wgt > 0)
-              new_parts[ptcl] = part;
-          }
+          const Omega_h::Real cost = ptclCost(ptcl_costs, costs, ptcl, new_e);
+          const Omega_h::LO part = claimPlanWeight(sbar_to_index, map_index, part_ids,
+                                                   send_wgts, cost);
+          if (part >= 0)
+            new_parts[ptcl] = part;
         }
       }
     };
@@ -312,24 +558,66 @@ private:
     auto sbar_to_index = plan.sbar_to_index;
     auto part_ids = plan.part_ids;
     auto owners = picparts.entOwners(picparts->dim());
+    Omega_h::Reals costs = elem_costs;
+    if (selection_mode == SCAN_SELECTION) {
+      //Key elements by (plan index of the sbar, element) and rank their particles per sbar
+      const Omega_h::GO invalid = LLONG_MAX;
+      const Omega_h::LO nelems = ptcls_per_elem.size();
+      Omega_h::Write<Omega_h::GO> keys(nelems, invalid, "selection_keys");
+      auto setKeys = OMEGA_H_LAMBDA(const int elm) {
+        const Omega_h::LO sbar = sbars[elm];
+        if (ptcls_per_elem[elm] > 0 && sbar_to_index.exists(sbar)) {
+          const Omega_h::GO index = sbar_to_index.value_at(sbar_to_index.find(sbar));
+          keys[elm] = (index << 32) | elm;
+        }
+      };
+      Omega_h::parallel_for(nelems, setKeys, "setSelectionKeys");
+      Omega_h::GOs keys_r(keys);
+      Omega_h::LOs perm = Omega_h::sort_by_keys(keys_r);
+      Omega_h::LO ncandidates = 0;
+      Kokkos::parallel_reduce("countCandidates", nelems,
+                              KOKKOS_LAMBDA(const int i, Omega_h::LO& count) {
+        count += keys_r[i] != invalid;
+      }, ncandidates);
+
+      Omega_h::Write<Omega_h::LO> plan_index(ncandidates, "plan_index");
+      Omega_h::Write<Omega_h::Real> elem_wgts(ncandidates, "elem_wgts");
+      auto setPlanIndex = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+        const Omega_h::LO elm = perm[i];
+        plan_index[i] = keys_r[elm] >> 32;
+        elem_wgts[i] = (costs.size() > 0 ? costs[elm] : 1.0) * ptcls_per_elem[elm];
+      };
+      Omega_h::parallel_for(ncandidates, setPlanIndex, "setPlanIndex");
+      Omega_h::Reals ranks = segmentedRanks(Omega_h::LOs(plan_index), Omega_h::Reals(elem_wgts));
+      auto assignParts = OMEGA_H_LAMBDA(const Omega_h::LO i) {
+        const Omega_h::LO elm = perm[i];
+        const Omega_h::LO start_ptcl = offsets[elm];
+        const Omega_h::Real cost = costs.size() > 0 ? costs[elm] : 1.0;
+        for (Omega_h::LO j = 0; j < ptcls_per_elem[elm]; ++j) {
+          const Omega_h::LO part = planTarget(part_ids, send_wgts, plan_index[i],
+                                              ranks[i] + j * cost);
+          if (part < 0)
+            break;
+          new_procs[start_ptcl + j] = part;
+        }
+      };
+      Omega_h::parallel_for(ncandidates, assignParts, "assignParts");
+      return new_procs;
+    }
     for (int i = 0; i < selection_iterations; ++i) {
       auto selectParticles = OMEGA_H_LAMBDA(const int elm) {
         const Omega_h::LO sbar = sbars[elm];
         const Omega_h::LO start_ptcl = offsets[elm];
         if (sbar_to_index.exists(sbar)) {
           const auto map_index = sbar_to_index.find(sbar);
+          const Omega_h::Real cost = costs.size() > 0 ? costs[elm] : 1.0;
           for (Omega_h::LO i = 0; i < ptcls_per_elem[elm]; ++i) {
             const Omega_h::LO new_part = new_procs[start_ptcl+i];
             if (new_part == comm_rank) {
-              const Omega_h::LO index = sbar_to_index.value_at(map_index);
-              const Omega_h::LO part = part_ids[index];
-              const Omega_h::Real wgt = Kokkos::atomic_fetch_add(&(send_wgts[index]), -1);
-              if (part >= 0) {
-                if (wgt == 0)
-                  Kokkos::atomic_add(&(sbar_to_index.value_at(map_index)), 1);
-                if (wgt > 0)
-                  new_procs[start_ptcl+i] = part;
-              }
+              const Omega_h::LO part = claimPlanWeight(sbar_to_index, map_index, part_ids,
+                                                       send_wgts, cost);
+              if (part >= 0)
+                new_procs[start_ptcl+i] = part;
             }
           }
         }
@@ -361,6 +649,32 @@ private:
     selectParticles(picparts, ptcls, new_elems, plan, new_parts);
   }
 
+  template <class PS>
+  void ParticleBalancer::repartition(Mesh& picparts, PS* ptcls, double tol,
+                                     typename PS::kkLidView new_elems,
+                                     typename PS::kkLidView new_parts,
+                                     typename PS::template View<Omega_h::Real> ptcl_costs,
+                                     double step_factor) {
+    if (picparts.comm()->size() == 1)
+      return;
+    addWeights(picparts, ptcls, new_elems, new_parts, ptcl_costs);
+    ParticlePlan plan = balance(tol, step_factor);
+    selectParticles(picparts, ptcls, new_elems, plan, new_parts, ptcl_costs);
+  }
+
+  //Copies a numeric particle member into an array of particle costs for repartition
+  template <std::size_t N, class PS>
+  typename PS::template View<Omega_h::Real> ptclCostsFromMember(PS* ptcls) {
+    typename PS::template View<Omega_h::Real> ptcl_costs("ptcl_costs", ptcls->capacity());
+    auto member = ptcls->template get<N>();
+    auto copyCost = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+      if (mask)
+        ptcl_costs(ptcl) = member(ptcl);
+    };
+    parallel_for(ptcls, copyCost, "copyPtclCosts");
+    return ptcl_costs;
+  }
+
   template <class ViewT>
   Kokkos::View<lid_t*> ParticleBalancer::partition(Mesh& picparts, ViewT ptcls_per_elem, double tol, double step_factor, int selection_iterations) {
     if (picparts.comm()->size() == 1) {
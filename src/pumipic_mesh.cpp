@@ -1,5 +1,6 @@
 #include "pumipic_mesh.hpp"
 #include "pumipic_lb.hpp"
+#include <sys/mman.h>
 namespace pumipic {
   Mesh::Mesh() {
     picpart = NULL;
@@ -14,10 +15,17 @@ namespace pumipic {
     }
   }
   Mesh::~Mesh() {
-    if (!isFullMesh())
+    //The picpart is deleted before the windows backing its arrays are freed
+    if (!isFullMesh() || owns_full_mesh)
       delete picpart;
     if (ptcl_balancer)
       delete ptcl_balancer;
+    for (size_t i = 0; i < node_windows.size(); ++i)
+      MPI_Win_free(&(node_windows[i]));
+    if (node_comm != MPI_COMM_NULL)
+      MPI_Comm_free(&node_comm);
+    if (mapped_metadata)
+      munmap(mapped_metadata, mapped_size);
   }
 
   bool Mesh::isFullMesh() const {
@@ -1,5 +1,8 @@
 #pragma once
 #include <Omega_h_mesh.hpp>
+#include <mpi.h>
+#include <vector>
+#include <iosfwd>
 #include "pumipic_library.hpp"
 #include "pumipic_input.hpp"
 
@@ -22,10 +25,16 @@ namespace pumipic {
          int buffer_layers, int safe_layers);
     //Create picparts from input structure
     Mesh(Input&);
+    //Constructs PIC parts from a distributed mesh where each rank holds only its core
+    // The buffer is grown by exchanging ghost_layers of elements with neighboring parts
+    // All elements in the core and elements within safe_layers from the core are safe
+    Mesh(Omega_h::Mesh& dist_mesh, int ghost_layers, int safe_layers);
     ~Mesh();
 
     //Returns true if the full mesh is buffered
     bool isFullMesh() const;
+    //Returns true if the full mesh arrays are shared by the ranks of each node
+    bool isNodeShared() const {return !node_windows.empty();}
     //Calls function on the omega_h mesh
     Omega_h::Mesh* operator->() {return picpart;}
     //Returns a pointer to the underlying omega_h mesh
@@ -75,6 +84,17 @@ namespace pumipic {
     //Grab the particle load balancer
     ParticleBalancer* ptclBalancer() const {return ptcl_balancer;}
 
+    /* Rebuilds the picparts in place from a new ownership of the full mesh elements
+       full_mesh - the full mesh the picparts were built from
+       owners - the new owner of each full mesh element
+       buffer_layers/safe_layers - the layers of the new buffer and safe zone,
+           ignored when the full mesh is buffered
+       Note: the comm structures and the particle balancer are rebuilt and particle
+             structures on the old picparts are invalidated (see repartition_ptcls)
+     */
+    void repartition(Omega_h::Mesh& full_mesh, Omega_h::LOs owners,
+                     int buffer_layers, int safe_layers);
+
     //Users should not run the following functions.
     //They are meant to be private, but must be public for enclosing lambdas
     //Picpart construction
@@ -83,6 +103,13 @@ namespace pumipic {
                           Omega_h::Write<Omega_h::LO> has_part,
                           Omega_h::Write<Omega_h::LO> is_safe,
                           bool render = false);
+    //Picpart construction from a distributed mesh
+    void constructDistributedPICPart(Omega_h::Mesh& dist_mesh, int ghost_layers,
+                                     int safe_layers);
+
+    //Move the read-only arrays of a full mesh picpart into node shared memory and release
+    //  the input mesh on all but the first rank of each node
+    void shareFullMesh(Omega_h::Mesh& input);
 
     //Communication setup
     void setupComm(int dim, Omega_h::LOs global_ents_per_rank,
@@ -93,14 +120,39 @@ namespace pumipic {
     friend void write(Mesh& picparts, const char* prefix);
     friend void read(Omega_h::Library* library, Omega_h::CommPtr comm,
                      const char* prefix, Mesh* picparts);
+    friend void writeMappable(Mesh& picparts, const char* prefix);
+    friend void writeSingleFile(Mesh& picparts, const char* prefix);
+    friend void readSingleFile(Omega_h::Library* library, Omega_h::CommPtr comm,
+                               const char* prefix, Mesh* picparts, int stored_ranks);
 
   private:
+    //Serialization of the pumipic data that is not stored in the omega_h mesh
+    //  The read functions return the stored particle balancer sbars (empty if not stored)
+    void writeMetadata(std::ostream& stream);
+    Omega_h::HostWrite<Omega_h::LO> readMetadata(std::istream& stream);
+    //Uncompressed aligned layout of the pumipic data that is memory mapped on read
+    void writeMappableMetadata(std::ostream& stream);
+    Omega_h::HostWrite<Omega_h::LO> mapMetadata(const char* filename);
+    //Sets the communicator and creates the load balancer after a read
+    void finalizeRead(Omega_h::CommPtr comm, Omega_h::HostWrite<Omega_h::LO> sbar_data);
+
     Omega_h::CommPtr commptr;
     Omega_h::Mesh* picpart;
 
 
     //Flag if the mesh was built with full buffer
     bool is_full_mesh;
+    //Flag to share the full mesh arrays across the ranks of a node
+    bool share_full_mesh = false;
+    //The shared full mesh picpart is a copy of the input mesh owned by this mesh, so the
+    //  caller's mesh never holds views of the shared windows (see Input::shareFullMesh)
+    bool owns_full_mesh = false;
+    //Communicator of the ranks on this node and the shared windows backing the mesh arrays
+    MPI_Comm node_comm = MPI_COMM_NULL;
+    std::vector<MPI_Win> node_windows;
+    //Memory mapped file backing the pumipic data when read from the mappable layout
+    void* mapped_metadata = NULL;
+    size_t mapped_size = 0;
 
     //The global entity count of each dimension
     Omega_h::GO num_entites[4];
@@ -138,6 +190,16 @@ namespace pumipic {
     ParticleBalancer* ptcl_balancer = NULL;
   };
 
+  /* Computes a new owner of each full mesh element that balances the particle density
+     density - the accumulated particle load per picpart element (sized nelems)
+     elem_weight - (optional) the load of an element without particles
+     Elements are split by weighted recursive coordinate bisection of their centroids
+   */
+  Omega_h::LOs partitionByDensity(Mesh& picparts, Omega_h::Mesh& full_mesh,
+                                  Omega_h::Reals density, Omega_h::Real elem_weight = 1.0);
+  //Returns the full mesh element of each picpart element
+  Omega_h::LOs fullMeshElements(Mesh& picparts, Omega_h::Mesh& full_mesh);
+
   /* Save picparts and osh mesh to files
      Files are saved in directory: <prefix>_<num_ranks>.ppm/
        Omega_h mesh is saved to <prefix>_<num_ranks>/<prefix>_<rank>.osh
@@ -149,4 +211,24 @@ namespace pumipic {
    */
   void read(Omega_h::Library* library, Omega_h::CommPtr comm, const char* prefix,
             Mesh* picparts);
+
+  /* Save picparts and osh mesh to files in the same directory structure as write
+     The pumipic data is stored uncompressed with aligned arrays in native endianness
+       so read will memory map the file and use the arrays without copying
+   */
+  void writeMappable(Mesh& picparts, const char* prefix);
+
+  /* Save picparts and osh mesh of all ranks to a single file <prefix>_<num_ranks>.ppc
+     The file is written collectively with MPI-IO and starts with a header holding
+       the number of ranks and the byte offset of each rank's block
+   */
+  void writeSingleFile(Mesh& picparts, const char* prefix);
+  /* Reads picparts from a single file written by writeSingleFile using collective reads
+     stored_ranks - the number of ranks the file was written with (defaults to comm size)
+     When fewer ranks read the file than wrote it, each rank takes a contiguous range of
+       the stored parts and the picparts are rebuilt from the stored full mesh, so this
+       requires picparts buffering the full mesh
+   */
+  void readSingleFile(Omega_h::Library* library, Omega_h::CommPtr comm, const char* prefix,
+                      Mesh* picparts, int stored_ranks = -1);
 }
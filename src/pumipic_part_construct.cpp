@@ -8,6 +8,8 @@
 #include <Omega_h_scan.hpp>
 #include <Omega_h_file.hpp>
 #include "pumipic_lb.hpp"
+#include <utility>
+#include <sys/mman.h>
 
 namespace {
   void setOwnerByClassification(Omega_h::Mesh& m, Omega_h::LOs class_owners, int self,
@@ -37,6 +39,8 @@ namespace {
   void convertTag(Omega_h::Mesh full_mesh, Omega_h::Mesh* picpart, int dim,
                   Omega_h::LOs entToEnt, Omega_h::TagBase const* tag,
                   const char* new_name = "");
+  Omega_h::Mesh* buildPICPart(Omega_h::Mesh& mesh, int rank, Omega_h::GO* num_ents,
+                              Omega_h::LOs* ent_ids);
 }
 
 namespace pumipic {
@@ -109,10 +113,64 @@ namespace pumipic {
       is_full_mesh = true;
     else
       is_full_mesh = false;
+    share_full_mesh = in.shareFullMesh && is_full_mesh;
 
     constructPICPart(in.m, in.comm, owners, has_part, is_safe);
   }
 
+  Mesh::Mesh(Omega_h::Mesh& dist_mesh, int ghost_layers, int safe_layers) {
+    Omega_h::CommPtr comm = dist_mesh.comm();
+    if (ghost_layers < safe_layers) {
+      if (!comm->rank())
+        fprintf(stderr, "Ghost layers must be >= safe layers");
+      throw 1;
+    }
+    is_full_mesh = false;
+    constructDistributedPICPart(dist_mesh, ghost_layers, safe_layers);
+  }
+
+  void Mesh::repartition(Omega_h::Mesh& full_mesh, Omega_h::LOs owners,
+                         int buffer_layers, int safe_layers) {
+    Omega_h::CommPtr comm = commptr;
+    int comm_size = comm->size();
+    if (isNodeShared()) {
+      if (!comm->rank())
+        fprintf(stderr, "[ERROR] Repartitioning a node shared mesh is not supported\n");
+      throw 1;
+    }
+    if (owners.size() != full_mesh.nelems()) {
+      if (!comm->rank())
+        fprintf(stderr, "[ERROR] Owners must be sized by the full mesh elements\n");
+      throw 1;
+    }
+
+    Omega_h::Write<Omega_h::LO> is_safe(full_mesh.nelems(), isFullMesh(), "is_safe");
+    Omega_h::Write<Omega_h::LO> has_part(comm_size, isFullMesh(), "has_part");
+    if (!isFullMesh()) {
+      if (buffer_layers < safe_layers) {
+        if (!comm->rank())
+          fprintf(stderr, "Ghost layers must be >= safe layers");
+        throw 1;
+      }
+      int bridge_dim = 0;
+      bfsBufferLayers(full_mesh, bridge_dim, comm, safe_layers, buffer_layers, is_safe,
+                      owners, has_part);
+    }
+
+    //Release the structures of the old picpart before building the new one
+    Omega_h::Mesh* old_picpart = picpart;
+    delete ptcl_balancer;
+    ptcl_balancer = NULL;
+    constructPICPart(full_mesh, comm, owners, has_part, is_safe);
+    if (!isFullMesh() && old_picpart != &full_mesh)
+      delete old_picpart;
+    if (mapped_metadata) {
+      munmap(mapped_metadata, mapped_size);
+      mapped_metadata = NULL;
+      mapped_size = 0;
+    }
+  }
+
   void Mesh::constructPICPart(Omega_h::Mesh& mesh, Omega_h::CommPtr comm,
                               Omega_h::LOs owner, Omega_h::Write<Omega_h::LO> has_part,
                               Omega_h::Write<Omega_h::LO> is_safe, bool render) {
@@ -208,55 +266,16 @@ namespace pumipic {
           mesh.add_tag(i, "global_serial", 1, tag_array);
         }
       }
+      if (share_full_mesh) {
+        //Shallow copy, the shared arrays replace the copy's tags and adjacencies
+        picpart = new Omega_h::Mesh(mesh);
+        owns_full_mesh = true;
+        shareFullMesh(mesh);
+      }
     }
     //************Build a new mesh as the picpart**************
     else {
-      Omega_h::Library* lib = mesh.library();
-      picpart = new Omega_h::Mesh(lib);
-      picpart->set_comm(lib->self());
-      picpart->set_dim(dim);
-      picpart->set_family(OMEGA_H_SIMPLEX);
-      picpart->set_parting(OMEGA_H_ELEM_BASED);
-
-      //Gather coordinates
-      Omega_h::Write<Omega_h::Real> new_coords((num_ents[0])*dim,0);
-      gatherCoords(mesh, ent_ids[0], new_coords);
-
-      //Build the mesh
-      picpart->set_verts(num_ents[0]);
-      for (int i = 1; i <= dim; ++i)
-        buildAndClassify(mesh, *picpart, i, num_ents[i], ent_ids[i], ent_ids[0]);
-      classifyVerts(mesh, *picpart, num_ents[0], ent_ids[0]);
-      picpart->add_coords(new_coords);
-      Omega_h::finalize_classification(picpart);
-      if(!picpart->nelems()) {
-        fprintf(stderr,"%s: empty part on rank %d\n", __func__, rank);
-      }
-      assert(picpart->nelems());
-
-      /****************Convert all tags to picparts****************/
-      for (int i = 0; i <= dim; ++i) {
-        //Move tags from old mesh to new mesh
-        for (int j = 0; j < mesh.ntags(i); ++j) {
-          Omega_h::TagBase const* tagbase = mesh.get_tag(i,j);
-          // Ignore Omega_h internal tags
-          if (tagbase->name() == "coordinates" ||
-              tagbase->name() == "class_id" ||
-              tagbase->name() == "class_dim")
-            continue;
-          if (tagbase->name() == "global")
-            convertTag<Omega_h::I64>(mesh, picpart, i, ent_ids[i], tagbase,
-                                     "global_serial");
-          if (tagbase->type() == OMEGA_H_I8)
-            convertTag<Omega_h::I8>(mesh, picpart, i, ent_ids[i], tagbase);
-          if (tagbase->type() == OMEGA_H_I32)
-            convertTag<Omega_h::I32>(mesh, picpart, i, ent_ids[i], tagbase);
-          if (tagbase->type() == OMEGA_H_I64)
-            convertTag<Omega_h::I64>(mesh, picpart, i, ent_ids[i], tagbase);
-          if (tagbase->type() == OMEGA_H_F64)
-            convertTag<Omega_h::Real>(mesh, picpart, i, ent_ids[i], tagbase);
-        }
-      }
+      picpart = buildPICPart(mesh, rank, num_ents, ent_ids);
     }
 
     delete [] num_ents;
@@ -272,6 +291,114 @@ namespace pumipic {
     ptcl_balancer = new ParticleBalancer(*this);
 
   }
+  void Mesh::constructDistributedPICPart(Omega_h::Mesh& dist_mesh, int ghost_layers,
+                                         int safe_layers) {
+    Omega_h::CommPtr comm = dist_mesh.comm();
+    int rank = comm->rank();
+    int comm_size = comm->size();
+    int dim = dist_mesh.dim();
+
+    for (int i = 0; i < 4; ++i) {
+      num_cores[i] = 0;
+      num_bounds[i] = 0;
+      num_entites[i] = 0;
+      num_boundaries[i] = 0;
+      bounded_ent_ids[i] = Omega_h::LOs(0);
+      offset_ents_per_rank_per_dim[i] = Omega_h::LOs(0);
+      ent_to_comm_arr_index_per_dim[i] = Omega_h::LOs(0);
+      buffered_parts[i] = Omega_h::HostWrite<Omega_h::LO>(0);
+      boundary_parts[i] = Omega_h::HostWrite<Omega_h::LO>(0);
+      is_complete_part[i] = Omega_h::HostWrite<Omega_h::LO>(0);
+      offset_bounded_per_dim[i] = Omega_h::HostWrite<Omega_h::LO>(0);
+    }
+
+    //Shallow copy so the parting changes and tags below leave the caller's mesh untouched
+    Omega_h::Mesh mesh(dist_mesh);
+
+    //Each rank starts from its core region without ghosts
+    if (mesh.parting() != OMEGA_H_ELEM_BASED)
+      mesh.set_parting(OMEGA_H_ELEM_BASED);
+
+    /************* Globally Number the owned entities of each rank **********/
+    Omega_h::LOs rank_offset_nents[4];
+    for (int i = 0; i <= dim; ++i) {
+      Omega_h::Read<Omega_h::I8> owned = mesh.owned(i);
+      Omega_h::LO nents = mesh.nents(i);
+      Omega_h::Write<Omega_h::LO> is_owned(nents, "is_owned");
+      auto setOwned = OMEGA_H_LAMBDA(const Omega_h::LO& ent_id) {
+        is_owned[ent_id] = owned[ent_id];
+      };
+      Omega_h::parallel_for(nents, setOwned, "setOwned");
+      Omega_h::LOs owned_offset = Omega_h::offset_scan(Omega_h::LOs(is_owned));
+      Omega_h::LO num_owned = Omega_h::HostRead<Omega_h::LO>(owned_offset).last();
+
+      //Gather the owned counts of every rank to form the global offsets
+      Omega_h::HostWrite<Omega_h::LO> rank_counts(comm_size, "rank_counts");
+      MPI_Allgather(&num_owned, 1, MPI_INT, rank_counts.data(), 1, MPI_INT,
+                    comm->get_impl());
+      Omega_h::HostWrite<Omega_h::LO> rank_offsets(comm_size + 1, "rank_offsets");
+      rank_offsets[0] = 0;
+      for (int j = 0; j < comm_size; ++j)
+        rank_offsets[j+1] = rank_offsets[j] + rank_counts[j];
+      num_entites[i] = rank_offsets[comm_size];
+      rank_offset_nents[i] = Omega_h::LOs(Omega_h::Write<Omega_h::LO>(rank_offsets));
+
+      //Number owned entities then pull the owner's numbering to the shared copies
+      const Omega_h::GO self_offset = rank_offsets[rank];
+      Omega_h::Write<Omega_h::LO> rank_lids(nents, 0, "rank_lids");
+      Omega_h::Write<Omega_h::GO> gids(nents, 0, "global_ids");
+      auto numberOwned = OMEGA_H_LAMBDA(const Omega_h::LO& ent_id) {
+        if (is_owned[ent_id]) {
+          rank_lids[ent_id] = owned_offset[ent_id];
+          gids[ent_id] = self_offset + owned_offset[ent_id];
+        }
+      };
+      Omega_h::parallel_for(nents, numberOwned, "numberOwned");
+      mesh.add_tag(i, "ownership", 1, mesh.owners(i).ranks);
+      mesh.add_tag(i, "rank_lids", 1,
+                   mesh.sync_array(i, Omega_h::LOs(rank_lids), 1));
+      mesh.add_tag(i, "gids", 1, mesh.sync_array(i, Omega_h::GOs(gids), 1));
+    }
+
+    /************* Grow the buffer by exchanging layers with neighbors **********/
+    //Omega_h ghosting only pulls elements from neighboring parts and carries the tags
+    if (ghost_layers > 0)
+      mesh.set_parting(OMEGA_H_GHOSTED, ghost_layers, false);
+
+    /***************** Assemble the local picpart ****************/
+    Omega_h::GO num_ents[4];
+    Omega_h::LOs ent_ids[4];
+    for (int i = 0; i <= dim; ++i) {
+      num_ents[i] = mesh.nents(i);
+      ent_ids[i] = Omega_h::LOs(mesh.nents(i), 0, 1);
+    }
+    picpart = buildPICPart(mesh, rank, num_ents, ent_ids);
+    commptr = comm;
+
+    //Safe zone is computed locally since the buffer contains the safe layers
+    Omega_h::LOs elm_owners = entOwners(dim);
+    Omega_h::Write<Omega_h::LO> is_safe(picpart->nelems(), 0, "is_safe");
+    Omega_h::Write<Omega_h::LO> has_part(comm_size, 0, "has_part");
+    bfsBufferLayers(*picpart, 0, comm, safe_layers, 0, is_safe, elm_owners, has_part);
+    picpart->add_tag(dim, "safe", 1, Omega_h::LOs(is_safe));
+
+    /***************** Count the number of parts in the picpart ****************/
+    //Every part owning an element of the buffer is in the picpart
+    auto markParts = OMEGA_H_LAMBDA(const Omega_h::LO& elm_id) {
+      has_part[elm_owners[elm_id]] = 1;
+    };
+    Omega_h::parallel_for(picpart->nelems(), markParts, "markParts");
+    num_cores[dim] = sumPositives(has_part.size(),has_part) - 1;
+
+    //**************** Build communication information ********************//
+    for (int i = 0; i <= dim; ++i) {
+      Omega_h::LOs picpart_offset_nents = calculateOwnerOffset(entOwners(i), comm_size);
+      setupComm(i, rank_offset_nents[i], picpart_offset_nents, entOwners(i));
+    }
+
+    //Create load balancer
+    ptcl_balancer = new ParticleBalancer(*this);
+  }
 }
 
 namespace {
@@ -384,24 +511,53 @@ namespace {
     return ent_rank_lids;
   }
 
-  void BFS(int nents, Omega_h::Adj bridge2elems,Omega_h::LOs visited,
-           Omega_h::Write<Omega_h::LO> visited_next) {
-    auto meshBFS = OMEGA_H_LAMBDA(const Omega_h::LO bridge_id) {
-      const auto deg = bridge2elems.a2ab[bridge_id + 1] - bridge2elems.a2ab[bridge_id];
-      const auto firstElm = bridge2elems.a2ab[bridge_id];
-      bool is_visited_here = false;
-      for (int j = 0; j < deg; ++j) {
-        const auto elm = bridge2elems.ab2b[firstElm+j];
-        if (visited[elm])
-          is_visited_here = true;
-      }
-      const int loops = deg*is_visited_here;
-      for (int j = 0; j < loops; ++j) {
-        const auto elm = bridge2elems.ab2b[firstElm+j];
-        visited_next[elm] = true;
+  //Elements of the mesh that are part of the BFS frontier stored compactly
+  struct Frontier {
+    Omega_h::Write<Omega_h::LO> elms;
+    Omega_h::LO size;
+  };
+
+  //Compacts the marked elements into a frontier
+  Frontier initFrontier(Omega_h::LOs marked) {
+    Omega_h::LOs offset = Omega_h::offset_scan(marked);
+    Frontier front;
+    front.size = Omega_h::HostRead<Omega_h::LO>(offset).last();
+    front.elms = Omega_h::Write<Omega_h::LO>(marked.size(), "frontier");
+    auto elms = front.elms;
+    auto compactFrontier = OMEGA_H_LAMBDA(const Omega_h::LO elm_id) {
+      if (marked[elm_id])
+        elms[offset[elm_id]] = elm_id;
+    };
+    Omega_h::parallel_for(marked.size(), compactFrontier, "compactFrontier");
+    return front;
+  }
+
+  //Visits the unvisited elements that share a bridge entity with an element of the frontier
+  //  Only the newly visited elements are written to next so each layer is proportional
+  //  to the size of the frontier rather than the size of the mesh
+  void BFS(Omega_h::Adj elm2bridges, int deg, Omega_h::Adj bridge2elems,
+           const Frontier& front, Omega_h::Write<Omega_h::LO> visited, Frontier& next) {
+    Omega_h::Write<Omega_h::LO> next_size(1, 0, "next_size");
+    auto front_elms = front.elms;
+    auto next_elms = next.elms;
+    auto meshBFS = OMEGA_H_LAMBDA(const Omega_h::LO index) {
+      const Omega_h::LO elm = front_elms[index];
+      for (int i = 0; i < deg; ++i) {
+        const auto bridge_id = elm2bridges.ab2b[elm * deg + i];
+        const auto firstElm = bridge2elems.a2ab[bridge_id];
+        const auto lastElm = bridge2elems.a2ab[bridge_id + 1];
+        for (auto j = firstElm; j < lastElm; ++j) {
+          const auto adj_elm = bridge2elems.ab2b[j];
+          if (!visited[adj_elm] &&
+              Kokkos::atomic_compare_exchange(&(visited[adj_elm]), 0, 1) == 0) {
+            const Omega_h::LO slot = Kokkos::atomic_fetch_add(&(next_size[0]), 1);
+            next_elms[slot] = adj_elm;
+          }
+        }
       }
     };
-    Omega_h::parallel_for(nents, meshBFS,"meshBFS");
+    Omega_h::parallel_for(front.size, meshBFS, "meshBFS");
+    next.size = Omega_h::HostRead<Omega_h::LO>(next_size)[0];
   }
 
   void bfsBufferLayers(Omega_h::Mesh& mesh, int bridge_dim, Omega_h::CommPtr comm,
@@ -410,10 +566,8 @@ namespace {
                        Omega_h::LOs owner, Omega_h::Write<Omega_h::LO> has_part) {
     int rank = comm->rank();
     Omega_h::Write<Omega_h::LO> is_visited(mesh.nelems());
-    Omega_h::Write<Omega_h::LO> is_visited_next(mesh.nelems());
     const auto initVisit = OMEGA_H_LAMBDA( Omega_h::LO elem_id){
       is_visited[elem_id] = is_safe[elem_id] = (owner[elem_id] == rank);
-      is_visited_next[elem_id] = is_visited[elem_id];
     };
     Omega_h::parallel_for(mesh.nelems(), initVisit, "initVisit");
     auto initSelfPart = OMEGA_H_LAMBDA(Omega_h::LO) {
@@ -421,18 +575,29 @@ namespace {
     };
     Omega_h::parallel_for(1, initSelfPart);
 
-    const auto bridge2elems = mesh.ask_up(bridge_dim, mesh.dim());
-    for (int i = 0; i < ghost_layers || i < safe_layers; ++i) {
-      BFS(mesh.nents(bridge_dim), bridge2elems, Omega_h::LOs(is_visited), is_visited_next);
-      auto copyVisit = OMEGA_H_LAMBDA( Omega_h::LO elm_id) {
-        is_visited[elm_id] = is_visited_next[elm_id];
-        if (i == safe_layers - 1)
-          is_safe[elm_id] = is_visited_next[elm_id];
-        if (i < ghost_layers)
-          if (is_visited[elm_id])
-            has_part[owner[elm_id]] = 1;
+    const int dim = mesh.dim();
+    const auto elm2bridges = mesh.ask_down(dim, bridge_dim);
+    const auto deg = Omega_h::element_degree(mesh.family(), dim, bridge_dim);
+    const auto bridge2elems = mesh.ask_up(bridge_dim, dim);
+    Frontier front = initFrontier(Omega_h::LOs(is_visited));
+    Frontier next;
+    next.elms = Omega_h::Write<Omega_h::LO>(mesh.nelems(), "frontier_next");
+    next.size = 0;
+    for (int i = 0; (i < ghost_layers || i < safe_layers) && front.size > 0; ++i) {
+      BFS(elm2bridges, deg, bridge2elems, front, is_visited, next);
+      //Earlier layers have already been marked, so only the new layer is updated
+      const bool mark_safe = i < safe_layers;
+      const bool mark_part = i < ghost_layers;
+      auto next_elms = next.elms;
+      auto markLayer = OMEGA_H_LAMBDA(const Omega_h::LO index) {
+        const Omega_h::LO elm_id = next_elms[index];
+        if (mark_safe)
+          is_safe[elm_id] = 1;
+        if (mark_part)
+          has_part[owner[elm_id]] = 1;
       };
-      Omega_h::parallel_for(mesh.nelems(), copyVisit, "copyVisit");
+      Omega_h::parallel_for(next.size, markLayer, "markLayer");
+      std::swap(front, next);
     }
   }
 
@@ -440,20 +605,23 @@ namespace {
                      int safe_layers, Omega_h::LOs owner, Omega_h::LOs has_part,
                      Omega_h::Write<Omega_h::LO> safe) {
     Omega_h::Write<Omega_h::LO> is_visited(mesh.nelems(), 0);
-    Omega_h::Write<Omega_h::LO> is_visited_next(mesh.nelems(), 0);
     const auto initVisit = OMEGA_H_LAMBDA( Omega_h::LO elem_id) {
       const Omega_h::LO own = owner[elem_id];
-      is_visited[elem_id] = is_visited_next[elem_id] = !has_part[own];
+      is_visited[elem_id] = !has_part[own];
     };
     Omega_h::parallel_for(mesh.nelems(), initVisit, "initVisit");
 
-    const auto bridge2elems = mesh.ask_up(bridge_dim, mesh.dim());
-    for (int i = 0; i < safe_layers; ++i) {
-      BFS(mesh.nents(bridge_dim), bridge2elems, Omega_h::LOs(is_visited), is_visited_next);
-      auto copyVisit = OMEGA_H_LAMBDA(Omega_h::LO elm_id) {
-        is_visited[elm_id] = is_visited_next[elm_id];
-      };
-      Omega_h::parallel_for(mesh.nelems(), copyVisit, "copyVisit");
+    const int dim = mesh.dim();
+    const auto elm2bridges = mesh.ask_down(dim, bridge_dim);
+    const auto deg = Omega_h::element_degree(mesh.family(), dim, bridge_dim);
+    const auto bridge2elems = mesh.ask_up(bridge_dim, dim);
+    Frontier front = initFrontier(Omega_h::LOs(is_visited));
+    Frontier next;
+    next.elms = Omega_h::Write<Omega_h::LO>(mesh.nelems(), "frontier_next");
+    next.size = 0;
+    for (int i = 0; i < safe_layers && front.size > 0; ++i) {
+      BFS(elm2bridges, deg, bridge2elems, front, is_visited, next);
+      std::swap(front, next);
     }
     int rank = comm->rank();
     auto setSafe = OMEGA_H_LAMBDA(Omega_h::LO elm_id) {
@@ -614,4 +782,56 @@ namespace {
     else
       picpart->add_tag(dim, new_name, nvalues, Omega_h::Read<T>(new_tag));
   }
+
+  Omega_h::Mesh* buildPICPart(Omega_h::Mesh& mesh, int rank, Omega_h::GO* num_ents,
+                              Omega_h::LOs* ent_ids) {
+    int dim = mesh.dim();
+    Omega_h::Library* lib = mesh.library();
+    Omega_h::Mesh* picpart = new Omega_h::Mesh(lib);
+    picpart->set_comm(lib->self());
+    picpart->set_dim(dim);
+    picpart->set_family(OMEGA_H_SIMPLEX);
+    picpart->set_parting(OMEGA_H_ELEM_BASED);
+
+    //Gather coordinates
+    Omega_h::Write<Omega_h::Real> new_coords((num_ents[0])*dim,0);
+    gatherCoords(mesh, ent_ids[0], new_coords);
+
+    //Build the mesh
+    picpart->set_verts(num_ents[0]);
+    for (int i = 1; i <= dim; ++i)
+      buildAndClassify(mesh, *picpart, i, num_ents[i], ent_ids[i], ent_ids[0]);
+    classifyVerts(mesh, *picpart, num_ents[0], ent_ids[0]);
+    picpart->add_coords(new_coords);
+    Omega_h::finalize_classification(picpart);
+    if(!picpart->nelems()) {
+      fprintf(stderr,"%s: empty part on rank %d\n", __func__, rank);
+    }
+    assert(picpart->nelems());
+
+    /****************Convert all tags to picparts****************/
+    for (int i = 0; i <= dim; ++i) {
+      //Move tags from old mesh to new mesh
+      for (int j = 0; j < mesh.ntags(i); ++j) {
+        Omega_h::TagBase const* tagbase = mesh.get_tag(i,j);
+        // Ignore Omega_h internal tags
+        if (tagbase->name() == "coordinates" ||
+            tagbase->name() == "class_id" ||
+            tagbase->name() == "class_dim")
+          continue;
+        if (tagbase->name() == "global")
+          convertTag<Omega_h::I64>(mesh, picpart, i, ent_ids[i], tagbase,
+                                   "global_serial");
+        if (tagbase->type() == OMEGA_H_I8)
+          convertTag<Omega_h::I8>(mesh, picpart, i, ent_ids[i], tagbase);
+        if (tagbase->type() == OMEGA_H_I32)
+          convertTag<Omega_h::I32>(mesh, picpart, i, ent_ids[i], tagbase);
+        if (tagbase->type() == OMEGA_H_I64)
+          convertTag<Omega_h::I64>(mesh, picpart, i, ent_ids[i], tagbase);
+        if (tagbase->type() == OMEGA_H_F64)
+          convertTag<Omega_h::Real>(mesh, picpart, i, ent_ids[i], tagbase);
+      }
+    }
+    return picpart;
+  }
 }
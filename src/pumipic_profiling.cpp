@@ -1,5 +1,7 @@
 #include "pumipic_profiling.hpp"
 #include <mpi.h>
+#include <ppImbalance.hpp>
+#include <ppTrace.hpp>
 namespace {
   static bool pumipic_prebarrier_enabled = false;
 }
@@ -9,11 +11,13 @@ void pumipic_enable_prebarrier() {
 }
 
 double pumipic_prebarrier() {
-  if(pumipic_prebarrier_enabled) {
+  if(pumipic_prebarrier_enabled && pumipic::isPrebarrierStep()) {
+    pumipic::ScopedTrace trace("prebarrier", pumipic::TRACE_MPI);
     Kokkos::Timer timer;
     MPI_Barrier(MPI_COMM_WORLD);
     return timer.seconds();
   } else {
-    return 0.0;
+    //No sample this step, a measured wait is never negative
+    return -1.0;
   }
 }
@@ -3,6 +3,7 @@
 #include "pumipic_mesh.hpp"
 #include <particle_structs.hpp>
 #include "pumipic_lb.hpp"
+#include <vector>
 
 namespace pumipic {
   /* High level particle-mesh migration & rebuild operations */
@@ -18,6 +19,17 @@ namespace pumipic {
   void migrate_lb_ptcls(Mesh& mesh, PS* ptcls, Omega_h::LOs new_elems,
                   float tol, float step_factor = 0.5);
 
+  /* Migrate/rebuild particle structure, load balancing only when the policy requests it
+     mesh - picpart mesh
+     ptcls - particle structure
+     new_elems - new assignment of mesh elements for each particle
+     policy - decides when to balance and the target imbalance
+     step_factor - (optional) The rate of diffusion for load balancer
+  */
+  template <class PS>
+  void migrate_lb_ptcls(Mesh& mesh, PS* ptcls, Omega_h::LOs new_elems,
+                        BalancePolicy& policy, float step_factor = 0.5);
+
   /* Migrate/rebuild particle structure
      mesh - picpart mesh
      ptcls - particle structure
@@ -29,6 +41,28 @@ namespace pumipic {
   void migrate_ptcls(Mesh& mesh, PS* ptcls, Omega_h::LOs new_elems);
 
 
+  /* Adds the number of particles in each element to density
+     density - particle load per picpart element, accumulated across calls
+  */
+  template <class PS>
+  void accumulate_ptcl_density(PS* ptcls, Omega_h::Write<Omega_h::Real> density);
+
+  /* Repartition the picparts from the particle density and move particles to their new owners
+     mesh - picpart mesh, rebuilt in place
+     full_mesh - the full mesh the picparts were built from
+     ptcls - particle structure, deleted and replaced by the structure create returns
+     density - accumulated particle load per picpart element (see accumulate_ptcl_density)
+     buffer_layers/safe_layers - the layers of the new picparts (ignored for full mesh picparts)
+     create - functor building the new structure on the new picparts with the signature
+         PS* (lid_t nelems, lid_t nptcls, kkLidView ptcls_per_elem, kkGidView element_gids,
+              kkLidView particle_elements, MTVs particle_info)
+     Returns the new particle structure
+  */
+  template <class PS, class CreateFn>
+  PS* repartition_ptcls(Mesh& mesh, Omega_h::Mesh& full_mesh, PS* ptcls,
+                        Omega_h::Reals density, int buffer_layers, int safe_layers,
+                        CreateFn create);
+
   template <class PS>
   void setUnsafeProcs(Mesh& mesh, PS* ptcls, Omega_h::LOs elems,
                       typename PS::kkLidView new_elems, typename PS::kkLidView new_procs) {
@@ -70,6 +104,160 @@ namespace pumipic {
     RecordTime("migration", migrate_time);
   }
 
+  template <class PS>
+  void migrate_lb_ptcls(Mesh& mesh, PS* ptcls, Omega_h::LOs elems,
+                        BalancePolicy& policy, float step_factor) {
+    Kokkos::Timer init_timer;
+    typename PS::kkLidView new_elems("ps_element_ids", ptcls->capacity());
+    typename PS::kkLidView new_procs("ps_process_ids", ptcls->capacity());
+    setUnsafeProcs(mesh, ptcls, elems, new_elems, new_procs);
+    float init_time = init_timer.seconds();
+    Kokkos::Timer balance_timer;
+    if (policy.shouldBalance(mesh.comm()->get_impl(), ptcls->nPtcls())) {
+      ParticleBalancer* balancer = mesh.ptclBalancer();
+      balancer->repartition(mesh, ptcls, policy.targetTol(), new_elems, new_procs,
+                            step_factor);
+    }
+    float balance_time = balance_timer.seconds();
+    Kokkos::Timer migrate_timer;
+    const int nptcls_before = ptcls->nPtcls();
+    ptcls->migrate(new_elems, new_procs);
+    policy.recordMigration(nptcls_before, ptcls->nPtcls());
+    float migrate_time = migrate_timer.seconds();
+    RecordTime("migration_init", init_time);
+    RecordTime("migration_balance", balance_time);
+    RecordTime("migration", migrate_time);
+  }
+
+  template <class PS>
+  void accumulate_ptcl_density(PS* ptcls, Omega_h::Write<Omega_h::Real> density) {
+    auto countPtcls = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+      if (mask)
+        Kokkos::atomic_add(&(density[elm]), 1.0);
+    };
+    parallel_for(ptcls, countPtcls, "accumulatePtclDensity");
+  }
+
+  template <class PS, class CreateFn>
+  PS* repartition_ptcls(Mesh& mesh, Omega_h::Mesh& full_mesh, PS* ptcls,
+                        Omega_h::Reals density, int buffer_layers, int safe_layers,
+                        CreateFn create) {
+    typedef typename PS::Types DataTypes;
+    typedef typename PS::device_type device_type;
+    typedef typename PS::memory_space memory_space;
+    typedef typename PS::kkLidView kkLidView;
+    typedef typename PS::kkGidView kkGidView;
+    typedef typename PS::MTVs MTVs;
+    Kokkos::Timer repartition_timer;
+    const int comm_size = mesh.comm()->size();
+    MPI_Comm comm = mesh.comm()->get_impl();
+    const int dim = mesh.dim();
+
+    //The full mesh element of each particle on the old picparts
+    Omega_h::LOs full_elems = fullMeshElements(mesh, full_mesh);
+    kkLidView ptcl_full_elems("ptcl_full_elems", ptcls->capacity());
+    auto setFullElems = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+      ptcl_full_elems(ptcl) = mask ? full_elems[elm] : -1;
+    };
+    parallel_for(ptcls, setFullElems, "setFullElems");
+
+    Omega_h::LOs owners = partitionByDensity(mesh, full_mesh, density);
+    mesh.repartition(full_mesh, owners, buffer_layers, safe_layers);
+    float mesh_time = repartition_timer.seconds();
+
+    //Every particle is sent to the owner of its element with the element's new global id
+    Omega_h::GOs new_gids = full_mesh.get_array<Omega_h::GO>(dim, "gids");
+    kkLidView num_send("num_send", comm_size + 1);
+    kkLidView send_index("send_index", ptcls->capacity());
+    auto countSends = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+      send_index(ptcl) = -1;
+      if (mask) {
+        const int owner = owners[ptcl_full_elems(ptcl)];
+        send_index(ptcl) = Kokkos::atomic_fetch_add(&(num_send(owner)), 1);
+      }
+    };
+    parallel_for(ptcls, countSends, "countSends");
+    kkLidView send_offsets("send_offsets", comm_size + 1);
+    exclusive_scan(num_send, send_offsets, typename PS::execution_space());
+    const lid_t np_send = getLastValue(send_offsets);
+    kkGidView send_elems("send_elems", np_send);
+    auto setSendElems = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+      if (mask) {
+        const int full_elm = ptcl_full_elems(ptcl);
+        send_index(ptcl) += send_offsets(owners[full_elm]);
+        send_elems(send_index(ptcl)) = new_gids[full_elm];
+      }
+    };
+    parallel_for(ptcls, setSendElems, "setSendElems");
+    MTVs send_data;
+    CreateViews<device_type, DataTypes>(send_data, np_send);
+    GatherParticles<PS, DataTypes>(ptcls, send_data, send_index);
+    delete ptcls;
+
+    //Exchange the particle counts and then the particles
+    auto num_send_h = deviceToHost(num_send);
+    auto send_offsets_h = deviceToHost(send_offsets);
+    std::vector<int> num_recv_h(comm_size);
+    MPI_Alltoall(num_send_h.data(), 1, MPI_INT, num_recv_h.data(), 1, MPI_INT, comm);
+    std::vector<lid_t> recv_offsets_h(comm_size + 1, 0);
+    for (int i = 0; i < comm_size; ++i)
+      recv_offsets_h[i + 1] = recv_offsets_h[i] + num_recv_h[i];
+    const lid_t np_recv = recv_offsets_h[comm_size];
+    kkGidView recv_elems("recv_elems", np_recv);
+    MTVs recv_data;
+    CreateViews<device_type, DataTypes>(recv_data, np_recv);
+    const int num_types = DataTypes::size;
+    std::vector<MPI_Request> send_requests, recv_requests;
+    for (int i = 0; i < comm_size; ++i) {
+      const lid_t num_send_i = num_send_h(i);
+      if (num_send_i > 0) {
+        const size_t req = send_requests.size();
+        send_requests.resize(req + num_types + 1);
+        PS_Comm_Isend(send_elems, send_offsets_h(i), num_send_i, i, 0, comm,
+                      &(send_requests[req]));
+        SendViews<device_type, DataTypes>(send_data, send_offsets_h(i), num_send_i, i, 1,
+                                          comm, &(send_requests[req + 1]));
+      }
+      const lid_t num_recv_i = num_recv_h[i];
+      if (num_recv_i > 0) {
+        const size_t req = recv_requests.size();
+        recv_requests.resize(req + num_types + 1);
+        PS_Comm_Irecv(recv_elems, recv_offsets_h[i], num_recv_i, i, 0, comm,
+                      &(recv_requests[req]));
+        RecvViews<device_type, DataTypes>(recv_data, recv_offsets_h[i], num_recv_i, i, 1,
+                                          comm, &(recv_requests[req + 1]));
+      }
+    }
+    PS_Comm_Waitall<device_type>(recv_requests.size(), recv_requests.data(),
+                                 MPI_STATUSES_IGNORE);
+    PS_Comm_Waitall<device_type>(send_requests.size(), send_requests.data(),
+                                 MPI_STATUSES_IGNORE);
+    destroyViews<DataTypes, memory_space>(send_data);
+
+    //Convert the received global ids to elements of the new picpart
+    const lid_t nelems = mesh.nelems();
+    Omega_h::GOs pic_gids = mesh.globalIds(dim);
+    kkGidView element_gids("element_gids", nelems);
+    Kokkos::UnorderedMap<gid_t, lid_t, device_type> gid_to_lid(nelems);
+    Kokkos::parallel_for(nelems, KOKKOS_LAMBDA(const lid_t elm) {
+      element_gids(elm) = pic_gids[elm];
+      gid_to_lid.insert(pic_gids[elm], elm);
+    });
+    kkLidView ptcl_elems("ptcl_elems", np_recv);
+    kkLidView ptcls_per_elem("ptcls_per_elem", nelems);
+    Kokkos::parallel_for(np_recv, KOKKOS_LAMBDA(const lid_t i) {
+      const lid_t elm = gid_to_lid.value_at(gid_to_lid.find(recv_elems(i)));
+      ptcl_elems(i) = elm;
+      Kokkos::atomic_add(&(ptcls_per_elem(elm)), 1);
+    });
+    PS* new_ptcls = create(nelems, np_recv, ptcls_per_elem, element_gids, ptcl_elems,
+                           recv_data);
+    destroyViews<DataTypes, memory_space>(recv_data);
+    RecordTime("repartition_mesh", mesh_time);
+    RecordTime("repartition_ptcls", repartition_timer.seconds() - mesh_time);
+    return new_ptcls;
+  }
+
   template <class PS>
   void migrate_ptcls(Mesh& mesh, PS* ptcls, Omega_h::LOs elems) {
     Kokkos::Timer init_timer;
@@ -0,0 +1,129 @@
+#include "pumipic_mesh.hpp"
+#include <Omega_h_for.hpp>
+#include <Omega_h_element.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace {
+  typedef Omega_h::LO LO;
+  typedef Omega_h::Real Real;
+
+  //Splits elems[begin, end) along the longest axis of their centroids so each half
+  //  holds the share of the weight of its parts, then recurses on both halves
+  void bisect(Omega_h::HostRead<Real>& centroids, int dim,
+              Omega_h::HostWrite<Real>& weights, std::vector<LO>& elems,
+              size_t begin, size_t end, int first_part, int nparts,
+              Omega_h::HostWrite<LO>& owners) {
+    if (nparts == 1 || end - begin < 2) {
+      for (size_t i = begin; i < end; ++i)
+        owners[elems[i]] = first_part;
+      return;
+    }
+    int axis = 0;
+    Real max_extent = -1;
+    for (int d = 0; d < dim; ++d) {
+      Real lo = centroids[elems[begin] * dim + d];
+      Real hi = lo;
+      for (size_t i = begin; i < end; ++i) {
+        lo = std::min(lo, centroids[elems[i] * dim + d]);
+        hi = std::max(hi, centroids[elems[i] * dim + d]);
+      }
+      if (hi - lo > max_extent) {
+        max_extent = hi - lo;
+        axis = d;
+      }
+    }
+    //Ties are broken by element id so every process computes the same partition
+    std::sort(elems.begin() + begin, elems.begin() + end, [&](LO a, LO b) {
+      const Real ca = centroids[a * dim + axis];
+      const Real cb = centroids[b * dim + axis];
+      return ca < cb || (ca == cb && a < b);
+    });
+    Real total = 0;
+    for (size_t i = begin; i < end; ++i)
+      total += weights[elems[i]];
+    const int left_parts = nparts / 2;
+    const Real target = total * left_parts / nparts;
+    size_t split = begin;
+    Real sum = 0;
+    while (split < end && sum + weights[elems[split]] / 2 < target)
+      sum += weights[elems[split++]];
+    bisect(centroids, dim, weights, elems, begin, split, first_part, left_parts, owners);
+    bisect(centroids, dim, weights, elems, split, end, first_part + left_parts,
+           nparts - left_parts, owners);
+  }
+}
+
+namespace pumipic {
+  Omega_h::LOs fullMeshElements(Mesh& picparts, Omega_h::Mesh& full_mesh) {
+    const int dim = full_mesh.dim();
+    if (!full_mesh.has_tag(dim, "gids")) {
+      fprintf(stderr, "[ERROR] The full mesh was not used to build the picparts\n");
+      throw 1;
+    }
+    Omega_h::GOs full_gids = full_mesh.get_array<Omega_h::GO>(dim, "gids");
+    Omega_h::Write<LO> gid_to_full(full_mesh.nelems(), -1, "gid_to_full");
+    auto invertGids = OMEGA_H_LAMBDA(const LO elm) {
+      gid_to_full[full_gids[elm]] = elm;
+    };
+    Omega_h::parallel_for(full_mesh.nelems(), invertGids, "invertGids");
+    Omega_h::GOs gids = picparts.globalIds(dim);
+    Omega_h::Write<LO> full_elems(picparts.nelems(), "full_elems");
+    auto setFullElems = OMEGA_H_LAMBDA(const LO elm) {
+      full_elems[elm] = gid_to_full[gids[elm]];
+    };
+    Omega_h::parallel_for(picparts.nelems(), setFullElems, "setFullElems");
+    return full_elems;
+  }
+
+  Omega_h::LOs partitionByDensity(Mesh& picparts, Omega_h::Mesh& full_mesh,
+                                  Omega_h::Reals density, Real elem_weight) {
+    const int dim = full_mesh.dim();
+    const LO nelems = full_mesh.nelems();
+    Omega_h::CommPtr comm = picparts.comm();
+    if (density.size() != picparts.nelems()) {
+      if (!comm->rank())
+        fprintf(stderr, "[ERROR] Density must be sized by the picpart elements\n");
+      throw 1;
+    }
+
+    //Sum the density of every process onto the full mesh elements
+    Omega_h::LOs full_elems = fullMeshElements(picparts, full_mesh);
+    Omega_h::Write<Real> full_density(nelems, 0, "full_density");
+    auto accumulateDensity = OMEGA_H_LAMBDA(const LO elm) {
+      Kokkos::atomic_add(&(full_density[full_elems[elm]]), density[elm]);
+    };
+    Omega_h::parallel_for(picparts.nelems(), accumulateDensity, "accumulateDensity");
+    Omega_h::HostWrite<Real> weights_h(full_density);
+    MPI_Allreduce(MPI_IN_PLACE, weights_h.data(), nelems, MPI_DOUBLE, MPI_SUM,
+                  comm->get_impl());
+    for (LO i = 0; i < nelems; ++i)
+      weights_h[i] += elem_weight;
+
+    //Element centroids
+    Omega_h::Reals coords = full_mesh.coords();
+    Omega_h::LOs elem_verts = full_mesh.ask_elem_verts();
+    const int nverts = Omega_h::simplex_degree(dim, 0);
+    Omega_h::Write<Real> centroids(nelems * dim, "centroids");
+    auto computeCentroids = OMEGA_H_LAMBDA(const LO elm) {
+      for (int d = 0; d < dim; ++d) {
+        Real sum = 0;
+        for (int v = 0; v < nverts; ++v)
+          sum += coords[elem_verts[elm * nverts + v] * dim + d];
+        centroids[elm * dim + d] = sum / nverts;
+      }
+    };
+    Omega_h::parallel_for(nelems, computeCentroids, "computeCentroids");
+
+    //Every process holds the full mesh and the summed weights so the bisection is
+    //  computed redundantly instead of communicated
+    Omega_h::Reals centroids_r(centroids);
+    Omega_h::HostRead<Real> centroids_h(centroids_r);
+    std::vector<LO> elems(nelems);
+    for (LO i = 0; i < nelems; ++i)
+      elems[i] = i;
+    Omega_h::HostWrite<LO> owners(nelems, "owners");
+    bisect(centroids_h, dim, weights_h, elems, 0, nelems, 0, comm->size(), owners);
+    return Omega_h::LOs(Omega_h::Write<LO>(owners));
+  }
+}
@@ -0,0 +1,118 @@
+#include "pumipic_mesh.hpp"
+#include <Omega_h_tag.hpp>
+#include <cstring>
+
+namespace {
+  //Copies the array into a window allocated once per node and returns a view of it
+  template <class T>
+  Omega_h::Read<T> toNodeShared(MPI_Comm node_comm, Omega_h::Read<T> array,
+                                std::vector<MPI_Win>& windows) {
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+    const Omega_h::LO size = array.size();
+    MPI_Aint bytes = (node_rank == 0) ? size * sizeof(T) : 0;
+    T* base = NULL;
+    MPI_Win win;
+    MPI_Win_allocate_shared(bytes, sizeof(T), MPI_INFO_NULL, node_comm, &base, &win);
+    if (node_rank == 0) {
+      Omega_h::HostRead<T> array_h(array);
+      if (size > 0)
+        memcpy(base, array_h.data(), size * sizeof(T));
+    }
+    else {
+      MPI_Aint shared_bytes;
+      int disp_unit;
+      MPI_Win_shared_query(win, 0, &shared_bytes, &disp_unit, &base);
+    }
+    //Complete the copy before any rank on the node reads the array
+    MPI_Win_fence(0, win);
+    windows.push_back(win);
+
+    //Unmanaged view so the mesh does not attempt to free the shared memory
+    Kokkos::View<T*, Kokkos::MemoryTraits<Kokkos::Unmanaged> > shared(base, size);
+    Kokkos::View<T*> view = shared;
+    return Omega_h::Read<T>(Omega_h::Write<T>(view));
+  }
+
+  template <class T>
+  void shareTag(Omega_h::Mesh* mesh, MPI_Comm node_comm, int dim, std::string name,
+                std::vector<MPI_Win>& windows) {
+    Omega_h::Read<T> array = mesh->get_array<T>(dim, name);
+    mesh->set_tag(dim, name, toNodeShared(node_comm, array, windows));
+  }
+
+  //Replaces the adjacency from -> to of the mesh with a copy in node shared memory
+  void shareAdj(Omega_h::Mesh* mesh, MPI_Comm node_comm, int from, int to,
+                Omega_h::Adj adj, std::vector<MPI_Win>& windows) {
+    Omega_h::Adj shared;
+    if (adj.a2ab.exists())
+      shared.a2ab = toNodeShared(node_comm, adj.a2ab, windows);
+    shared.ab2b = toNodeShared(node_comm, adj.ab2b, windows);
+    if (adj.codes.exists())
+      shared.codes = toNodeShared(node_comm, adj.codes, windows);
+    mesh->add_adj(from, to, shared);
+  }
+}
+
+namespace pumipic {
+  void Mesh::shareFullMesh(Omega_h::Mesh& input) {
+    typedef Kokkos::DefaultExecutionSpace::memory_space MemSpace;
+    const bool host_accessible =
+      Kokkos::SpaceAccessibility<Kokkos::HostSpace, MemSpace>::accessible;
+    if (!host_accessible) {
+      if (!commptr->rank())
+        fprintf(stderr, "[WARNING] Node shared full mesh requires host accessible memory, "
+                "keeping a copy of the mesh per rank\n");
+      return;
+    }
+
+    MPI_Comm_split_type(commptr->get_impl(), MPI_COMM_TYPE_SHARED, commptr->rank(),
+                        MPI_INFO_NULL, &node_comm);
+
+    //Only arrays that are identical on every rank are shared, per picpart tags like "safe"
+    //  stay in each rank's memory. Every rank checks the same tags in the same order since
+    //  allocating a window is collective over the node.
+    const char* shared_tags[] = {"coordinates", "global", "global_serial", "class_id",
+                                 "class_dim", "ownership", "gids", "rank_lids"};
+    const int num_shared_tags = sizeof(shared_tags) / sizeof(shared_tags[0]);
+    for (int i = 0; i <= picpart->dim(); ++i) {
+      for (int j = 0; j < num_shared_tags; ++j) {
+        if (!picpart->has_tag(i, shared_tags[j]))
+          continue;
+        const Omega_h_Type type = picpart->get_tagbase(i, shared_tags[j])->type();
+        if (type == OMEGA_H_I8)
+          shareTag<Omega_h::I8>(picpart, node_comm, i, shared_tags[j], node_windows);
+        else if (type == OMEGA_H_I32)
+          shareTag<Omega_h::I32>(picpart, node_comm, i, shared_tags[j], node_windows);
+        else if (type == OMEGA_H_I64)
+          shareTag<Omega_h::I64>(picpart, node_comm, i, shared_tags[j], node_windows);
+        else if (type == OMEGA_H_F64)
+          shareTag<Omega_h::Real>(picpart, node_comm, i, shared_tags[j], node_windows);
+      }
+    }
+
+    //The connectivity is shared as the downward adjacencies, the element to vertex
+    //  adjacency, the upward adjacencies and the element dual used by the particle search
+    const int dim = picpart->dim();
+    for (int i = 1; i <= dim; ++i)
+      shareAdj(picpart, node_comm, i, i - 1, picpart->ask_down(i, i - 1), node_windows);
+    if (dim > 1)
+      shareAdj(picpart, node_comm, dim, 0, picpart->ask_down(dim, 0), node_windows);
+    for (int i = 1; i <= dim; ++i)
+      shareAdj(picpart, node_comm, i - 1, i, picpart->ask_up(i - 1, i), node_windows);
+    shareAdj(picpart, node_comm, dim, dim, Omega_h::Adj(picpart->ask_dual()), node_windows);
+
+    //The picpart no longer references the arrays of the input mesh, so only the first rank
+    //  of each node keeps the input and the other ranks are left with an empty mesh
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+    if (node_rank != 0) {
+      Omega_h::Mesh released(input.library());
+      released.set_comm(input.comm());
+      released.set_family(input.family());
+      released.set_dim(dim);
+      released.set_verts(0);
+      input = released;
+    }
+  }
+}
@@ -0,0 +1,512 @@
+#include "ppTiming.hpp"
+#include "ppTimeSeries.hpp"
+#include "ppImbalance.hpp"
+#include "ppTrace.hpp"
+#include "ppCommVolume.hpp"
+#include "ppMemTracker.hpp"
+#include "ppPerfCounters.hpp"
+#include <Kokkos_Core.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <unistd.h>
+
+int comm_rank, comm_size;
+
+int timeSeriesTest(const char* name);
+int imbalanceTest(const char* name);
+int traceTest(const char* name);
+int commVolumeTest(const char* name);
+int memTrackerTest(const char* name);
+int perfCountersTest(const char* name);
+
+int main(int argc, char* argv[]) {
+  Kokkos::initialize(argc, argv);
+  MPI_Init(&argc, &argv);
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+  int fails = 0;
+
+  //The time series test runs first since it expects the steps to start at 0
+  fails += timeSeriesTest("Time series");
+  fails += imbalanceTest("Imbalance");
+  fails += traceTest("Trace");
+  fails += commVolumeTest("Communication volume");
+  fails += memTrackerTest("Memory tracker");
+  fails += perfCountersTest("Hardware counters");
+
+  MPI_Allreduce(MPI_IN_PLACE, &fails, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (fails == 0 && comm_rank == 0)
+    printf("All tests passed\n");
+
+  MPI_Finalize();
+  Kokkos::finalize();
+  return fails;
+}
+
+bool almostEqual(double a, double b) {
+  return std::fabs(a - b) <= 1e-9 * (std::fabs(a) + std::fabs(b) + 1);
+}
+
+std::vector<std::string> readLines(const std::string& filename) {
+  std::vector<std::string> lines;
+  std::ifstream in(filename.c_str());
+  std::string line;
+  while (std::getline(in, line))
+    lines.push_back(line);
+  return lines;
+}
+
+std::string readFile(const std::string& filename) {
+  std::ifstream in(filename.c_str());
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+//Runs `summary` and returns what it printed to stderr
+template <typename Summary>
+std::string captureStderr(Summary summary) {
+  fflush(stderr);
+  const int saved = dup(STDERR_FILENO);
+  FILE* capture = tmpfile();
+  dup2(fileno(capture), STDERR_FILENO);
+  summary();
+  fflush(stderr);
+  dup2(saved, STDERR_FILENO);
+  close(saved);
+  std::string output;
+  rewind(capture);
+  char buffer[256];
+  std::size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), capture)) > 0)
+    output.append(buffer, length);
+  fclose(capture);
+  return output;
+}
+
+//Returns the line of `text` that starts with `prefix`
+std::string findLine(const std::string& text, const std::string& prefix) {
+  std::stringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line))
+    if (line.compare(0, prefix.size(), prefix) == 0)
+      return line;
+  return "";
+}
+
+int timeSeriesTest(const char* name) {
+  if (!comm_rank)
+    printf("Beginning Test %s\n", name);
+  int fails = 0;
+  std::stringstream local_file;
+  local_file << "series_test_" << comm_rank << ".csv";
+  std::remove(local_file.str().c_str());
+  if (!comm_rank)
+    std::remove("series_test_reduced.csv");
+
+  pumipic::EnableTimeSeries();
+  const int handle = pumipic::RegisterSeries("ptcls");
+  if (pumipic::RegisterSeries("ptcls") != handle) {
+    fprintf(stderr, "[ERROR] Registering a series twice gave different handles on rank %d\n",
+            comm_rank);
+    ++fails;
+  }
+  //Step s records (rank + 1) * (s + 1) in two halves
+  const int nsteps = 3;
+  for (int s = 0; s < nsteps; ++s) {
+    const double value = (comm_rank + 1) * (s + 1);
+    pumipic::RecordSeries(handle, value / 2);
+    pumipic::RecordSeries("ptcls", value / 2);
+    if (!almostEqual(pumipic::currentSeriesValue(handle), value)) {
+      fprintf(stderr, "[ERROR] Series value %f is not %f on rank %d\n",
+              pumipic::currentSeriesValue(handle), value, comm_rank);
+      ++fails;
+    }
+    pumipic::NextTimeStep();
+  }
+  if (pumipic::currentTimeStep() != nsteps) {
+    fprintf(stderr, "[ERROR] Current step %d is not %d on rank %d\n",
+            pumipic::currentTimeStep(), nsteps, comm_rank);
+    ++fails;
+  }
+  pumipic::ReduceTimeSeries("series_test");
+  pumipic::FlushTimeSeries("series_test");
+  pumipic::WaitTimeSeries();
+  pumipic::DisableTimeSeries();
+
+  //Recording is ignored while disabled
+  pumipic::RecordSeries(handle, 1);
+  if (pumipic::currentSeriesValue(handle) != 0) {
+    fprintf(stderr, "[ERROR] Series recorded while disabled on rank %d\n", comm_rank);
+    ++fails;
+  }
+  pumipic::NextTimeStep();
+
+  std::vector<std::string> lines = readLines(local_file.str());
+  if (lines.size() != nsteps + 1 || lines[0] != "step,name,value") {
+    fprintf(stderr, "[ERROR] %s has %lu lines on rank %d\n", local_file.str().c_str(),
+            lines.size(), comm_rank);
+    ++fails;
+  }
+  for (std::size_t i = 1; i < lines.size(); ++i) {
+    int step;
+    char series[64];
+    double value;
+    if (sscanf(lines[i].c_str(), "%d,%63[^,],%lf", &step, series, &value) != 3 ||
+        step != (int)i - 1 || strcmp(series, "ptcls") != 0 ||
+        !almostEqual(value, (comm_rank + 1) * i)) {
+      fprintf(stderr, "[ERROR] Unexpected series line \"%s\" on rank %d\n", lines[i].c_str(),
+              comm_rank);
+      ++fails;
+    }
+  }
+
+  if (!comm_rank) {
+    lines = readLines("series_test_reduced.csv");
+    if (lines.size() != nsteps + 1 || lines[0] != "step,name,min,avg,max") {
+      fprintf(stderr, "[ERROR] series_test_reduced.csv has %lu lines\n", lines.size());
+      ++fails;
+    }
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+      int step;
+      char series[64];
+      double min, avg, max;
+      if (sscanf(lines[i].c_str(), "%d,%63[^,],%lf,%lf,%lf", &step, series, &min, &avg,
+                 &max) != 5 || step != (int)i - 1 || strcmp(series, "ptcls") != 0 ||
+          !almostEqual(min, i) || !almostEqual(avg, (comm_size + 1) / 2.0 * i) ||
+          !almostEqual(max, comm_size * i)) {
+        fprintf(stderr, "[ERROR] Unexpected reduced series line \"%s\"\n", lines[i].c_str());
+        ++fails;
+      }
+    }
+  }
+  return fails;
+}
+
+int imbalanceTest(const char* name) {
+  if (!comm_rank)
+    printf("Beginning Test %s\n", name);
+  int fails = 0;
+
+  pumipic::SetPrebarrierSampling(2);
+  for (int s = 0; s < 2; ++s) {
+    if (pumipic::isPrebarrierStep() != (pumipic::currentTimeStep() % 2 == 0)) {
+      fprintf(stderr, "[ERROR] Step %d is wrongly sampled on rank %d\n",
+              pumipic::currentTimeStep(), comm_rank);
+      ++fails;
+    }
+    pumipic::NextTimeStep();
+  }
+  pumipic::SetPrebarrierSampling(1);
+
+  //Each rank waits `rank` seconds over two samples so rank 0 is the straggler,
+  //  times without a prebarrier are not samples
+  pumipic::ResetImbalance();
+  pumipic::RecordTime("imbalance test", 1.0, comm_rank * 0.5);
+  pumipic::RecordTime("imbalance test", 1.0, comm_rank * 0.5);
+  pumipic::RecordTime("imbalance test", 1.0);
+  //Nothing is sampled or recorded while recording is paused
+  {
+    pumipic::ScopedPauseRecording pause;
+    if (pumipic::isPrebarrierStep()) {
+      fprintf(stderr, "[ERROR] Prebarrier sampled while paused on rank %d\n", comm_rank);
+      ++fails;
+    }
+    pumipic::RecordTime("imbalance test", 1.0, 10.0);
+  }
+  std::string summary = captureStderr([]() {pumipic::SummarizeImbalance(1);});
+  pumipic::ResetImbalance();
+  if (comm_rank)
+    return fails;
+
+  const std::string line = findLine(summary, "imbalance test");
+  int samples, straggler;
+  double avg, max, lag;
+  if (line.empty() ||
+      sscanf(line.c_str() + strlen("imbalance test"), "%d %lf %lf %d: %lf",
+             &samples, &avg, &max, &straggler, &lag) != 5) {
+    fprintf(stderr, "[ERROR] The imbalance summary has no line for the region:\n%s",
+            summary.c_str());
+    return fails + 1;
+  }
+  if (samples != 2 || !almostEqual(avg, (comm_size - 1) / 2.0) ||
+      !almostEqual(max, comm_size - 1) || straggler != 0 || !almostEqual(lag, comm_size - 1)) {
+    fprintf(stderr, "[ERROR] Unexpected imbalance summary line \"%s\"\n", line.c_str());
+    ++fails;
+  }
+  return fails;
+}
+
+//Counts the events named `event` and returns the start and duration of the last one
+int findEvent(const std::string& json, const std::string& event, double& ts, double& dur) {
+  const std::string key = "{\"name\": \"" + event + "\"";
+  int count = 0;
+  for (std::size_t pos = json.find(key); pos != std::string::npos;
+       pos = json.find(key, pos + 1)) {
+    ++count;
+    const std::size_t ts_pos = json.find("\"ts\": ", pos);
+    const std::size_t dur_pos = json.find("\"dur\": ", pos);
+    if (ts_pos == std::string::npos || dur_pos == std::string::npos)
+      return -1;
+    ts = atof(json.c_str() + ts_pos + 6);
+    dur = atof(json.c_str() + dur_pos + 7);
+  }
+  return count;
+}
+
+int traceTest(const char* name) {
+  if (!comm_rank)
+    printf("Beginning Test %s\n", name);
+  int fails = 0;
+
+  pumipic::ResetTrace();
+  {
+    pumipic::ScopedTrace untraced("untraced");
+  }
+  pumipic::EnableTrace();
+  {
+    pumipic::ScopedTrace outer("outer");
+    Kokkos::Profiling::pushRegion("kokkos region");
+    {
+      pumipic::ScopedTrace inner("inner");
+      usleep(1000);
+    }
+    Kokkos::Profiling::popRegion();
+  }
+  pumipic::DisableTrace();
+  if (pumipic::isTracing()) {
+    fprintf(stderr, "[ERROR] Tracing is on after DisableTrace on rank %d\n", comm_rank);
+    ++fails;
+  }
+
+  pumipic::WriteTrace("trace_test");
+  std::stringstream filename;
+  filename << "trace_test_" << comm_rank << ".json";
+  const std::string json = readFile(filename.str());
+  double outer_ts = 0, outer_dur = 0, inner_ts = 0, inner_dur = 0, region_ts = 0, region_dur = 0;
+  if (json.find("{\"displayTimeUnit\"") != 0 ||
+      findEvent(json, "untraced", outer_ts, outer_dur) != 0 ||
+      findEvent(json, "outer", outer_ts, outer_dur) != 1 ||
+      findEvent(json, "kokkos region", region_ts, region_dur) != 1 ||
+      findEvent(json, "inner", inner_ts, inner_dur) != 1) {
+    fprintf(stderr, "[ERROR] Unexpected events in %s\n", filename.str().c_str());
+    ++fails;
+  }
+  //Events nest in the order they were traced and the inner event slept for 1ms
+  if (inner_dur < 1000 || region_ts > inner_ts || inner_ts + inner_dur > region_ts + region_dur ||
+      outer_ts > region_ts || region_ts + region_dur > outer_ts + outer_dur) {
+    fprintf(stderr, "[ERROR] Trace events do not nest on rank %d\n", comm_rank);
+    ++fails;
+  }
+
+  pumipic::WriteMergedTrace("trace_test");
+  if (!comm_rank) {
+    const std::string merged = readFile("trace_test.json");
+    double ts, dur;
+    if (findEvent(merged, "outer", ts, dur) != comm_size) {
+      fprintf(stderr, "[ERROR] The merged trace does not have an outer event per rank\n");
+      ++fails;
+    }
+    for (int r = 0; r < comm_size; ++r) {
+      std::stringstream row;
+      row << "\"name\": \"rank " << r << "\"";
+      if (merged.find(row.str()) == std::string::npos) {
+        fprintf(stderr, "[ERROR] The merged trace does not name the row of rank %d\n", r);
+        ++fails;
+      }
+    }
+  }
+  pumipic::ResetTrace();
+  return fails;
+}
+
+int commVolumeTest(const char* name) {
+  if (!comm_rank)
+    printf("Beginning Test %s\n", name);
+  int fails = 0;
+  if (!comm_rank)
+    std::remove("comm_test.csv");
+
+  //Each rank sends 3 messages of 200 * (rank + 1) bytes to the next rank and 8 bytes to rank 0
+  pumipic::RecordCommVolume(pumipic::COMM_MIGRATE, 0, 1000);
+  pumipic::EnableCommVolume();
+  const int next = (comm_rank + 1) % comm_size;
+  pumipic::RecordCommVolume(pumipic::COMM_MIGRATE, next, 100 * (comm_rank + 1), 2);
+  pumipic::RecordCommVolume(pumipic::COMM_MIGRATE, next, 100 * (comm_rank + 1));
+  pumipic::RecordCommVolume(pumipic::COMM_FAN_IN, 0, 8);
+  pumipic::DumpCommVolume("comm_test");
+  //The dump cleared the volume and nothing is recorded while disabled
+  pumipic::DisableCommVolume();
+  pumipic::RecordCommVolume(pumipic::COMM_FAN_OUT, 0, 1000);
+  pumipic::DumpCommVolume("comm_test");
+  if (comm_rank)
+    return fails;
+
+  std::vector<std::string> lines = readLines("comm_test.csv");
+  if (lines.size() != 2 * comm_size + 1 ||
+      lines[0] != "step,phase,source,destination,messages,bytes") {
+    fprintf(stderr, "[ERROR] comm_test.csv has %lu lines\n", lines.size());
+    ++fails;
+  }
+  std::vector<int> migrate_rows(comm_size, 0), fan_in_rows(comm_size, 0);
+  for (std::size_t i = 1; i < lines.size(); ++i) {
+    int step, source, destination;
+    long messages, bytes;
+    char phase[32];
+    if (sscanf(lines[i].c_str(), "%d,%31[^,],%d,%d,%ld,%ld", &step, phase, &source,
+               &destination, &messages, &bytes) != 6 || step != pumipic::currentTimeStep() ||
+        source < 0 || source >= comm_size) {
+      fprintf(stderr, "[ERROR] Unexpected volume line \"%s\"\n", lines[i].c_str());
+      ++fails;
+      continue;
+    }
+    if (strcmp(phase, "migrate") == 0 && destination == (source + 1) % comm_size &&
+        messages == 3 && bytes == 200 * (source + 1))
+      ++migrate_rows[source];
+    else if (strcmp(phase, "fan_in") == 0 && destination == 0 && messages == 1 && bytes == 8)
+      ++fan_in_rows[source];
+    else {
+      fprintf(stderr, "[ERROR] Unexpected volume line \"%s\"\n", lines[i].c_str());
+      ++fails;
+    }
+  }
+  for (int r = 0; r < comm_size; ++r) {
+    if (migrate_rows[r] != 1 || fan_in_rows[r] != 1) {
+      fprintf(stderr, "[ERROR] Rank %d has %d migrate and %d fan in lines\n", r,
+              migrate_rows[r], fan_in_rows[r]);
+      ++fails;
+    }
+  }
+  return fails;
+}
+
+int memTrackerTest(const char* name) {
+  if (!comm_rank)
+    printf("Beginning Test %s\n", name);
+  int fails = 0;
+  const std::size_t MB = 1024 * 1024;
+  int first, second;
+
+  pumipic::SetTrackedMemory(&first, "first", pumipic::MEM_LIVE, MB);
+  if (pumipic::trackedMemory() != 0) {
+    fprintf(stderr, "[ERROR] Memory tracked while disabled on rank %d\n", comm_rank);
+    ++fails;
+  }
+  pumipic::EnableMemoryTracking();
+  pumipic::SetTrackedMemory(&first, "first", pumipic::MEM_LIVE, MB);
+  pumipic::SetTrackedMemory(&first, "first", pumipic::MEM_PADDING, MB / 2);
+  pumipic::SetTrackedMemory(&second, "second", pumipic::MEM_SWAP, 2 * MB);
+  {
+    pumipic::ScopedMemoryPhase phase("testphase");
+    pumipic::SetTrackedMemory(&second, "second", pumipic::MEM_SEARCH, 4 * MB);
+    pumipic::SetTrackedMemory(&second, "second", pumipic::MEM_SEARCH, 0);
+  }
+  //Replacing a value does not add to it
+  pumipic::SetTrackedMemory(&first, "first", pumipic::MEM_LIVE, MB / 4);
+  if (pumipic::trackedMemory() != MB / 4 + MB / 2 + 2 * MB ||
+      pumipic::trackedMemory(&first, pumipic::MEM_PADDING) != MB / 2 ||
+      pumipic::trackedMemory(&second, pumipic::MEM_SEARCH) != 0 ||
+      pumipic::peakTrackedMemory() != MB + MB / 2 + 6 * MB) {
+    fprintf(stderr, "[ERROR] Unexpected tracked memory %lu peak %lu on rank %d\n",
+            pumipic::trackedMemory(), pumipic::peakTrackedMemory(), comm_rank);
+    ++fails;
+  }
+  pumipic::ReleaseTrackedMemory(&first);
+  if (pumipic::trackedMemory() != 2 * MB ||
+      pumipic::trackedMemory(&first, pumipic::MEM_LIVE) != 0) {
+    fprintf(stderr, "[ERROR] Released memory is still tracked on rank %d\n", comm_rank);
+    ++fails;
+  }
+
+  std::string summary = captureStderr([]() {pumipic::SummarizeMemory();});
+  pumipic::DisableMemoryTracking();
+  double swap_current, swap_peak, phase_peak;
+  const std::string swap_line = findLine(summary, "second     swap");
+  const std::string phase_line = findLine(summary, "testphase");
+  if (findLine(summary, "Current 2.000 Peak 7.500").empty() || swap_line.empty() ||
+      phase_line.empty() ||
+      sscanf(swap_line.c_str() + strlen("second     swap"), "%lf %lf", &swap_current,
+             &swap_peak) != 2 ||
+      sscanf(phase_line.c_str() + strlen("testphase"), "%lf", &phase_peak) != 1 ||
+      !almostEqual(swap_current, 2) || !almostEqual(swap_peak, 2) ||
+      !almostEqual(phase_peak, 7.5)) {
+    fprintf(stderr, "[ERROR] Unexpected memory summary on rank %d:\n%s", comm_rank,
+            summary.c_str());
+    ++fails;
+  }
+  return fails;
+}
+
+int perfCountersTest(const char* name) {
+  if (!comm_rank)
+    printf("Beginning Test %s\n", name);
+  int fails = 0;
+  //Started before the counters like the OpenMP threads of Kokkos::initialize
+  std::atomic<int> start(0);
+  volatile double worker_sum = 0;
+  std::thread worker([&]() {
+    while (!start.load())
+      std::this_thread::yield();
+    for (int i = 0; i < 1000000 && start.load() == 1; ++i)
+      worker_sum = worker_sum + i;
+  });
+  if (!pumipic::EnableHardwareCounters()) {
+    start = 2;
+    worker.join();
+    printf("Hardware counters are not available on rank %d, skipping\n", comm_rank);
+    return fails;
+  }
+  if (!pumipic::hardwareCountersEnabled()) {
+    fprintf(stderr, "[ERROR] Hardware counters are not enabled on rank %d\n", comm_rank);
+    ++fails;
+  }
+
+  long long before[pumipic::NUM_HARDWARE_COUNTERS], after[pumipic::NUM_HARDWARE_COUNTERS];
+  pumipic::ReadHardwareCounters(before);
+  start = 1;
+  worker.join();
+  long long joined[pumipic::NUM_HARDWARE_COUNTERS];
+  pumipic::ReadHardwareCounters(joined);
+  if (pumipic::hasHardwareCounter(pumipic::HW_INSTRUCTIONS) &&
+      joined[pumipic::HW_INSTRUCTIONS] - before[pumipic::HW_INSTRUCTIONS] < 1000000) {
+    fprintf(stderr, "[ERROR] Counted %lld instructions of an existing thread on rank %d\n",
+            joined[pumipic::HW_INSTRUCTIONS] - before[pumipic::HW_INSTRUCTIONS], comm_rank);
+    ++fails;
+  }
+  pumipic::ReadHardwareCounters(before);
+  volatile double sum = 0;
+  for (int i = 0; i < 1000000; ++i)
+    sum = sum + i;
+  pumipic::ReadHardwareCounters(after);
+  //The loop executes at least one instruction per iteration
+  if (pumipic::hasHardwareCounter(pumipic::HW_INSTRUCTIONS) &&
+      after[pumipic::HW_INSTRUCTIONS] - before[pumipic::HW_INSTRUCTIONS] < 1000000) {
+    fprintf(stderr, "[ERROR] Counted %lld instructions on rank %d\n",
+            after[pumipic::HW_INSTRUCTIONS] - before[pumipic::HW_INSTRUCTIONS], comm_rank);
+    ++fails;
+  }
+  for (int c = 0; c < pumipic::NUM_HARDWARE_COUNTERS; ++c) {
+    if (after[c] < before[c] ||
+        (pumipic::hasHardwareCounter(static_cast<pumipic::HardwareCounter>(c)) &&
+         c == pumipic::HW_CYCLES && after[c] == before[c])) {
+      fprintf(stderr, "[ERROR] Counter %d went from %lld to %lld on rank %d\n", c, before[c],
+              after[c], comm_rank);
+      ++fails;
+    }
+  }
+  pumipic::DisableHardwareCounters();
+  if (pumipic::hardwareCountersEnabled()) {
+    fprintf(stderr, "[ERROR] Hardware counters are on after disabling on rank %d\n", comm_rank);
+    ++fails;
+  }
+  return fails;
+}
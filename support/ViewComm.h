@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <mpi.h>
 #include "ppMemUsage.hpp"
+#include "ppTrace.hpp"
+#include "ppCommVolume.hpp"
 namespace pumipic {
   /* Routines to be abstracted
      MPI_Allgather/NCCL
@@ -103,6 +103,7 @@
   //Wait
   template <typename Space>
   IsGPU<Space> PS_Comm_Wait(MPI_Request* req, MPI_Status* stat) {
+    ScopedTrace trace("MPI_Wait", TRACE_MPI);
     int ret = MPI_Wait(req, stat);
     Irecv_Map::iterator itr = get_map().find(req);
     if (itr != get_map().end()) {
@@ -115,6 +116,7 @@
   //Waitall
   template <typename Space>
   IsGPU<Space> PS_Comm_Waitall(int num_reqs, MPI_Request* reqs, MPI_Status* stats) {
+    ScopedTrace trace("MPI_Waitall", TRACE_MPI);
     int ret = MPI_Waitall(num_reqs, reqs, stats);
     for (int i = 0; i < num_reqs; ++i) {
       Irecv_Map::iterator itr = get_map().find(reqs + i);
@@ -65,6 +65,7 @@ IsHost<ViewSpace<ViewT> > PS_Comm_Irecv(ViewT view, int offset, int size,
 //Wait
 template <typename Space>
 IsHost<Space> PS_Comm_Wait(MPI_Request* req, MPI_Status* stat) {
+  ScopedTrace trace("MPI_Wait", TRACE_MPI);
 #ifdef PP_USE_GPU
   return MPI_Wait(req, stat);
 #else
@@ -81,6 +82,7 @@ IsHost<Space> PS_Comm_Wait(MPI_Request* req, MPI_Status* stat) {
 //Waitall
 template <typename Space>
 IsHost<Space> PS_Comm_Waitall(int num_reqs, MPI_Request* reqs, MPI_Status* stats) {
+  ScopedTrace trace("MPI_Waitall", TRACE_MPI);
 #ifdef PP_USE_GPU
   return MPI_Waitall(num_reqs, reqs, stats);
 #else
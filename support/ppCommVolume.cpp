@@ -0,0 +1,98 @@
+#include "ppCommVolume.hpp"
+#include "ppTimeSeries.hpp"
+#include <map>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+
+namespace {
+  bool comm_volume_enabled = false;
+
+  struct Volume {
+    Volume() : messages(0), bytes(0) {}
+    long messages;
+    long bytes;
+  };
+  //Sparse row of the matrix for this rank keyed by (phase, peer)
+  std::map<std::pair<int, int>, Volume> volumes;
+
+  const char* phaseName(int phase) {
+    const char* names[] = {"migrate", "migrate_counts", "fan_in", "fan_out"};
+    return names[phase];
+  }
+}
+
+namespace pumipic {
+
+  void EnableCommVolume() {
+    comm_volume_enabled = true;
+  }
+  void DisableCommVolume() {
+    comm_volume_enabled = false;
+  }
+  bool isCommVolumeEnabled() {
+    return comm_volume_enabled;
+  }
+
+  void RecordCommVolume(CommPhase phase, int peer, std::size_t bytes, int messages) {
+    if (!comm_volume_enabled)
+      return;
+    Volume& volume = volumes[std::make_pair(static_cast<int>(phase), peer)];
+    volume.messages += messages;
+    volume.bytes += bytes;
+  }
+
+  void DumpCommVolume(const std::string& prefix, MPI_Comm comm) {
+    int comm_rank, comm_size;
+    MPI_Comm_rank(comm, &comm_rank);
+    MPI_Comm_size(comm, &comm_size);
+
+    //Pack each entry as (phase, peer, messages, bytes)
+    std::vector<long> entries;
+    entries.reserve(4 * volumes.size());
+    for (auto itr = volumes.begin(); itr != volumes.end(); ++itr) {
+      entries.push_back(itr->first.first);
+      entries.push_back(itr->first.second);
+      entries.push_back(itr->second.messages);
+      entries.push_back(itr->second.bytes);
+    }
+    volumes.clear();
+    int length = entries.size();
+    std::vector<int> lengths(comm_size), offsets(comm_size + 1, 0);
+    MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+    std::vector<long> all_entries;
+    if (!comm_rank) {
+      for (int i = 0; i < comm_size; ++i)
+        offsets[i + 1] = offsets[i] + lengths[i];
+      all_entries.resize(offsets[comm_size]);
+    }
+    MPI_Gatherv(entries.data(), length, MPI_LONG, all_entries.data(), lengths.data(),
+                offsets.data(), MPI_LONG, 0, comm);
+    if (comm_rank)
+      return;
+
+    const std::string filename = prefix + ".csv";
+    std::ifstream existing(filename.c_str());
+    const bool new_file = !existing;
+    existing.close();
+    std::ofstream out(filename.c_str(), std::ios::app);
+    if (!out) {
+      fprintf(stderr, "[ERROR] Cannot open communication volume file %s\n", filename.c_str());
+      return;
+    }
+    if (new_file)
+      out << "step,phase,source,destination,messages,bytes\n";
+    const int step = currentTimeStep();
+    for (int rank = 0; rank < comm_size; ++rank) {
+      for (int i = offsets[rank]; i < offsets[rank + 1]; i += 4) {
+        out << step << ',' << phaseName(all_entries[i]) << ',' << rank << ','
+            << all_entries[i + 1] << ',' << all_entries[i + 2] << ',' << all_entries[i + 3]
+            << '\n';
+      }
+    }
+  }
+
+  void ResetCommVolume() {
+    volumes.clear();
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <mpi.h>
+
+/*
+  Records the number of messages and bytes each rank sends to each peer.
+
+  Recording is off by default and is turned on per process with:
+    EnableCommVolume()
+  Particle migration, the particle count exchange of migration and the fan-in/fan-out of
+  reduceCommArray record their point to point sends. Other communication can be added with:
+    RecordCommVolume(phase, peer, bytes, messages)
+
+  The rank x rank matrix is written with:
+    DumpCommVolume(prefix) - appends the nonzero entries of every rank to `<prefix>.csv`
+  Calling it every N steps gives the volume of each N step window.
+*/
+
+namespace pumipic {
+
+  enum CommPhase {
+    COMM_MIGRATE,        //particle data sent by migrate
+    COMM_MIGRATE_COUNTS, //number of particles exchanged before migrate
+    COMM_FAN_IN,         //reduceCommArray values sent to the owner of a core
+    COMM_FAN_OUT,        //reduceCommArray reduced values sent back to the picparts
+    NUM_COMM_PHASES
+  };
+
+  //Turns on recording of the communication volume on the calling process
+  void EnableCommVolume();
+  //Turns off recording of the communication volume on the calling process
+  void DisableCommVolume();
+  bool isCommVolumeEnabled();
+
+  //Adds `messages` sends of `bytes` in total to the rank `peer` of the communicator
+  void RecordCommVolume(CommPhase phase, int peer, std::size_t bytes, int messages = 1);
+
+  /*
+    Gathers the recorded volume to rank 0 of `comm` and appends a
+    `step,phase,source,destination,messages,bytes` line per nonzero entry to `<prefix>.csv`.
+    The step is the current step of NextTimeStep(). The recorded volume is cleared.
+
+    Note: This is a collective call and must be called by every process
+  */
+  void DumpCommVolume(const std::string& prefix, MPI_Comm comm = MPI_COMM_WORLD);
+
+  //Clears the recorded volume
+  void ResetCommVolume();
+}
@@ -0,0 +1,122 @@
+#include "ppImbalance.hpp"
+#include "ppTimeSeries.hpp"
+#include "ppTiming.hpp"
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+namespace {
+  int sample_interval = 1;
+
+  struct RegionWait {
+    RegionWait() : wait(0), samples(0) {}
+    double wait;
+    int samples;
+  };
+  std::vector<std::string> region_names;
+  std::vector<RegionWait> region_waits;
+  std::unordered_map<std::string, int> region_index;
+}
+
+namespace pumipic {
+
+  void SetPrebarrierSampling(int interval) {
+    if (interval < 1) {
+      fprintf(stderr, "[ERROR] Prebarrier sampling interval must be at least 1\n");
+      return;
+    }
+    sample_interval = interval;
+  }
+
+  bool isPrebarrierStep() {
+    return !isRecordingPaused() && currentTimeStep() % sample_interval == 0;
+  }
+
+  void RecordImbalance(const std::string& region, double seconds) {
+    auto itr = region_index.find(region);
+    if (itr == region_index.end()) {
+      itr = region_index.insert(std::make_pair(region, region_names.size())).first;
+      region_names.push_back(region);
+      region_waits.push_back(RegionWait());
+    }
+    region_waits[itr->second].wait += seconds;
+    ++(region_waits[itr->second].samples);
+  }
+
+  void SummarizeImbalance(int nstragglers, MPI_Comm comm) {
+    int comm_rank, comm_size;
+    MPI_Comm_rank(comm, &comm_rank);
+    MPI_Comm_size(comm, &comm_size);
+
+    //Share the region names of rank 0 so every rank sends its waits in the same order
+    std::string packed;
+    if (!comm_rank) {
+      for (std::size_t i = 0; i < region_names.size(); ++i)
+        packed.append(region_names[i].c_str(), region_names[i].size() + 1);
+    }
+    int packed_size = packed.size();
+    MPI_Bcast(&packed_size, 1, MPI_INT, 0, comm);
+    if (packed_size == 0)
+      return;
+    packed.resize(packed_size);
+    MPI_Bcast(&packed[0], packed_size, MPI_CHAR, 0, comm);
+    std::vector<std::string> names;
+    for (std::size_t pos = 0; pos < packed.size(); pos += names.back().size() + 1)
+      names.push_back(std::string(packed.c_str() + pos));
+
+    const int nregions = names.size();
+    std::vector<double> waits(nregions, 0);
+    for (int i = 0; i < nregions; ++i) {
+      auto itr = region_index.find(names[i]);
+      if (itr != region_index.end())
+        waits[i] = region_waits[itr->second].wait;
+    }
+    std::vector<double> rank_waits;
+    if (!comm_rank)
+      rank_waits.resize(nregions * comm_size);
+    MPI_Gather(waits.data(), nregions, MPI_DOUBLE, rank_waits.data(), nregions, MPI_DOUBLE, 0,
+               comm);
+    if (comm_rank)
+      return;
+
+    std::size_t name_length = 9;
+    for (int i = 0; i < nregions; ++i)
+      name_length = std::max(name_length, names[i].size());
+    const int nshow = std::min(std::max(nstragglers, 0), comm_size);
+    std::stringstream buffer;
+    buffer << "Imbalance Summary (prebarrier wait in seconds)\n"
+           << "Region" << std::string(name_length - 3, ' ')
+           << "   Samples     Average Wait     Maximum Wait   Stragglers (rank: lag)\n";
+    std::vector<int> ranks(comm_size);
+    for (int i = 0; i < nregions; ++i) {
+      const double* wait = rank_waits.data() + i;
+      double avg = 0, max = 0;
+      for (int r = 0; r < comm_size; ++r) {
+        avg += wait[r * nregions];
+        max = std::max(max, wait[r * nregions]);
+        ranks[r] = r;
+      }
+      avg /= comm_size;
+      //The ranks that waited the least arrived last
+      std::partial_sort(ranks.begin(), ranks.begin() + nshow, ranks.end(), [&](int a, int b) {
+        return wait[a * nregions] < wait[b * nregions];
+      });
+      buffer << names[i] << std::string(name_length - names[i].size() + 3, ' ')
+             << std::setw(10) << region_waits[region_index[names[i]]].samples
+             << std::setw(17) << avg
+             << std::setw(17) << max << "  ";
+      for (int s = 0; s < nshow; ++s)
+        buffer << ' ' << ranks[s] << ": " << max - wait[ranks[s] * nregions];
+      buffer << '\n';
+    }
+    fprintf(stderr, "%s\n", buffer.str().c_str());
+  }
+
+  void ResetImbalance() {
+    for (std::size_t i = 0; i < region_waits.size(); ++i)
+      region_waits[i] = RegionWait();
+  }
+}
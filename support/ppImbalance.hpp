@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <mpi.h>
+
+/*
+  Attributes load imbalance to ranks from the time spent waiting at the prebarrier.
+
+  When prebarriers are enabled (enable_prebarrier/pumipic_enable_prebarrier), the wait of every
+  RecordTime call with a prebarrier time is accumulated per region on each rank. The rank that
+  arrives last at the barrier waits the least, so the ranks with the smallest wait are the
+  stragglers and the difference to the largest wait is how long the other ranks waited on them.
+
+  To keep the barrier cost small the prebarrier can be sampled on every N steps with:
+    SetPrebarrierSampling(N) - steps are advanced by NextTimeStep()
+
+  The stragglers of each region are printed on rank 0 with:
+    SummarizeImbalance()
+*/
+
+namespace pumipic {
+
+  //Measure the prebarrier only on steps that are a multiple of `interval` (default 1)
+  void SetPrebarrierSampling(int interval);
+
+  //Whether the prebarrier should be measured in the current step, never while recording is paused
+  bool isPrebarrierStep();
+
+  //Adds a prebarrier wait of `seconds` to the region, called by RecordTime
+  void RecordImbalance(const std::string& region, double seconds);
+
+  /*
+    Print the wait of each region reduced over the ranks of `comm` and the `nstragglers` ranks
+    that waited the least with how much later they arrived than the first rank
+
+    Regions are matched by name, regions not recorded on rank 0 are skipped.
+    Note: This is a collective call and must be called by every process
+  */
+  void SummarizeImbalance(int nstragglers = 3, MPI_Comm comm = MPI_COMM_WORLD);
+
+  //Clears the accumulated waits
+  void ResetImbalance();
+}
@@ -0,0 +1,162 @@
+#include "ppMemTracker.hpp"
+#include <mpi.h>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+namespace {
+  bool memory_tracking = false;
+
+  struct OwnerMemory {
+    OwnerMemory(const std::string& n) : name(n), total(0), peak_total(0) {
+      std::fill(current, current + pumipic::NUM_MEMORY_CATEGORIES, 0);
+      std::fill(peak, peak + pumipic::NUM_MEMORY_CATEGORIES, 0);
+    }
+    std::string name;
+    std::size_t current[pumipic::NUM_MEMORY_CATEGORIES];
+    std::size_t peak[pumipic::NUM_MEMORY_CATEGORIES];
+    std::size_t total;
+    std::size_t peak_total;
+  };
+  //Released owners are kept for the summary, the map only holds live owners
+  std::vector<OwnerMemory> owners;
+  std::unordered_map<const void*, int> owner_index;
+  std::size_t total_bytes = 0;
+  std::size_t peak_bytes = 0;
+
+  std::vector<std::string> phase_names;
+  std::unordered_map<std::string, int> phase_index;
+  std::vector<std::size_t> phase_peaks;
+  //Active phases, -1 for phases begun while tracking was off
+  std::vector<int> phase_stack;
+
+  void updatePeaks() {
+    peak_bytes = std::max(peak_bytes, total_bytes);
+    for (std::size_t i = 0; i < phase_stack.size(); ++i) {
+      if (phase_stack[i] >= 0)
+        phase_peaks[phase_stack[i]] = std::max(phase_peaks[phase_stack[i]], total_bytes);
+    }
+  }
+
+  const char* categoryName(int category) {
+    const char* names[] = {"live", "padding", "swap", "migration", "search"};
+    return names[category];
+  }
+
+  double toMB(std::size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+  }
+}
+
+namespace pumipic {
+
+  void EnableMemoryTracking() {
+    memory_tracking = true;
+  }
+  void DisableMemoryTracking() {
+    memory_tracking = false;
+  }
+  bool isMemoryTracking() {
+    return memory_tracking;
+  }
+
+  void SetTrackedMemory(const void* owner, const std::string& name, MemoryCategory category,
+                        std::size_t bytes) {
+    if (!memory_tracking)
+      return;
+    auto itr = owner_index.find(owner);
+    if (itr == owner_index.end()) {
+      itr = owner_index.insert(std::make_pair(owner, (int)owners.size())).first;
+      owners.push_back(OwnerMemory(name));
+    }
+    OwnerMemory& memory = owners[itr->second];
+    total_bytes = total_bytes - memory.current[category] + bytes;
+    memory.total = memory.total - memory.current[category] + bytes;
+    memory.current[category] = bytes;
+    memory.peak[category] = std::max(memory.peak[category], bytes);
+    memory.peak_total = std::max(memory.peak_total, memory.total);
+    updatePeaks();
+  }
+
+  void ReleaseTrackedMemory(const void* owner) {
+    auto itr = owner_index.find(owner);
+    if (itr == owner_index.end())
+      return;
+    OwnerMemory& memory = owners[itr->second];
+    total_bytes -= memory.total;
+    memory.total = 0;
+    std::fill(memory.current, memory.current + NUM_MEMORY_CATEGORIES, 0);
+    owner_index.erase(itr);
+  }
+
+  std::size_t trackedMemory() {
+    return total_bytes;
+  }
+  std::size_t trackedMemory(const void* owner, MemoryCategory category) {
+    auto itr = owner_index.find(owner);
+    if (itr == owner_index.end())
+      return 0;
+    return owners[itr->second].current[category];
+  }
+  std::size_t peakTrackedMemory() {
+    return peak_bytes;
+  }
+
+  void BeginMemoryPhase(const char* phase) {
+    if (!memory_tracking) {
+      phase_stack.push_back(-1);
+      return;
+    }
+    auto itr = phase_index.find(phase);
+    if (itr == phase_index.end()) {
+      itr = phase_index.insert(std::make_pair(std::string(phase), (int)phase_names.size())).first;
+      phase_names.push_back(phase);
+      phase_peaks.push_back(0);
+    }
+    phase_stack.push_back(itr->second);
+    updatePeaks();
+  }
+
+  void EndMemoryPhase() {
+    if (!phase_stack.empty())
+      phase_stack.pop_back();
+  }
+
+  void SummarizeMemory() {
+    if (owners.empty())
+      return;
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+    std::stringstream buffer;
+    buffer << std::fixed << std::setprecision(3);
+    buffer << "Memory Summary " << comm_rank << " (MB)\n"
+           << "Current " << toMB(total_bytes) << " Peak " << toMB(peak_bytes) << '\n'
+           << "Owner      Category         Current           Peak\n";
+    for (std::size_t i = 0; i < owners.size(); ++i) {
+      const OwnerMemory& memory = owners[i];
+      for (int c = 0; c < NUM_MEMORY_CATEGORIES; ++c) {
+        if (memory.peak[c] == 0)
+          continue;
+        buffer << std::left << std::setw(10) << memory.name << ' '
+               << std::setw(10) << categoryName(c) << std::right
+               << std::setw(15) << toMB(memory.current[c])
+               << std::setw(15) << toMB(memory.peak[c]) << '\n';
+      }
+      //The padding relative to the live particles shows the cost of the padding options
+      if (memory.current[MEM_LIVE] > 0)
+        buffer << std::left << std::setw(10) << memory.name << std::right
+               << " padding/live " << (double)memory.current[MEM_PADDING] / memory.current[MEM_LIVE]
+               << " peak total " << toMB(memory.peak_total) << '\n';
+    }
+    if (!phase_names.empty()) {
+      buffer << "Phase      Peak\n";
+      for (std::size_t i = 0; i < phase_names.size(); ++i)
+        buffer << std::left << std::setw(10) << phase_names[i] << std::right
+               << std::setw(15) << toMB(phase_peaks[i]) << '\n';
+    }
+    fprintf(stderr, "%s\n", buffer.str().c_str());
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+  Accounts the bytes held by each particle structure and tracks the peak usage.
+
+  Tracking is off by default and is turned on per process with:
+    EnableMemoryTracking()
+  Particle structures report their live particle data, the padding around it, their swap
+  space and their migration buffers. The mesh search reports its workspace.
+
+  Peaks are also tracked per phase, a phase is active while a ScopedMemoryPhase exists:
+    ScopedMemoryPhase phase("rebuild");
+
+  The current and peak usage is printed with:
+    SummarizeMemory()
+*/
+
+namespace pumipic {
+
+  enum MemoryCategory {
+    MEM_LIVE,      //particle data of active particles
+    MEM_PADDING,   //allocated particle data that holds no particle
+    MEM_SWAP,      //swap space kept between rebuilds
+    MEM_MIGRATION, //send and receive buffers of migration
+    MEM_SEARCH,    //workspace of the mesh search
+    NUM_MEMORY_CATEGORIES
+  };
+
+  //Turns on memory accounting on the calling process
+  void EnableMemoryTracking();
+  //Turns off memory accounting on the calling process
+  void DisableMemoryTracking();
+  bool isMemoryTracking();
+
+  /*
+    Sets the bytes `owner` currently holds in `category`
+    `name` labels the owner in the summary, owners are told apart by their address
+  */
+  void SetTrackedMemory(const void* owner, const std::string& name, MemoryCategory category,
+                        std::size_t bytes);
+
+  //Zeroes the memory of `owner`, called when the owner is destroyed
+  void ReleaseTrackedMemory(const void* owner);
+
+  //Total bytes currently tracked and the peak of the total
+  std::size_t trackedMemory();
+  //Bytes `owner` currently holds in `category`
+  std::size_t trackedMemory(const void* owner, MemoryCategory category);
+  std::size_t peakTrackedMemory();
+
+  void BeginMemoryPhase(const char* phase);
+  void EndMemoryPhase();
+
+  //Tracks the peak usage while in the enclosing scope
+  class ScopedMemoryPhase {
+  public:
+    explicit ScopedMemoryPhase(const char* phase) {BeginMemoryPhase(phase);}
+    ~ScopedMemoryPhase() {EndMemoryPhase();}
+    ScopedMemoryPhase(const ScopedMemoryPhase&) = delete;
+    ScopedMemoryPhase& operator=(const ScopedMemoryPhase&) = delete;
+  };
+
+  /*
+    Print the current and peak bytes of each owner and category and the peak of each phase
+    on the calling process
+  */
+  void SummarizeMemory();
+}
@@ -0,0 +1,130 @@
+#include "ppPerfCounters.hpp"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+namespace {
+  bool counters_enabled = false;
+  //One descriptor per thread of the process for each counter
+  std::vector<int> counter_fds[pumipic::NUM_HARDWARE_COUNTERS];
+
+#ifdef __linux__
+  int openCounter(unsigned long long config, pid_t tid) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    //cpu -1 counts the thread (and the threads it creates) on any cpu
+    const int fd = syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0);
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    return fd;
+  }
+
+  /*
+    Lists the threads of the process, including the OpenMP workers Kokkos::initialize
+    already created which a counter opened on the calling thread would not inherit
+  */
+  std::vector<pid_t> processThreads() {
+    std::vector<pid_t> tids;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir) {
+      while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.')
+          tids.push_back(atoi(entry->d_name));
+      }
+      closedir(dir);
+    }
+    if (tids.empty())
+      tids.push_back(0);
+    return tids;
+  }
+#endif
+}
+
+namespace pumipic {
+
+  bool EnableHardwareCounters() {
+    if (counters_enabled)
+      return true;
+#ifdef __linux__
+    const unsigned long long configs[NUM_HARDWARE_COUNTERS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+    };
+    const std::vector<pid_t> tids = processThreads();
+    bool any = false;
+    bool partial = false;
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+      for (std::size_t t = 0; t < tids.size(); ++t) {
+        const int fd = openCounter(configs[i], tids[t]);
+        if (fd >= 0)
+          counter_fds[i].push_back(fd);
+      }
+      any |= !counter_fds[i].empty();
+      partial |= !counter_fds[i].empty() && counter_fds[i].size() != tids.size();
+    }
+    if (!any) {
+      fprintf(stderr, "[WARNING] Hardware counters are unavailable, check "
+              "/proc/sys/kernel/perf_event_paranoid\n");
+      return false;
+    }
+    if (partial)
+      fprintf(stderr, "[WARNING] Hardware counters could not be opened on every thread, "
+              "counts are incomplete\n");
+    counters_enabled = true;
+    return true;
+#else
+    fprintf(stderr, "[WARNING] Hardware counters require Linux perf_event_open\n");
+    return false;
+#endif
+  }
+
+  void DisableHardwareCounters() {
+#ifdef __linux__
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+      for (std::size_t t = 0; t < counter_fds[i].size(); ++t)
+        close(counter_fds[i][t]);
+      counter_fds[i].clear();
+    }
+#endif
+    counters_enabled = false;
+  }
+
+  bool hardwareCountersEnabled() {
+    return counters_enabled;
+  }
+
+  bool hasHardwareCounter(HardwareCounter counter) {
+    return !counter_fds[counter].empty();
+  }
+
+  void ReadHardwareCounters(long long values[NUM_HARDWARE_COUNTERS]) {
+    for (int i = 0; i < NUM_HARDWARE_COUNTERS; ++i) {
+      values[i] = 0;
+#ifdef __linux__
+      //Sum the threads, a thread that exited reads the count it reached
+      for (std::size_t t = 0; t < counter_fds[i].size(); ++t) {
+        long long value = 0;
+        if (read(counter_fds[i][t], &value, sizeof(long long)) == sizeof(long long))
+          values[i] += value;
+      }
+#endif
+    }
+  }
+}
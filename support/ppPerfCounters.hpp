@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+  Optional hardware counters read through Linux perf_event_open.
+
+  When enabled with EnableHardwareCounters(), the hierarchical timers (see ppTiming.hpp) count
+  cycles, instructions and last level cache misses of each timer. SummarizeTime and
+  SummarizeTimerTree then print the instructions per cycle, the cache misses and the memory
+  bandwidth estimated from the misses beside the wall time.
+
+  A counter is opened on every thread of the process when they are enabled, including the
+  OpenMP threads created by Kokkos::initialize, and follows the threads they create afterwards.
+  The reads sum the threads. Device kernels are not counted. Counting uses user space events only so perf_event_paranoid <= 2 is sufficient.
+*/
+
+namespace pumipic {
+
+  enum HardwareCounter {
+    HW_CYCLES,
+    HW_INSTRUCTIONS,
+    HW_LLC_MISSES,
+    NUM_HARDWARE_COUNTERS
+  };
+
+  /*
+    Opens the hardware counters on every thread of the calling process
+    Returns false if no counter could be opened, counters that are not supported read as 0
+  */
+  bool EnableHardwareCounters();
+  void DisableHardwareCounters();
+  bool hardwareCountersEnabled();
+
+  //Whether `counter` was opened
+  bool hasHardwareCounter(HardwareCounter counter);
+
+  //Reads the current value of every counter into `values`
+  void ReadHardwareCounters(long long values[NUM_HARDWARE_COUNTERS]);
+
+  //Bytes moved from memory per last level cache miss, used to estimate bandwidth
+  const int CACHE_LINE_BYTES = 64;
+}
@@ -0,0 +1,234 @@
+#include "ppTimeSeries.hpp"
+#include "ppTiming.hpp"
+#include <unordered_map>
+#include <vector>
+#include <future>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+  bool series_enabled = false;
+  std::vector<std::string> series_names;
+  std::unordered_map<std::string, int> series_handles;
+
+  //Values of the current step indexed by handle
+  std::vector<double> current_step;
+  //Buffered steps, each sized by the number of series registered when it ended
+  std::vector<std::vector<double> > steps;
+  //Index of the current step, advanced even when recording is off
+  int time_step = 0;
+
+  std::future<void> pending_write;
+
+  void waitForWrite() {
+    if (pending_write.valid())
+      pending_write.get();
+  }
+
+  double value(const std::vector<double>& step, std::size_t index) {
+    return index < step.size() ? step[index] : 0;
+  }
+
+  //Writes steps of one or more values per series, `names` is the series of each column group
+  void writeSteps(std::string filename, pumipic::TimeSeriesFormat format,
+                  std::vector<std::string> names, std::vector<std::string> columns,
+                  std::vector<std::vector<double> > values, int first) {
+    std::ifstream existing(filename.c_str(), std::ios::ate | std::ios::binary);
+    const bool new_file = !existing || existing.tellg() <= 0;
+    existing.close();
+    std::ofstream out(filename.c_str(), std::ios::app);
+    if (!out) {
+      fprintf(stderr, "[ERROR] Cannot open time series file %s\n", filename.c_str());
+      return;
+    }
+    out << std::setprecision(9);
+    const std::size_t ncols = columns.size();
+    if (format == pumipic::SERIES_CSV && new_file) {
+      out << "step,name";
+      for (std::size_t c = 0; c < ncols; ++c)
+        out << ',' << columns[c];
+      out << '\n';
+    }
+    for (std::size_t s = 0; s < values.size(); ++s) {
+      const std::vector<double>& step = values[s];
+      if (format == pumipic::SERIES_CSV) {
+        for (std::size_t i = 0; i < names.size(); ++i) {
+          if (i * ncols >= step.size())
+            break;
+          out << first + s << ',' << names[i];
+          for (std::size_t c = 0; c < ncols; ++c)
+            out << ',' << value(step, i * ncols + c);
+          out << '\n';
+        }
+      }
+      else {
+        out << "{\"step\": " << first + s;
+        for (std::size_t i = 0; i < names.size(); ++i) {
+          if (i * ncols >= step.size())
+            break;
+          out << ", \"" << names[i] << "\": ";
+          if (ncols == 1)
+            out << value(step, i);
+          else {
+            out << '{';
+            for (std::size_t c = 0; c < ncols; ++c)
+              out << (c ? ", \"" : "\"") << columns[c] << "\": " << value(step, i * ncols + c);
+            out << '}';
+          }
+        }
+        out << "}\n";
+      }
+    }
+  }
+
+  std::string extension(pumipic::TimeSeriesFormat format) {
+    return format == pumipic::SERIES_CSV ? ".csv" : ".json";
+  }
+}
+
+namespace pumipic {
+
+  void EnableTimeSeries() {
+    series_enabled = true;
+  }
+  void DisableTimeSeries() {
+    series_enabled = false;
+    waitForWrite();
+  }
+  bool isTimeSeriesEnabled() {
+    return series_enabled;
+  }
+
+  int RegisterSeries(const std::string& name) {
+    auto itr = series_handles.find(name);
+    if (itr != series_handles.end())
+      return itr->second;
+    const int handle = series_names.size();
+    series_names.push_back(name);
+    series_handles[name] = handle;
+    return handle;
+  }
+
+  void RecordSeries(int handle, double value) {
+    if (!series_enabled || isRecordingPaused())
+      return;
+    if (handle < 0 || handle >= (int)series_names.size()) {
+      fprintf(stderr, "[ERROR] Recording to unregistered series %d\n", handle);
+      return;
+    }
+    if (handle >= (int)current_step.size())
+      current_step.resize(series_names.size(), 0);
+    current_step[handle] += value;
+  }
+
+  void RecordSeries(const std::string& name, double value) {
+    if (!series_enabled || isRecordingPaused())
+      return;
+    RecordSeries(RegisterSeries(name), value);
+  }
+
+  double currentSeriesValue(int handle) {
+    return value(current_step, handle);
+  }
+
+  void NextTimeStep() {
+    ++time_step;
+    if (!series_enabled)
+      return;
+    current_step.resize(series_names.size(), 0);
+    steps.push_back(current_step);
+    std::fill(current_step.begin(), current_step.end(), 0);
+  }
+
+  int currentTimeStep() {
+    return time_step;
+  }
+
+  void FlushTimeSeries(const std::string& prefix, TimeSeriesFormat format) {
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+    std::stringstream filename;
+    filename << prefix << '_' << comm_rank << extension(format);
+    std::vector<std::vector<double> > buffered;
+    buffered.swap(steps);
+    const int first = time_step - buffered.size();
+    waitForWrite();
+    pending_write = std::async(std::launch::async, writeSteps, filename.str(), format,
+                               series_names, std::vector<std::string>(1, "value"),
+                               std::move(buffered), first);
+  }
+
+  void WaitTimeSeries() {
+    waitForWrite();
+  }
+
+  void ReduceTimeSeries(const std::string& prefix, TimeSeriesFormat format, MPI_Comm comm) {
+    int comm_rank, comm_size;
+    MPI_Comm_rank(comm, &comm_rank);
+    MPI_Comm_size(comm, &comm_size);
+
+    int nsteps[2] = {(int)steps.size(), -(int)steps.size()};
+    MPI_Allreduce(MPI_IN_PLACE, nsteps, 2, MPI_INT, MPI_MIN, comm);
+    if (nsteps[0] != -nsteps[1]) {
+      if (!comm_rank)
+        fprintf(stderr, "[ERROR] Ranks buffered different numbers of steps (%d to %d)\n",
+                nsteps[0], -nsteps[1]);
+      return;
+    }
+
+    //Share the series names of rank 0 so every rank reduces the same series in the same order
+    std::string packed;
+    if (!comm_rank) {
+      for (std::size_t i = 0; i < series_names.size(); ++i)
+        packed.append(series_names[i].c_str(), series_names[i].size() + 1);
+    }
+    int packed_size = packed.size();
+    MPI_Bcast(&packed_size, 1, MPI_INT, 0, comm);
+    packed.resize(packed_size);
+    MPI_Bcast(&packed[0], packed_size, MPI_CHAR, 0, comm);
+    std::vector<std::string> names;
+    for (std::size_t pos = 0; pos < packed.size(); pos += names.back().size() + 1)
+      names.push_back(std::string(packed.c_str() + pos));
+
+    //Store each value and its negation so a single MIN reduction gives both the min and max
+    const std::size_t nseries = names.size();
+    const std::size_t nvalues = nsteps[0] * nseries;
+    std::vector<double> extremes(2 * nvalues), sums(nvalues);
+    for (std::size_t i = 0; i < nseries; ++i) {
+      auto itr = series_handles.find(names[i]);
+      const int handle = itr == series_handles.end() ? -1 : itr->second;
+      for (int s = 0; s < nsteps[0]; ++s) {
+        const double val = handle < 0 ? 0 : value(steps[s], handle);
+        extremes[2 * (s * nseries + i)] = val;
+        extremes[2 * (s * nseries + i) + 1] = -val;
+        sums[s * nseries + i] = val;
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, extremes.data(), extremes.size(), MPI_DOUBLE, MPI_MIN, comm);
+    MPI_Allreduce(MPI_IN_PLACE, sums.data(), sums.size(), MPI_DOUBLE, MPI_SUM, comm);
+    if (comm_rank)
+      return;
+
+    std::vector<std::vector<double> > reduced(nsteps[0], std::vector<double>(3 * nseries));
+    for (int s = 0; s < nsteps[0]; ++s) {
+      for (std::size_t i = 0; i < nseries; ++i) {
+        const std::size_t index = s * nseries + i;
+        reduced[s][3 * i] = extremes[2 * index];
+        reduced[s][3 * i + 1] = sums[index] / comm_size;
+        reduced[s][3 * i + 2] = -extremes[2 * index + 1];
+      }
+    }
+    std::vector<std::string> columns;
+    columns.push_back("min");
+    columns.push_back("avg");
+    columns.push_back("max");
+    waitForWrite();
+    pending_write = std::async(std::launch::async, writeSteps,
+                               prefix + "_reduced" + extension(format), format, names, columns,
+                               std::move(reduced), time_step - nsteps[0]);
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <mpi.h>
+
+/*
+  Records per step values of timers and counters to follow how costs change over a run.
+
+  Recording is off by default and is turned on with:
+    EnableTimeSeries() - every call to RecordTime is also recorded for the current step
+  Counters are registered once and added to the current step with:
+    static const int handle = RegisterSeries("name");
+    RecordSeries(handle, value);
+  Values recorded for the same series during one step are summed.
+
+  The application marks the end of each step with:
+    NextTimeStep()
+
+  The buffered steps can be written with:
+    FlushTimeSeries(prefix, format) - writes this rank's steps in the background
+    ReduceTimeSeries(prefix, format, comm) - writes min/avg/max of each step over the ranks
+*/
+
+namespace pumipic {
+
+  enum TimeSeriesFormat {
+    SERIES_CSV, //one `step,name,value` line per value
+    SERIES_JSON //one JSON object per step
+  };
+
+  //Turns on recording of per step values on the calling process
+  void EnableTimeSeries();
+  //Turns off recording of per step values, waits for pending writes
+  void DisableTimeSeries();
+  bool isTimeSeriesEnabled();
+
+  /*
+    Registers a series and returns its handle
+    Registering the same name again returns the same handle
+  */
+  int RegisterSeries(const std::string& name);
+
+  //Adds `value` to the series in the current step
+  void RecordSeries(int handle, double value);
+  void RecordSeries(const std::string& name, double value);
+
+  //The value the series has accumulated so far in the current step
+  double currentSeriesValue(int handle);
+
+  /*
+    Ends the current step, following values are recorded in the next step
+    The step index is advanced even when recording is off, it also drives prebarrier sampling
+  */
+  void NextTimeStep();
+
+  //The index of the current step
+  int currentTimeStep();
+
+  /*
+    Appends the buffered steps to `<prefix>_<rank>.csv` or `<prefix>_<rank>.json` on a
+    background thread and clears the buffer
+
+    Only one write is in flight at a time, a second flush waits for the first
+  */
+  void FlushTimeSeries(const std::string& prefix, TimeSeriesFormat format = SERIES_CSV);
+
+  //Waits for the background write of FlushTimeSeries/ReduceTimeSeries to complete
+  void WaitTimeSeries();
+
+  /*
+    Reduces the buffered steps over the ranks of `comm` to the min, avg and max of each series
+    and appends them to `<prefix>_reduced.csv` or `<prefix>_reduced.json` on rank 0.
+    The buffer is not cleared so the per rank values can still be flushed.
+
+    Series are matched by name, series not registered on rank 0 are skipped.
+    Note: This is a collective call and every rank must have buffered the same steps
+  */
+  void ReduceTimeSeries(const std::string& prefix, TimeSeriesFormat format = SERIES_CSV,
+                        MPI_Comm comm = MPI_COMM_WORLD);
+}
@@ -1,4 +1,7 @@
 #include "ppTiming.hpp"
+#include "ppTimeSeries.hpp"
+#include "ppImbalance.hpp"
+#include "ppPerfCounters.hpp"
 #include <unordered_map>
 #include <vector>
 #include <mpi.h>
@@ -6,6 +9,7 @@
 #include <sstream>
 #include <iomanip>
 #include <Kokkos_Core.hpp>
+#include <chrono>
 
 namespace {
   int verbosity = 0;
@@ -24,12 +28,118 @@ namespace {
     int orig_index;
   };
   std::vector<TimeInfo> time_per_op;
+  //Depth of nested PauseRecording calls
+  int paused = 0;
 
   bool isTiming() {
     int comm_rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
     return enable_timing > 0 || (enable_timing == 0 && comm_rank == 0);
   }
+
+  //Hierarchical timers
+  typedef std::chrono::steady_clock Clock;
+  std::vector<std::string> timer_names;
+  std::unordered_map<std::string, int> timer_handles;
+  //Whether each timer is also listed in the flat summary
+  std::vector<char> timer_flat;
+  struct TimerNode {
+    TimerNode(int h, int p, int d) : handle(h), parent(p), depth(d), inclusive(0),
+                                     children_time(0), count(0) {
+      std::fill(counters, counters + pumipic::NUM_HARDWARE_COUNTERS, 0);
+    }
+    int handle;
+    int parent;
+    int depth;
+    std::vector<int> children;
+    Clock::duration inclusive;
+    Clock::duration children_time;
+    long count;
+    //Inclusive hardware counts, only when hardware counters are enabled
+    long long counters[pumipic::NUM_HARDWARE_COUNTERS];
+  };
+  //Node 0 is the root of the call tree
+  std::vector<TimerNode> timer_nodes(1, TimerNode(-1, -1, -1));
+  struct TimerFrame {
+    int node;
+    Clock::time_point start;
+    //Whether the counters were read at the start of the frame
+    bool counting;
+    long long counters[pumipic::NUM_HARDWARE_COUNTERS];
+  };
+  std::vector<TimerFrame> timer_stack;
+  //Time and calls of each flat timer already added to the flat summary
+  std::vector<Clock::duration> flat_time;
+  std::vector<long> flat_count;
+  //Nesting depth reserved for the stack so starting a timer does not allocate
+  const std::size_t TIMER_STACK_RESERVE = 64;
+  //Cached result of isTiming, -1 until the first timer starts
+  int tree_timing = -1;
+
+  bool isTreeTiming() {
+    if (tree_timing < 0)
+      tree_timing = isTiming() && verbosity >= 0;
+    return tree_timing;
+  }
+
+  //Appends the instructions per cycle, cache misses and estimated memory bandwidth
+  void appendCounters(std::stringstream& buffer, const long long* counters, double seconds) {
+    using namespace pumipic;
+    buffer << "  IPC ";
+    if (counters[HW_CYCLES] > 0 && hasHardwareCounter(HW_INSTRUCTIONS))
+      buffer << (double)counters[HW_INSTRUCTIONS] / counters[HW_CYCLES];
+    else
+      buffer << "n/a";
+    if (hasHardwareCounter(HW_LLC_MISSES)) {
+      buffer << " LLC misses " << counters[HW_LLC_MISSES] << " est. GB/s ";
+      if (seconds > 0)
+        buffer << counters[HW_LLC_MISSES] * (double)CACHE_LINE_BYTES / seconds / 1e9;
+      else
+        buffer << "n/a";
+    }
+  }
+
+  int findChild(int parent, int handle) {
+    const std::vector<int>& children = timer_nodes[parent].children;
+    for (std::size_t i = 0; i < children.size(); ++i)
+      if (timer_nodes[children[i]].handle == handle)
+        return children[i];
+    const int node = timer_nodes.size();
+    timer_nodes.push_back(TimerNode(handle, parent, timer_nodes[parent].depth + 1));
+    timer_nodes[parent].children.push_back(node);
+    return node;
+  }
+
+  TimeInfo& timeInfo(const std::string& str) {
+    auto itr = timing_index.find(str);
+    if (itr == timing_index.end()) {
+      itr = (timing_index.insert(std::make_pair(str, time_per_op.size()))).first;
+      time_per_op.push_back(TimeInfo(str,time_per_op.size()));
+    }
+    return time_per_op[itr->second];
+  }
+
+  //Adds the time of the flat timers since the last summary to the flat summary
+  void flattenTimerTree() {
+    if (!isTreeTiming())
+      return;
+    std::vector<Clock::duration> time(timer_names.size(), Clock::duration::zero());
+    std::vector<long> count(timer_names.size(), 0);
+    for (std::size_t i = 1; i < timer_nodes.size(); ++i) {
+      const TimerNode& node = timer_nodes[i];
+      time[node.handle] += node.inclusive;
+      count[node.handle] += node.count;
+    }
+    for (std::size_t h = 0; h < timer_names.size(); ++h) {
+      if (!timer_flat[h] || count[h] == flat_count[h])
+        continue;
+      TimeInfo& info = timeInfo(timer_names[h]);
+      info.time += std::chrono::duration<double>(time[h] - flat_time[h]).count();
+      info.count += count[h] - flat_count[h];
+      flat_time[h] = time[h];
+      flat_count[h] = count[h];
+    }
+  }
 }
 
 namespace pumipic {
@@ -40,6 +150,7 @@ namespace pumipic {
       return;
     }
     verbosity = v;
+    tree_timing = -1;
   }
 
   void EnableTiming() {
@@ -48,6 +159,7 @@ namespace pumipic {
       return;
     }
     enable_timing = 1;
+    tree_timing = -1;
   }
   void DisableTiming() {
     if (time_per_op.size() > 0) {
@@ -55,24 +167,27 @@ namespace pumipic {
       return;
     }
     enable_timing = -1;
+    tree_timing = -1;
   }
 
   void RecordTime(std::string str, double seconds, double prebarrierTime) {
+    if (paused)
+      return;
+    if (isTimeSeriesEnabled())
+      RecordSeries(str, seconds);
+    //Every rank records its measured wait, including the stragglers whose wait is zero
+    if (prebarrierTime >= 0)
+      RecordImbalance(str, prebarrierTime);
     int comm_rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
     if (isTiming()) {
       if (verbosity >= 0) {
-        auto itr = timing_index.find(str);
-        if (itr == timing_index.end()) {
-          itr = (timing_index.insert(std::make_pair(str, time_per_op.size()))).first;
-          time_per_op.push_back(TimeInfo(str,time_per_op.size()));
-        }
-        int index = itr->second;
-        time_per_op[index].time += seconds;
-        ++(time_per_op[index].count);
+        TimeInfo& info = timeInfo(str);
+        info.time += seconds;
+        ++(info.count);
         if (prebarrierTime >= PREBARRIER_TOL) {
-          time_per_op[index].hasPrebarrier = true;
-          time_per_op[index].prebarrier += prebarrierTime;
+          info.hasPrebarrier = true;
+          info.prebarrier += prebarrierTime;
         }
         if (verbosity >= 1) {
           char buffer[1024];
@@ -147,11 +262,32 @@ namespace pumipic {
         len = at_length;
     }
   }
+  //Hardware counters are gathered by the hierarchical timers, sum them over the call tree
+  void appendCounterSummary(std::stringstream& buffer) {
+    std::vector<double> seconds(timer_names.size(), 0);
+    std::vector<long long> counters(timer_names.size() * NUM_HARDWARE_COUNTERS, 0);
+    for (std::size_t i = 1; i < timer_nodes.size(); ++i) {
+      const TimerNode& node = timer_nodes[i];
+      seconds[node.handle] += std::chrono::duration<double>(node.inclusive).count();
+      for (int c = 0; c < NUM_HARDWARE_COUNTERS; ++c)
+        counters[node.handle * NUM_HARDWARE_COUNTERS + c] += node.counters[c];
+    }
+    buffer << "Hardware Counters\n";
+    for (std::size_t h = 0; h < timer_names.size(); ++h) {
+      if (seconds[h] == 0)
+        continue;
+      buffer << timer_names[h] << "  Time " << seconds[h];
+      appendCounters(buffer, counters.data() + h * NUM_HARDWARE_COUNTERS, seconds[h]);
+      buffer << '\n';
+    }
+  }
+
   void SummarizeTime(TimingSortOption sort) {
     int comm_rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
     if (isTiming()) {
       if (verbosity >= 0) {
+        flattenTimerTree();
         int name_length = 9;
         int tt_length = 10;
         int cc_length = 10;
@@ -182,6 +318,8 @@ namespace pumipic {
             buffer <<"  Total Prebarrier=" << time_per_op[index].prebarrier;
           buffer <<'\n';
         }
+        if (hardwareCountersEnabled())
+          appendCounterSummary(buffer);
         fprintf(stderr, "%s\n", buffer.str().c_str());
       }
     }
@@ -200,6 +338,7 @@ namespace pumipic {
     int is_timing = isTiming();
     MPI_Reduce(&is_timing, &total_timing, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
     if (verbosity >= 0) {
+      flattenTimerTree();
       int name_length = 9;
       for (std::size_t index = 0; index < time_per_op.size(); ++index) {
         if (time_per_op[index].str.size() > name_length)
@@ -311,4 +450,130 @@ namespace pumipic {
       }
     }
   }
+
+  int RegisterTimer(const std::string& name, bool flat) {
+    auto itr = timer_handles.find(name);
+    if (itr != timer_handles.end()) {
+      if (flat)
+        timer_flat[itr->second] = 1;
+      return itr->second;
+    }
+    const int handle = timer_names.size();
+    if (timer_stack.capacity() < TIMER_STACK_RESERVE)
+      timer_stack.reserve(TIMER_STACK_RESERVE);
+    timer_names.push_back(name);
+    timer_flat.push_back(flat);
+    flat_time.push_back(Clock::duration::zero());
+    flat_count.push_back(0);
+    timer_handles[name] = handle;
+    return handle;
+  }
+
+  void StartTimer(int handle) {
+    if (paused || !isTreeTiming())
+      return;
+    const int parent = timer_stack.empty() ? 0 : timer_stack.back().node;
+    TimerFrame frame;
+    frame.node = findChild(parent, handle);
+    //Counters enabled while the timer runs are not added to the node
+    frame.counting = pumipic::hardwareCountersEnabled();
+    std::fill(frame.counters, frame.counters + NUM_HARDWARE_COUNTERS, 0);
+    timer_stack.push_back(frame);
+    if (frame.counting)
+      pumipic::ReadHardwareCounters(timer_stack.back().counters);
+    timer_stack.back().start = Clock::now();
+  }
+
+  void StopTimer(int handle) {
+    if (paused || !isTreeTiming())
+      return;
+    const Clock::time_point end = Clock::now();
+    long long end_counters[NUM_HARDWARE_COUNTERS];
+    bool counting = hardwareCountersEnabled();
+    if (counting)
+      ReadHardwareCounters(end_counters);
+    if (timer_stack.empty() || timer_nodes[timer_stack.back().node].handle != handle) {
+      fprintf(stderr, "[ERROR] Timer %s stopped before the timers nested in it\n",
+              (handle >= 0 && handle < (int)timer_names.size()) ? timer_names[handle].c_str()
+              : "unknown");
+      return;
+    }
+    const TimerFrame& frame = timer_stack.back();
+    counting = counting && frame.counting;
+    const Clock::duration elapsed = end - frame.start;
+    TimerNode& node = timer_nodes[frame.node];
+    node.inclusive += elapsed;
+    ++node.count;
+    for (int i = 0; counting && i < NUM_HARDWARE_COUNTERS; ++i)
+      node.counters[i] += end_counters[i] - frame.counters[i];
+    timer_nodes[node.parent].children_time += elapsed;
+    timer_stack.pop_back();
+  }
+
+  void printTimerNode(std::stringstream& buffer, int index, int name_length) {
+    const TimerNode& node = timer_nodes[index];
+    if (index != 0) {
+      const std::string name = std::string(2 * node.depth, ' ') + timer_names[node.handle];
+      const double inclusive = std::chrono::duration<double>(node.inclusive).count();
+      const double exclusive =
+        std::chrono::duration<double>(node.inclusive - node.children_time).count();
+      buffer << name << std::string(name_length - name.size() + 3, ' ')
+             << std::setw(13) << node.count
+             << std::setw(17) << inclusive
+             << std::setw(17) << exclusive
+             << std::setw(17) << inclusive / node.count;
+      if (hardwareCountersEnabled())
+        appendCounters(buffer, node.counters, inclusive);
+      buffer << '\n';
+    }
+    for (std::size_t i = 0; i < node.children.size(); ++i)
+      printTimerNode(buffer, node.children[i], name_length);
+  }
+
+  void SummarizeTimerTree() {
+    if (!isTreeTiming() || timer_nodes.size() == 1)
+      return;
+    if (!timer_stack.empty())
+      fprintf(stderr, "[WARNING] Summarizing timer tree with %lu timers still running\n",
+              timer_stack.size());
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+    std::size_t name_length = 9;
+    for (std::size_t i = 1; i < timer_nodes.size(); ++i) {
+      const std::size_t len = 2 * timer_nodes[i].depth +
+        timer_names[timer_nodes[i].handle].size();
+      name_length = std::max(name_length, len);
+    }
+    std::stringstream buffer;
+    buffer << "Timer Tree Summary " << comm_rank << "\n"
+           << "Operation" << std::string(name_length - 6, ' ')
+           << "   Call Count   Inclusive Time   Exclusive Time     Average Time\n";
+    printTimerNode(buffer, 0, name_length);
+    fprintf(stderr, "%s\n", buffer.str().c_str());
+  }
+
+  void ResetTimerTree() {
+    if (!timer_stack.empty()) {
+      fprintf(stderr, "[ERROR] Cannot reset the timer tree while timers are running\n");
+      return;
+    }
+    timer_nodes.clear();
+    timer_nodes.push_back(TimerNode(-1, -1, -1));
+    std::fill(flat_time.begin(), flat_time.end(), Clock::duration::zero());
+    std::fill(flat_count.begin(), flat_count.end(), 0);
+  }
+
+  void PauseRecording() {
+    ++paused;
+  }
+  void ResumeRecording() {
+    if (paused == 0) {
+      fprintf(stderr, "[ERROR] ResumeRecording called without a matching PauseRecording\n");
+      return;
+    }
+    --paused;
+  }
+  bool isRecordingPaused() {
+    return paused > 0;
+  }
 }
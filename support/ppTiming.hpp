@@ -21,6 +21,15 @@
   To print the accumulated timing information you can call either:
     SummarizeTime() - prints timing info for enabled processes
     SummarizeTimeAcrossProcesses() - prints averaged timing info over all enabled processes
+
+  For timing in hot paths, hierarchical timers avoid building strings on each call:
+    static const int handle = RegisterTimer("name"); - register once, returns a handle
+    ScopedTimer timer(handle); - times the enclosing scope
+  Timers started while another timer is running are nested under it in a call tree.
+  SummarizeTimerTree() prints the inclusive and exclusive time of each node in the tree.
+
+  Trial work that should not appear in the statistics can be hidden with:
+    ScopedPauseRecording pause; - ignores recording in the enclosing scope
 */
 
 namespace pumipic {
@@ -40,13 +49,15 @@ namespace pumipic {
 
   /*
     Adds `seconds` time for the string provided in `str` with optional prebarrier time in: `prebarrierTime`
+    A negative `prebarrierTime` means no prebarrier was measured (what prebarrier() returns when
+    prebarriers are disabled or the step is not sampled)
 
     If verbosity has been set to 1 then a message of the following form is printed:
       <comm_rank> str (seconds) %f
     Or if prebarrierTime is provided:
       <comm_rank> str (seconds) %f pre-barrier (seconds) %f
   */
-  void RecordTime(std::string str, double seconds, double prebarrierTime = 0.0);
+  void RecordTime(std::string str, double seconds, double prebarrierTime = -1.0);
 
   /*
     Allows printing additional info using the timing verbosity. `str` will only be printed if
@@ -73,4 +84,59 @@ namespace pumipic {
     Note: This is a collective call and must be called by every process
   */
   void SummarizeTimeAcrossProcesses(TimingSortOption sort = SORT_ALPHA);
+
+  /*
+    Registers a hierarchical timer and returns its handle
+    Registering the same name again returns the same handle
+    Flat timers are also listed under their name by SummarizeTime and
+      SummarizeTimeAcrossProcesses with their time and calls summed over the call tree
+  */
+  int RegisterTimer(const std::string& name, bool flat = false);
+
+  /*
+    Starts/stops the timer of `handle` as a child of the currently running timer
+    Timers must be stopped in the reverse order they were started
+  */
+  void StartTimer(int handle);
+  void StopTimer(int handle);
+
+  //Starts a timer on construction and stops it when leaving the scope
+  class ScopedTimer {
+  public:
+    explicit ScopedTimer(int handle) : handle_(handle) {StartTimer(handle_);}
+    ~ScopedTimer() {StopTimer(handle_);}
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+  private:
+    int handle_;
+  };
+
+  /*
+    Print the call tree of the hierarchical timers on each process that enabled recording
+    Each node lists the calls, inclusive time (with children) and exclusive time (without)
+  */
+  void SummarizeTimerTree();
+
+  //Clears the time recorded by the hierarchical timers, handles remain valid
+  void ResetTimerTree();
+
+  /*
+    Pauses recording on the calling process until the matching ResumeRecording: RecordTime,
+    the hierarchical timers and RecordSeries ignore calls and no prebarrier step is sampled.
+    Pauses nest. Timers running when the pause begins must be stopped after it ends.
+
+    Note: Ranks that share a prebarrier must pause together
+  */
+  void PauseRecording();
+  void ResumeRecording();
+  bool isRecordingPaused();
+
+  //Pauses recording while in the enclosing scope
+  class ScopedPauseRecording {
+  public:
+    ScopedPauseRecording() {PauseRecording();}
+    ~ScopedPauseRecording() {ResumeRecording();}
+    ScopedPauseRecording(const ScopedPauseRecording&) = delete;
+    ScopedPauseRecording& operator=(const ScopedPauseRecording&) = delete;
+  };
 }
@@ -0,0 +1,207 @@
+#include "ppTrace.hpp"
+#include <Kokkos_Core.hpp>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace {
+  typedef std::chrono::steady_clock Clock;
+  bool tracing = false;
+  bool has_epoch = false;
+  Clock::time_point epoch;
+
+  std::vector<std::string> event_names;
+  std::unordered_map<std::string, int> event_name_index;
+  struct TraceEvent {
+    int name;
+    pumipic::TraceCategory category;
+    double begin; //microseconds since the epoch
+    double end;   //negative until the event ends
+  };
+  std::vector<TraceEvent> events;
+  std::vector<int> open_events;
+  //Open events of Kokkos regions, the region callbacks only end these
+  std::vector<int> open_regions;
+
+  double now() {
+    return std::chrono::duration<double, std::micro>(Clock::now() - epoch).count();
+  }
+
+  int nameIndex(const char* name) {
+    auto itr = event_name_index.find(name);
+    if (itr != event_name_index.end())
+      return itr->second;
+    const int index = event_names.size();
+    event_names.push_back(name);
+    event_name_index[name] = index;
+    return index;
+  }
+
+  void pushRegionCallback(const char* name) {
+    if (!tracing)
+      return;
+    open_regions.push_back(events.size());
+    pumipic::TraceBegin(name, pumipic::TRACE_REGION);
+  }
+  void popRegionCallback() {
+    //Regions pushed before tracing was enabled have no open event
+    if (open_regions.empty())
+      return;
+    const int event = open_regions.back();
+    open_regions.pop_back();
+    if (!open_events.empty() && open_events.back() == event)
+      open_events.pop_back();
+    events[event].end = now();
+  }
+
+  //Regions open when the callbacks are replaced never see their pop, so they are dropped
+  //  instead of ending whichever region is popped next
+  void dropOpenRegions() {
+    for (std::size_t i = 0; i < open_regions.size(); ++i)
+      open_events.erase(std::remove(open_events.begin(), open_events.end(), open_regions[i]),
+                        open_events.end());
+    open_regions.clear();
+  }
+
+  std::string escape(const std::string& str) {
+    std::string escaped;
+    for (std::size_t i = 0; i < str.size(); ++i) {
+      if (str[i] == '"' || str[i] == '\\')
+        escaped += '\\';
+      escaped += str[i];
+    }
+    return escaped;
+  }
+
+  //Appends the events as comma separated JSON objects on the process row `pid`
+  void appendEvents(std::stringstream& out, int pid, double shift) {
+    const char* categories[] = {"region", "mpi"};
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+        << ", \"tid\": 0, \"args\": {\"name\": \"rank " << pid << "\"}}";
+    out.precision(3);
+    out << std::fixed;
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      const TraceEvent& event = events[i];
+      if (event.end < 0)
+        continue;
+      out << ",\n{\"name\": \"" << escape(event_names[event.name])
+          << "\", \"cat\": \"" << categories[event.category]
+          << "\", \"ph\": \"X\", \"ts\": " << event.begin + shift
+          << ", \"dur\": " << event.end - event.begin
+          << ", \"pid\": " << pid << ", \"tid\": 0}";
+    }
+  }
+
+  void writeFile(const std::string& filename, const std::string& events_json) {
+    std::ofstream out(filename.c_str());
+    if (!out) {
+      fprintf(stderr, "[ERROR] Cannot open trace file %s\n", filename.c_str());
+      return;
+    }
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" << events_json << "\n]}\n";
+  }
+}
+
+namespace pumipic {
+
+  void EnableTrace() {
+    if (!has_epoch) {
+      epoch = Clock::now();
+      has_epoch = true;
+    }
+    tracing = true;
+    dropOpenRegions();
+    Kokkos::Tools::Experimental::set_push_region_callback(pushRegionCallback);
+    Kokkos::Tools::Experimental::set_pop_region_callback(popRegionCallback);
+  }
+
+  void DisableTrace() {
+    tracing = false;
+    dropOpenRegions();
+    Kokkos::Tools::Experimental::set_push_region_callback(nullptr);
+    Kokkos::Tools::Experimental::set_pop_region_callback(nullptr);
+  }
+
+  bool isTracing() {
+    return tracing;
+  }
+
+  void TraceBegin(const char* name, TraceCategory category) {
+    if (!tracing)
+      return;
+    TraceEvent event;
+    event.name = nameIndex(name);
+    event.category = category;
+    event.end = -1;
+    open_events.push_back(events.size());
+    events.push_back(event);
+    events.back().begin = now();
+  }
+
+  void TraceEnd() {
+    const double end = now();
+    if (open_events.empty()) {
+      fprintf(stderr, "[ERROR] TraceEnd called without an open trace event\n");
+      return;
+    }
+    events[open_events.back()].end = end;
+    open_events.pop_back();
+  }
+
+  void WriteTrace(const std::string& prefix) {
+    int comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+    std::stringstream json;
+    appendEvents(json, comm_rank, 0);
+    std::stringstream filename;
+    filename << prefix << '_' << comm_rank << ".json";
+    writeFile(filename.str(), json.str());
+  }
+
+  void WriteMergedTrace(const std::string& prefix, MPI_Comm comm) {
+    int comm_rank, comm_size;
+    MPI_Comm_rank(comm, &comm_rank);
+    MPI_Comm_size(comm, &comm_size);
+
+    //Every rank leaves the barrier at nearly the same time, shift the events so those times match
+    MPI_Barrier(comm);
+    const double local_sync = has_epoch ? now() : 0;
+    double root_sync = local_sync;
+    MPI_Bcast(&root_sync, 1, MPI_DOUBLE, 0, comm);
+
+    std::stringstream json;
+    appendEvents(json, comm_rank, root_sync - local_sync);
+    const std::string local = json.str();
+    int length = local.size();
+    std::vector<int> lengths(comm_size), offsets(comm_size + 1, 0);
+    MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+    std::string merged;
+    if (!comm_rank) {
+      for (int i = 0; i < comm_size; ++i)
+        offsets[i + 1] = offsets[i] + lengths[i];
+      merged.resize(offsets[comm_size]);
+    }
+    MPI_Gatherv(local.data(), length, MPI_CHAR, &merged[0], lengths.data(), offsets.data(),
+                MPI_CHAR, 0, comm);
+    if (comm_rank)
+      return;
+
+    std::string events_json;
+    for (int i = 0; i < comm_size; ++i) {
+      if (i > 0)
+        events_json += ",\n";
+      events_json.append(merged, offsets[i], lengths[i]);
+    }
+    writeFile(prefix + ".json", events_json);
+  }
+
+  void ResetTrace() {
+    events.clear();
+    open_events.clear();
+    open_regions.clear();
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <mpi.h>
+
+/*
+  Lightweight tracer that writes Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+
+  Tracing is off by default and is turned on per process with:
+    EnableTrace() - captures Kokkos::Profiling regions and the MPI waits of pumipic
+  Additional events can be traced with:
+    ScopedTrace trace("name"); - traces the enclosing scope
+
+  The captured events are written with either:
+    WriteTrace(prefix) - writes `<prefix>_<rank>.json` on each tracing process
+    WriteMergedTrace(prefix) - writes `<prefix>.json` on rank 0 with one process row per rank
+
+  Note: The Kokkos regions are captured by registering the region callbacks of Kokkos Tools,
+  which replaces the callbacks of a tool library loaded through KOKKOS_TOOLS_LIBS.
+  Kokkos fences the device on each region while the callbacks are set.
+*/
+
+namespace pumipic {
+
+  enum TraceCategory {
+    TRACE_REGION, //Kokkos profiling regions and scoped traces
+    TRACE_MPI     //time blocked in MPI waits and barriers
+  };
+
+  //Turns on tracing on the calling process
+  void EnableTrace();
+  //Turns off tracing on the calling process, the captured events are kept
+  void DisableTrace();
+  bool isTracing();
+
+  //Begin/end an event, events must be ended in the reverse order they began
+  void TraceBegin(const char* name, TraceCategory category = TRACE_REGION);
+  void TraceEnd();
+
+  //Traces the enclosing scope
+  class ScopedTrace {
+  public:
+    explicit ScopedTrace(const char* name, TraceCategory category = TRACE_REGION)
+      : active(isTracing()) {
+      if (active)
+        TraceBegin(name, category);
+    }
+    ~ScopedTrace() {
+      if (active)
+        TraceEnd();
+    }
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+  private:
+    bool active;
+  };
+
+  //Writes the events of the calling process to `<prefix>_<rank>.json`
+  void WriteTrace(const std::string& prefix);
+
+  /*
+    Gathers the events of every rank to rank 0 and writes `<prefix>.json`
+    Timestamps are aligned at a barrier so events of different ranks can be compared
+
+    Note: This is a collective call and must be called by every process
+  */
+  void WriteMergedTrace(const std::string& prefix, MPI_Comm comm = MPI_COMM_WORLD);
+
+  //Clears the captured events
+  void ResetTrace();
+}
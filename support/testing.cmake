@@ -1,3 +1,6 @@
 mpi_test(viewComm_1 1 ./ViewCommTests)
 mpi_test(viewComm_2 2 ./ViewCommTests)
 mpi_test(viewComm_4 4 ./ViewCommTests)
+mpi_test(profiling_1 1 ./ProfilingTests)
+mpi_test(profiling_2 2 ./ProfilingTests)
+mpi_test(profiling_4 4 ./ProfilingTests)
@@ -549,6 +549,7 @@ int main(int argc, char** argv) {
   Omega_h::vtk::write_parallel("pseudoPush_tf", mesh, picparts.dim());
 
   pumipic::SummarizeTime();
+  pumipic::SummarizeTimerTree();
   if (!comm_rank)
     fprintf(stderr, "done\n");
   return 0;
@@ -10,6 +10,8 @@
 #include "ellipticalPush.hpp"
 #include <random>
 #include <ppTiming.hpp>
+#include <ppTimeSeries.hpp>
+#include <ppImbalance.hpp>
 #include "ppMemUsage.hpp"
 #define ELEMENT_SEED 1024*1024
 #define PARTICLE_SEED 512*512
@@ -531,6 +533,7 @@ int main(int argc, char** argv) {
       gyroScatter(mesh,ptcls,forward_map,fwdTagName);
       gyroScatter(mesh,ptcls,backward_map,bkwdTagName);
       gyroSync(picparts,fwdTagName,bkwdTagName,syncTagName);
+      pumipic::NextTimeStep();
     }
     if (comm_rank == 0)
       fprintf(stderr, "%d iterations of pseudopush (seconds) %f\n", iter, fullTimer.seconds());
@@ -540,6 +543,8 @@ int main(int argc, char** argv) {
 
   }
   pumipic::SummarizeTimeAcrossProcesses(pumipic::SORT_ORDER);
+  pumipic::SummarizeTimerTree();
+  pumipic::SummarizeImbalance();
   if (!comm_rank)
     fprintf(stderr, "done\n");
   return 0;
@@ -0,0 +1,175 @@
+#include <Omega_h_file.hpp>  //gmsh
+#include <Omega_h_for.hpp>
+#include <pumipic_mesh.hpp>
+#include <vector>
+
+//Reduces a comm array on every dimension and checks each copy receives its owner's rank
+//  Returns the number of picparts containing each owned element indexed by global serial id
+bool reduceRoundTrip(pumipic::Mesh& picparts, Omega_h::GO nge, std::vector<int>& elm_counts) {
+  const int rank = picparts.comm()->rank();
+  const int dim = picparts.dim();
+  Omega_h::Write<Omega_h::LO> fail(1, 0);
+  for (int d = 0; d <= dim; ++d) {
+    Omega_h::LOs ent_owners = picparts.entOwners(d);
+    Omega_h::Write<Omega_h::LO> owner_comm = picparts.createCommArray(d, 1, INT_MAX);
+    auto setOwned = OMEGA_H_LAMBDA(const Omega_h::LO ent) {
+      if (ent_owners[ent] == rank)
+        owner_comm[ent] = rank;
+    };
+    Omega_h::parallel_for(picparts.nents(d), setOwned, "setOwned");
+    picparts.reduceCommArray(d, pumipic::Mesh::MIN_OP, owner_comm);
+    auto checkOwner = OMEGA_H_LAMBDA(const Omega_h::LO ent) {
+      if (owner_comm[ent] != ent_owners[ent])
+        fail[0] = 1;
+    };
+    Omega_h::parallel_for(picparts.nents(d), checkOwner, "checkOwner");
+  }
+
+  //Count the picparts sharing each element
+  Omega_h::Write<Omega_h::LO> count_comm = picparts.createCommArray(dim, 1, 1);
+  picparts.reduceCommArray(dim, pumipic::Mesh::SUM_OP, count_comm);
+  Omega_h::HostRead<Omega_h::LO> counts_h(count_comm);
+  Omega_h::HostRead<Omega_h::LO> owners_h(picparts.entOwners(dim));
+  Omega_h::HostRead<Omega_h::GO> serial_h(picparts->get_array<Omega_h::GO>(dim, "global_serial"));
+  std::vector<int> local_counts(nge, 0);
+  for (int e = 0; e < counts_h.size(); ++e)
+    if (owners_h[e] == rank)
+      local_counts[serial_h[e]] = counts_h[e];
+  elm_counts.resize(nge);
+  MPI_Allreduce(local_counts.data(), elm_counts.data(), nge, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  return !Omega_h::HostWrite<Omega_h::LO>(fail)[0];
+}
+
+int main(int argc, char** argv) {
+  pumipic::Library pic_lib(&argc, &argv);
+  Omega_h::Library& lib = pic_lib.omega_h_lib();
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+  if (argc != 4) {
+    if (!rank)
+      fprintf(stderr, "Usage: %s <mesh> <# of safe layers> <# of buffer layers>\n", argv[0]);
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  int safe_layers = atoi(argv[2]);
+  int ghost_layers = atoi(argv[3]);
+
+  //**********Load the mesh distributed across the ranks*************//
+  Omega_h::Mesh mesh = Omega_h::read_mesh_file(argv[1], lib.world());
+  int dim = mesh.dim();
+  Omega_h::GO nge = mesh.nglobal_ents(dim);
+  if (!mesh.has_tag(dim, "global")) {
+    if (!rank)
+      fprintf(stderr, "The distributed mesh has no global element numbering\n");
+    return EXIT_FAILURE;
+  }
+
+  const Omega_h_Parting parting = mesh.parting();
+  const Omega_h::LO nelems = mesh.nelems();
+  pumipic::Mesh picparts(mesh, ghost_layers, safe_layers);
+
+  //The caller's mesh keeps its parting and gains no tags
+  int fail = 0;
+  if (mesh.parting() != parting || mesh.nelems() != nelems ||
+      mesh.has_tag(dim, "ownership") || mesh.has_tag(dim, "gids")) {
+    fprintf(stderr, "Construction modified the distributed mesh on rank %d\n", rank);
+    fail = 1;
+  }
+
+  //Constructing again from the same mesh gives the same picpart
+  {
+    pumipic::Mesh again(mesh, ghost_layers, safe_layers);
+    if (again.nelems() != picparts.nelems() ||
+        again.numBuffers(dim) != picparts.numBuffers(dim)) {
+      fprintf(stderr, "Rank %d has %d elements in %d parts on the second construction, "
+              "expected %d elements in %d parts\n", rank, again.nelems(),
+              again.numBuffers(dim), picparts.nelems(), picparts.numBuffers(dim));
+      fail = 1;
+    }
+  }
+
+  //Every element owned by this rank must be safe and have a valid global id
+  Omega_h::LOs owners = picparts.entOwners(dim);
+  Omega_h::LOs safe = picparts.safeTag();
+  Omega_h::GOs gids = picparts.globalIds(dim);
+  Omega_h::Write<Omega_h::LO> fails(1,0);
+  Omega_h::Write<Omega_h::LO> num_owned(1,0);
+  auto checkCore = OMEGA_H_LAMBDA(const Omega_h::LO ent) {
+    if (owners[ent] == rank) {
+      Kokkos::atomic_fetch_add(&(num_owned[0]), 1);
+      if (!safe[ent]) {
+        printf("Core element %d is not safe on rank %d\n", ent, rank);
+        fails[0] = 1;
+      }
+    }
+    if (gids[ent] < 0 || gids[ent] >= nge) {
+      printf("Global id %ld out of range on rank %d\n", gids[ent], rank);
+      fails[0] = 1;
+    }
+  };
+  Omega_h::parallel_for(picparts.nelems(), checkCore, "checkCore");
+
+  //The core regions must cover the mesh exactly once
+  int owned = Omega_h::HostWrite<Omega_h::LO>(num_owned)[0];
+  int total_owned = 0;
+  MPI_Allreduce(&owned, &total_owned, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  fail |= Omega_h::HostWrite<Omega_h::LO>(fails)[0];
+  if (total_owned != nge) {
+    if (!rank)
+      fprintf(stderr, "Core regions cover %d elements, expected %ld\n", total_owned, nge);
+    fail = 1;
+  }
+
+  //Reduce-comm round trip on the distributed picparts
+  std::vector<int> dist_counts;
+  if (!reduceRoundTrip(picparts, nge, dist_counts)) {
+    fprintf(stderr, "Owner reduction failed on the distributed picpart of rank %d\n", rank);
+    fail = 1;
+  }
+
+  //Build the same partition from the serial mesh and compare the reductions
+  Omega_h::HostRead<Omega_h::GO> serial_h(picparts->get_array<Omega_h::GO>(dim,
+                                                                           "global_serial"));
+  Omega_h::HostRead<Omega_h::LO> owners_h(owners);
+  std::vector<int> local_owners(nge, 0);
+  for (int e = 0; e < owners_h.size(); ++e)
+    if (owners_h[e] == rank)
+      local_owners[serial_h[e]] = rank;
+  std::vector<int> serial_owners(nge);
+  MPI_Allreduce(local_owners.data(), serial_owners.data(), nge, MPI_INT, MPI_SUM,
+                MPI_COMM_WORLD);
+  Omega_h::HostWrite<Omega_h::LO> owner_h(nge, "owner_h");
+  for (int e = 0; e < nge; ++e)
+    owner_h[e] = serial_owners[e];
+
+  Omega_h::Mesh serial_mesh = Omega_h::read_mesh_file(argv[1], lib.self());
+  if (!serial_mesh.has_tag(dim, "global"))
+    serial_mesh.add_tag(dim, "global", 1, Omega_h::GOs(nge, 0, 1));
+  pumipic::Input input(serial_mesh, pumipic::Input::PARTITION,
+                       Omega_h::LOs(Omega_h::Write<Omega_h::LO>(owner_h)),
+                       ghost_layers > 0 ? pumipic::Input::BFS : pumipic::Input::MINIMUM,
+                       pumipic::Input::BFS);
+  input.bufferBFSLayers = ghost_layers;
+  input.safeBFSLayers = safe_layers;
+  pumipic::Mesh serial_picparts(input);
+  if (serial_picparts.numBuffers(dim) != picparts.numBuffers(dim)) {
+    fprintf(stderr, "Rank %d has %d buffered parts, constructPICPart has %d\n", rank,
+            picparts.numBuffers(dim), serial_picparts.numBuffers(dim));
+    fail = 1;
+  }
+  std::vector<int> serial_counts;
+  if (!reduceRoundTrip(serial_picparts, nge, serial_counts)) {
+    fprintf(stderr, "Owner reduction failed on the serial picpart of rank %d\n", rank);
+    fail = 1;
+  }
+  for (int e = 0; e < nge; ++e) {
+    if (dist_counts[e] != serial_counts[e]) {
+      if (!rank)
+        fprintf(stderr, "Element %d is in %d distributed picparts and %d serial picparts\n",
+                e, dist_counts[e], serial_counts[e]);
+      fail = 1;
+      break;
+    }
+  }
+  return fail;
+}
@@ -1,9 +1,12 @@
 #include <fstream>
+#include <stdexcept>
 
 #include <Omega_h_file.hpp>
 #include <pumipic_mesh.hpp>
 #include <Omega_h_for.hpp>
 
+void comparePicparts(pumipic::Mesh& picparts, pumipic::Mesh& read_picparts);
+
 int main(int argc, char** argv) {
   pumipic::Library pic_lib(&argc, &argv);
   Omega_h::Library& lib = pic_lib.omega_h_lib();
@@ -43,6 +46,63 @@ int main(int argc, char** argv) {
   pumipic::Mesh read_picparts;
   pumipic::read(&lib, picparts.comm(), argv[5], &read_picparts);
 
+  comparePicparts(picparts, read_picparts);
+
+  //Write and reread the picparts with the memory mapped layout
+  pumipic::writeMappable(picparts, argv[5]);
+  pumipic::Mesh mapped_picparts;
+  pumipic::read(&lib, picparts.comm(), argv[5], &mapped_picparts);
+  comparePicparts(picparts, mapped_picparts);
+
+  //Write and reread the picparts through the single file container
+  pumipic::writeSingleFile(picparts, argv[5]);
+  pumipic::Mesh single_picparts;
+  pumipic::readSingleFile(&lib, picparts.comm(), argv[5], &single_picparts);
+  comparePicparts(picparts, single_picparts);
+
+  //Reread the single file container on half of the ranks
+  if (comm_size > 1 && comm_size % 2 == 0) {
+    const int half_size = comm_size / 2;
+    Omega_h::CommPtr half = picparts.comm()->split(rank / half_size, rank);
+    pumipic::Mesh half_picparts;
+    bool threw = false;
+    try {
+      pumipic::readSingleFile(&lib, half, argv[5], &half_picparts, comm_size);
+    }
+    catch (std::runtime_error&) {
+      threw = true;
+    }
+    //Only picparts buffering the full mesh can be read on a different number of ranks
+    assert(threw != picparts.isFullMesh());
+    if (picparts.isFullMesh()) {
+      assert(half_picparts.comm()->size() == half_size);
+      assert(half_picparts.nelems() == picparts.nelems());
+      //Each reader owns the elements of the contiguous stored parts it was assigned
+      //  and every element of those parts is safe
+      auto owners = picparts.entOwners(dim);
+      auto half_owners = half_picparts.entOwners(dim);
+      auto half_safe = half_picparts.safeTag();
+      const int half_rank = half->rank();
+      Omega_h::Write<Omega_h::LO> failed(1,0);
+      auto checkOwners = OMEGA_H_LAMBDA(const Omega_h::LO elm) {
+        if (half_owners[elm] != owners[elm] / 2)
+          failed[0] = 1;
+        if (half_owners[elm] == half_rank && !half_safe[elm])
+          failed[0] = 1;
+      };
+      Omega_h::parallel_for(picparts.nelems(), checkOwners);
+      Omega_h::HostWrite<Omega_h::LO> failed_h(failed);
+      assert(!failed_h[0]);
+    }
+  }
+
+  if (!rank) {
+    printf("All Tests Passed\n");
+  }
+  return 0;
+}
+
+void comparePicparts(pumipic::Mesh& picparts, pumipic::Mesh& read_picparts) {
   /************Compare picparts vs read_picparts***********/
   //Check basic values
   assert(picparts.isFullMesh() == read_picparts.isFullMesh());
@@ -111,9 +171,4 @@ int main(int argc, char** argv) {
 
   Omega_h::HostWrite<Omega_h::LO> failed_h(failed);
   assert(!failed_h[0]);
-
-  if (!rank) {
-    printf("All Tests Passed\n");
-  }
-  return 0;
 }
@@ -1,4 +1,6 @@
 #include <fstream>
+#include <stdexcept>
+#include <vector>
 
 #include <particle_structs.hpp>
 #include <Omega_h_file.hpp>  //gmsh
@@ -16,6 +18,9 @@ void balancePtcls(pumipic::Mesh& picparts, PS* ptcls, pumipic::ParticleBalancer&
 
 int testBalanceArray(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer);
 int testBalancePS(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer);
+int testScanSelection(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer);
+int testCostWeighting(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer);
+int testBalancePolicy();
 
 int main(int argc, char** argv) {
   pumipic::Library pic_lib(&argc, &argv);
@@ -68,6 +73,9 @@ int main(int argc, char** argv) {
   int fails = 0;
   fails += testBalanceArray(picparts, balancer);
   fails += testBalancePS(picparts, balancer);
+  fails += testScanSelection(picparts, balancer);
+  fails += testCostWeighting(picparts, balancer);
+  fails += testBalancePolicy();
 
   if (!rank && fails == 0) {
     fprintf(stderr, "All Tests Passed\n");
@@ -178,6 +186,223 @@ int testBalancePS(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer)
   return fail;
 }
 
+//Sums the load sent to each rank and returns the imbalance (max / avg) on every rank
+double sentImbalance(Kokkos::View<Omega_h::LO*>::HostMirror new_procs,
+                     const std::vector<double>& ptcl_loads) {
+  int comm_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  std::vector<double> local(comm_size, 0), loads(comm_size);
+  for (size_t i = 0; i < new_procs.size(); ++i)
+    local[new_procs(i)] += ptcl_loads[i];
+  MPI_Allreduce(local.data(), loads.data(), comm_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  double total = 0, max = 0;
+  for (int i = 0; i < comm_size; ++i) {
+    total += loads[i];
+    if (loads[i] > max)
+      max = loads[i];
+  }
+  return max / (total / comm_size);
+}
+
+int testScanSelection(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer) {
+  int rank, comm_size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  if (comm_size == 1)
+    return 0;
+  if (!rank)
+    fprintf(stderr, "Starting test for scan based particle selection\n");
+  const Omega_h::LO ne = picparts->nelems();
+  const Omega_h::LO ppe = (rank + 1) * 50;
+  Kokkos::View<Omega_h::LO*> ptcls_per_elem("ptcls_per_elem", ne);
+  Kokkos::deep_copy(ptcls_per_elem, ppe);
+
+  //The scan selection is deterministic, two partitions of the same load agree
+  balancer.setSelectionMode(pumipic::ParticleBalancer::SCAN_SELECTION);
+  auto first = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(),
+                                                   balancer.partition(picparts, ptcls_per_elem, 1.05));
+  auto second = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(),
+                                                    balancer.partition(picparts, ptcls_per_elem, 1.05));
+  balancer.setSelectionMode(pumipic::ParticleBalancer::ATOMIC_SELECTION);
+  int fail = 0;
+  if (first.size() != (size_t)(ne * ppe) || second.size() != first.size()) {
+    fprintf(stderr, "[ERROR] Scan selection returned %lu particles, expected %d on rank %d\n",
+            (unsigned long)first.size(), ne * ppe, rank);
+    return 1;
+  }
+  for (size_t i = 0; i < first.size(); ++i) {
+    if (first(i) != second(i)) {
+      fprintf(stderr, "[ERROR] Scan selection is not deterministic for particle %lu on rank %d\n",
+              (unsigned long)i, rank);
+      fail = 1;
+      break;
+    }
+  }
+
+  //Particles leave each element in order, so the sent particles are a prefix of the element
+  Omega_h::LO num_sent = 0;
+  for (Omega_h::LO e = 0; e < ne; ++e) {
+    bool kept = false;
+    for (Omega_h::LO j = 0; j < ppe; ++j) {
+      const Omega_h::LO part = first(e * ppe + j);
+      if (part == rank)
+        kept = true;
+      else if (kept) {
+        fprintf(stderr, "[ERROR] Element %d sends particle %d after keeping one on rank %d\n",
+                e, j, rank);
+        fail = 1;
+        break;
+      }
+      else
+        ++num_sent;
+    }
+  }
+
+  //The heaviest rank sends particles and the result is balanced
+  if (rank == comm_size - 1 && num_sent == 0) {
+    fprintf(stderr, "[ERROR] Scan selection sent no particles from the heaviest rank\n");
+    fail = 1;
+  }
+  std::vector<double> ones(first.size(), 1.0);
+  const double imb = sentImbalance(first, ones);
+  if (!rank)
+    fprintf(stderr, "Imbalance after scan selection is %f\n\n", imb);
+  if (imb > 1.3)
+    fail = 1;
+  return fail;
+}
+
+int testCostWeighting(pumipic::Mesh& picparts, pumipic::ParticleBalancer& balancer) {
+  int rank, comm_size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  if (comm_size == 1)
+    return 0;
+  if (!rank)
+    fprintf(stderr, "Starting test for cost weighted balancing\n");
+  const Omega_h::LO ne = picparts->nelems();
+  const Omega_h::LO ppe = 50;
+  Kokkos::View<Omega_h::LO*> ptcls_per_elem("ptcls_per_elem", ne);
+  Kokkos::deep_copy(ptcls_per_elem, ppe);
+
+  //Particles on rank 0 are four times as expensive as everywhere else
+  const Omega_h::Real cost = rank == 0 ? 4.0 : 1.0;
+  std::vector<double> ptcl_costs(ne * ppe, cost);
+  std::vector<double> ones(ne * ppe, 1.0);
+
+  balancer.setSelectionMode(pumipic::ParticleBalancer::SCAN_SELECTION);
+  auto unweighted = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(),
+                                                        balancer.partition(picparts, ptcls_per_elem, 1.05));
+  balancer.setElementCosts(Omega_h::Reals(ne, cost));
+  auto weighted = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(),
+                                                      balancer.partition(picparts, ptcls_per_elem, 1.05));
+  balancer.setElementCosts(Omega_h::Reals());
+  balancer.setSelectionMode(pumipic::ParticleBalancer::ATOMIC_SELECTION);
+
+  //The expensive rank keeps fewer particles once costs are balanced
+  int fail = 0;
+  Omega_h::LO kept_unweighted = 0, kept_weighted = 0;
+  for (size_t i = 0; i < weighted.size(); ++i) {
+    kept_unweighted += unweighted(i) == rank;
+    kept_weighted += weighted(i) == rank;
+  }
+  if (rank == 0 && kept_weighted >= kept_unweighted) {
+    fprintf(stderr, "[ERROR] Rank 0 keeps %d particles with costs and %d without\n",
+            kept_weighted, kept_unweighted);
+    fail = 1;
+  }
+
+  //The cost imbalance improves on the count based partition
+  Kokkos::View<Omega_h::LO*>::HostMirror stay("stay", ne * ppe);
+  Kokkos::deep_copy(stay, rank);
+  const double imb_start = sentImbalance(stay, ptcl_costs);
+  const double imb_unweighted = sentImbalance(unweighted, ptcl_costs);
+  const double imb_weighted = sentImbalance(weighted, ptcl_costs);
+  if (!rank)
+    fprintf(stderr, "Cost imbalance <start, count balanced, cost balanced>: %f %f %f\n\n",
+            imb_start, imb_unweighted, imb_weighted);
+  if (imb_weighted >= imb_start || imb_weighted > imb_unweighted)
+    fail = 1;
+  return fail;
+}
+
+int testBalancePolicy() {
+  int rank, comm_size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  if (!rank)
+    fprintf(stderr, "Starting test for the balance policy\n");
+  int fail = 0;
+  MPI_Comm comm = MPI_COMM_WORLD;
+
+  //A trigger below the target is rejected
+  bool thrown = false;
+  try {
+    pumipic::BalancePolicy invalid(1.2, 1.1);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  if (!thrown) {
+    fprintf(stderr, "[ERROR] BalancePolicy accepted a trigger below the target\n");
+    fail = 1;
+  }
+
+  //A balanced load never starts balancing
+  pumipic::BalancePolicy policy(1.05, 1.2, 1, false);
+  if (policy.shouldBalance(comm, 100) || policy.imbalance() != 1.0) {
+    fprintf(stderr, "[ERROR] BalancePolicy balances a balanced load\n");
+    fail = 1;
+  }
+  if (comm_size == 1)
+    return fail;
+
+  //Balancing starts above the trigger, continues above the target and stops below it
+  //  heavy makes an imbalance of (comm_size + 1) / 2 and mid one just above 1.1
+  const int heavy = 100 * comm_size + 100;
+  const int mid = (int)(110 * (comm_size - 1) / (comm_size - 1.1)) + 1;
+  const int loads[5] = {heavy, mid, 100, mid, heavy};
+  const bool expected[5] = {true, true, false, false, true};
+  for (int i = 0; i < 5; ++i) {
+    const bool balance = policy.shouldBalance(comm, rank == 0 ? loads[i] : 100);
+    if (balance != expected[i]) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] Step %d with imbalance %f balances %d, expected %d\n", i,
+                policy.imbalance(), balance, expected[i]);
+      fail = 1;
+    }
+  }
+  if (policy.numSteps() != 6 || policy.numBalanceSteps() != 3) {
+    if (!rank)
+      fprintf(stderr, "[ERROR] BalancePolicy counted %d balance steps of %d\n",
+              policy.numBalanceSteps(), policy.numSteps());
+    fail = 1;
+  }
+
+  //Only every third step is checked when not balancing
+  pumipic::BalancePolicy interval_policy(1.05, 1.2, 3, false);
+  const bool interval_expected[4] = {false, false, false, true};
+  for (int i = 0; i < 4; ++i) {
+    const int nptcls = (i == 0 || rank != 0) ? 100 : heavy;
+    if (interval_policy.shouldBalance(comm, nptcls) != interval_expected[i]) {
+      if (!rank)
+        fprintf(stderr, "[ERROR] Interval policy step %d does not match\n", i);
+      fail = 1;
+    }
+  }
+
+  //The predicted load of the particles gained in the last migration triggers balancing
+  pumipic::BalancePolicy predict_policy(1.05, 1.2, 1, true);
+  predict_policy.recordMigration(100, rank == 0 ? heavy : 100);
+  if (!predict_policy.shouldBalance(comm, 100)) {
+    if (!rank)
+      fprintf(stderr, "[ERROR] Predicted imbalance %f did not trigger balancing\n",
+              predict_policy.imbalance());
+    fail = 1;
+  }
+  return fail;
+}
+
 void balancePtcls(pumipic::Mesh& picparts, PS* ptcls, pumipic::ParticleBalancer& balancer) {
   int comm_rank = picparts.comm()->rank();
   const int ps_capacity = ptcls->capacity();
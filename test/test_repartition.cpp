@@ -0,0 +1,138 @@
+#include <fstream>
+
+#include <particle_structs.hpp>
+#include <Omega_h_file.hpp>  //gmsh
+#include <pumipic_mesh.hpp>
+#include <Omega_h_for.hpp>
+#include <pumipic_ptcl_ops.hpp>
+#include "team_policy.hpp"
+
+//The full mesh element each particle was created in
+typedef pumipic::MemberTypes<int> Particle;
+typedef pumipic::ParticleStructure<Particle> PS;
+
+PS* createPS(pumipic::lid_t ne, pumipic::lid_t np, PS::kkLidView ptcls_per_elem,
+             PS::kkGidView element_gids, PS::kkLidView ptcl_elems = PS::kkLidView(),
+             PS::MTVs ptcl_info = NULL) {
+  const int sigma = INT_MAX; // full sorting
+  const int V = 1024;
+  const int C = 32;
+  Kokkos::TeamPolicy<Kokkos::DefaultExecutionSpace> policy = pumipic::TeamPolicyAuto(10000, C);
+  return new pumipic::SellCSigma<Particle>(policy, sigma, V, ne, np, ptcls_per_elem,
+                                           element_gids, ptcl_elems, ptcl_info);
+}
+
+double printImb(PS* ptcls) {
+  int np = ptcls->nPtcls();
+  int max_p, tot_p;
+  MPI_Allreduce(&np, &max_p, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(&np, &tot_p, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  int comm_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  double imb = max_p / (tot_p * 1.0 / comm_size);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (!rank)
+    fprintf(stderr, "Particles <total, max, imb>: %d %d %f\n", tot_p, max_p, imb);
+  return imb;
+}
+
+int main(int argc, char** argv) {
+  pumipic::Library pic_lib(&argc, &argv);
+  Omega_h::Library& lib = pic_lib.omega_h_lib();
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+  if (argc != 3) {
+    if (!rank)
+      fprintf(stderr, "Usage: %s <mesh> <partition filename>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  int comm_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+  //**********Load the mesh in serial everywhere*************//
+  Omega_h::Mesh mesh = Omega_h::read_mesh_file(argv[1], lib.self());
+  int dim = mesh.dim();
+  int ne = mesh.nents(dim);
+
+  Omega_h::HostWrite<Omega_h::LO> host_owners(ne);
+  std::ifstream in_str(argv[2]);
+  if (!in_str) {
+    if (!rank)
+      fprintf(stderr,"Cannot open file %s\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+  int own;
+  int index = 0;
+  while(in_str >> own)
+    host_owners[index++] = own;
+  Omega_h::Write<Omega_h::LO> owner(host_owners);
+  const int buffer_layers = 3;
+  const int safe_layers = 1;
+  pumipic::Mesh picparts(mesh, owner, buffer_layers, safe_layers);
+
+  //Create 100 particles per core element on even ranks only
+  Omega_h::LOs owners = picparts.entOwners(dim);
+  PS::kkLidView ptcls_per_elem("ptcls_per_elem", picparts.nelems());
+  PS::kkGidView element_gids("element_gids", picparts.nelems());
+  Omega_h::GOs mesh_element_gids = picparts.globalIds(dim);
+  const int ppe = rank % 2 == 0 ? 100 : 0;
+  Omega_h::parallel_for(picparts.nelems(), OMEGA_H_LAMBDA(const int& i) {
+    ptcls_per_elem(i) = owners[i] == rank ? ppe : 0;
+    element_gids(i) = mesh_element_gids[i];
+  });
+  int num_ptcls = 0;
+  Kokkos::parallel_reduce(picparts.nelems(), KOKKOS_LAMBDA(const int i, int& sum) {
+    sum += ptcls_per_elem(i);
+  }, num_ptcls);
+  PS* ptcls = createPS(picparts.nelems(), num_ptcls, ptcls_per_elem, element_gids);
+
+  Omega_h::LOs full_elems = pumipic::fullMeshElements(picparts, mesh);
+  auto full_elem = ptcls->get<0>();
+  auto setFullElem = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+    if (mask)
+      full_elem(ptcl) = full_elems[elm];
+  };
+  pumipic::parallel_for(ptcls, setFullElem, "setFullElem");
+  int start_ptcls = ptcls->nPtcls();
+  MPI_Allreduce(MPI_IN_PLACE, &start_ptcls, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  printImb(ptcls);
+
+  //Repartition from the particle density
+  Omega_h::Write<Omega_h::Real> density(picparts.nelems(), 0);
+  pumipic::accumulate_ptcl_density(ptcls, density);
+  ptcls = pumipic::repartition_ptcls(picparts, mesh, ptcls, Omega_h::Reals(density),
+                                     buffer_layers, safe_layers, createPS);
+
+  int fails = 0;
+  int end_ptcls = ptcls->nPtcls();
+  MPI_Allreduce(MPI_IN_PLACE, &end_ptcls, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (end_ptcls != start_ptcls) {
+    if (!rank)
+      fprintf(stderr, "Particle count changed from %d to %d\n", start_ptcls, end_ptcls);
+    ++fails;
+  }
+
+  //Every particle must be in a core element that is the element it was created in
+  Omega_h::LOs new_owners = picparts.entOwners(dim);
+  Omega_h::LOs new_full_elems = pumipic::fullMeshElements(picparts, mesh);
+  Omega_h::Write<Omega_h::LO> bad(1, 0);
+  full_elem = ptcls->get<0>();
+  auto checkPtcls = PS_LAMBDA(const int elm, const int ptcl, const bool mask) {
+    if (mask && (new_owners[elm] != rank || new_full_elems[elm] != full_elem(ptcl)))
+      bad[0] = 1;
+  };
+  pumipic::parallel_for(ptcls, checkPtcls, "checkPtcls");
+  if (Omega_h::HostWrite<Omega_h::LO>(bad)[0]) {
+    fprintf(stderr, "Particles are in the wrong element on rank %d\n", rank);
+    ++fails;
+  }
+
+  double imb = printImb(ptcls);
+  if (imb > 1.5)
+    ++fails;
+  delete ptcls;
+  if (!rank && fails == 0)
+    fprintf(stderr, "All Tests Passed\n");
+  return fails;
+}
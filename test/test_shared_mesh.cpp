@@ -0,0 +1,126 @@
+#include <Omega_h_file.hpp>
+#include <Omega_h_for.hpp>
+#include <pumipic_mesh.hpp>
+#include <vector>
+
+int main(int argc, char** argv) {
+  pumipic::Library pic_lib(&argc, &argv);
+  Omega_h::Library& lib = pic_lib.omega_h_lib();
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+  if (argc != 3) {
+    if (!rank)
+      fprintf(stderr, "Usage: %s <mesh> <partition filename>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Omega_h::Mesh mesh = Omega_h::read_mesh_file(argv[1], lib.self());
+  const int dim = mesh.dim();
+  const Omega_h::LO ne = mesh.nelems();
+  Omega_h::Reals coords = mesh.coords();
+
+  int fails = 0;
+  int node_rank = 0;
+  {
+    //Full buffer with a BFS safe zone so the safe tag differs on every rank
+    pumipic::Input input(mesh, argv[2], pumipic::Input::FULL, pumipic::Input::BFS);
+    input.shareFullMesh = true;
+    pumipic::Mesh picparts(input);
+    if (!picparts.isNodeShared()) {
+      if (!rank)
+        printf("Node shared memory is not available, skipping\n");
+      return 0;
+    }
+    if (picparts.mesh() == &mesh) {
+      fprintf(stderr, "[ERROR] The shared picpart aliases the input mesh on rank %d\n", rank);
+      ++fails;
+    }
+
+    //The shared coordinates match the input
+    Omega_h::Reals shared_coords = picparts->coords();
+    Omega_h::Write<Omega_h::LO> coord_fails(1, 0);
+    Omega_h::parallel_for(coords.size(), OMEGA_H_LAMBDA(const Omega_h::LO i) {
+      if (coords[i] != shared_coords[i])
+        coord_fails[0] = 1;
+    }, "checkCoords");
+    if (Omega_h::HostWrite<Omega_h::LO>(coord_fails)[0]) {
+      fprintf(stderr, "[ERROR] Shared coordinates differ on rank %d\n", rank);
+      ++fails;
+    }
+
+    //Every core element is safe, so each rank must see its own safe zone
+    Omega_h::LOs safe = picparts.safeTag();
+    Omega_h::LOs owners = picparts.entOwners(dim);
+    Omega_h::Write<Omega_h::LO> unsafe_core(1, 0);
+    Omega_h::Write<Omega_h::GO> safe_hash(1, 0);
+    Omega_h::parallel_for(ne, OMEGA_H_LAMBDA(const Omega_h::LO e) {
+      if (owners[e] == rank && !safe[e])
+        unsafe_core[0] = 1;
+      if (safe[e])
+        Kokkos::atomic_add(&(safe_hash[0]), (Omega_h::GO)(e + 1) * (e + 1));
+    }, "checkSafe");
+    if (Omega_h::HostWrite<Omega_h::LO>(unsafe_core)[0]) {
+      fprintf(stderr, "[ERROR] Core elements are not safe on rank %d\n", rank);
+      ++fails;
+    }
+
+    //The safe zones of the ranks on this node differ from each other
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    int node_size;
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm_rank(node_comm, &node_rank);
+    long hash = Omega_h::HostWrite<Omega_h::GO>(safe_hash)[0];
+    std::vector<long> hashes(node_size);
+    MPI_Allgather(&hash, 1, MPI_LONG, hashes.data(), 1, MPI_LONG, node_comm);
+    for (int i = 0; i < node_size; ++i)
+      for (int j = i + 1; j < node_size; ++j)
+        if (hashes[i] == hashes[j]) {
+          fprintf(stderr, "[ERROR] Node ranks %d and %d have the same safe zone\n", i, j);
+          ++fails;
+        }
+
+    //Every rank on the node reads the same shared connectivity buffers
+    Omega_h::LOs elm2verts = picparts->ask_down(dim, 0).ab2b;
+    Omega_h::LOs dual = picparts->ask_dual().ab2b;
+    Omega_h::Write<Omega_h::GO> conn_hash(1, 0);
+    Omega_h::parallel_for(elm2verts.size(), OMEGA_H_LAMBDA(const Omega_h::LO i) {
+      Kokkos::atomic_add(&(conn_hash[0]), (Omega_h::GO)(i + 1) * (elm2verts[i] + 1));
+    }, "hashConnectivity");
+    long buffer[4] = {coords.size(), elm2verts.size(), dual.size(),
+                      Omega_h::HostWrite<Omega_h::GO>(conn_hash)[0]};
+    long leader_buffer[4] = {buffer[0], buffer[1], buffer[2], buffer[3]};
+    MPI_Bcast(leader_buffer, 4, MPI_LONG, 0, node_comm);
+    for (int i = 0; i < 4; ++i)
+      if (buffer[i] != leader_buffer[i]) {
+        fprintf(stderr, "[ERROR] Shared buffer %d differs from the node leader on rank %d\n",
+                i, rank);
+        ++fails;
+      }
+    MPI_Comm_free(&node_comm);
+  }
+
+  //The input mesh is released on all but the first rank of the node
+  if (node_rank != 0) {
+    if (mesh.nverts() != 0) {
+      fprintf(stderr, "[ERROR] The input mesh was not released on rank %d\n", rank);
+      ++fails;
+    }
+    return fails;
+  }
+
+  //The input mesh of the node leader is still valid after the shared picparts are destroyed
+  Omega_h::HostRead<Omega_h::Real> coords_h(coords);
+  Omega_h::HostRead<Omega_h::Real> coords_after_h(mesh.coords());
+  bool same = coords_after_h.size() == coords_h.size();
+  for (int i = 0; same && i < coords_h.size(); ++i)
+    same = coords_after_h[i] == coords_h[i];
+  if (!same) {
+    fprintf(stderr, "[ERROR] The input mesh coordinates changed on rank %d\n", rank);
+    ++fails;
+  }
+
+  if (fails == 0 && rank == 0)
+    printf("All tests passed\n");
+  return fails;
+}
@@ -37,9 +37,15 @@ mpi_test(ptn_loading_2d_box_4 4
 mpi_test(full_mesh_pisces 4
   ./full_mesh ${TEST_DATA_DIR}/pisces/gitr.msh testing_pisces_4.ptn)
 
+mpi_test(shared_mesh_cube_4 4
+  ./shared_mesh ${TEST_DATA_DIR}/cube.msh testing_cube_4.ptn)
+
 mpi_test(input_construct_cube 4
   ./input_construct ${TEST_DATA_DIR}/cube.msh testing_cube_4.ptn)
 
+mpi_test(dist_construct_cube 4
+  ./dist_construct ${TEST_DATA_DIR}/cube.msh 1 3)
+
 mpi_test(comm_array_pisces 4
   ./comm_array ${TEST_DATA_DIR}/pisces/gitr.msh testing_pisces_4.ptn)
 
@@ -52,6 +58,12 @@ mpi_test(file_rw_cube_4 4
   testing_cube_4.ptn
   bfs full
   test_cube_file)
+mpi_test(file_rw_cube_full_4 4
+  ./file_rw
+  ${TEST_DATA_DIR}/cube.msh
+  testing_cube_4.ptn
+  full bfs
+  test_cube_full_file)
 mpi_test(file_rw_xgc_24k_1 1
   ./file_rw
   ${TEST_DATA_DIR}/xgc/24k.osh
@@ -86,6 +98,10 @@ mpi_test(lb_r4 4 ./test_lb
          ${TEST_DATA_DIR}/cube.msh
          testing_cube_4.ptn)
 
+mpi_test(repartition_cube_4 4 ./repartition
+         ${TEST_DATA_DIR}/cube.msh
+         testing_cube_4.ptn)
+
 #reverse classification tests
 if(OMEGA_HAS_REVCLASS)
   mpi_test(revClass_r1 1 ./test_revClass